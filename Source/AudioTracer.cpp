@@ -0,0 +1,206 @@
+/*
+  ==============================================================================
+
+    AudioTracer.cpp
+
+  ==============================================================================
+*/
+
+#include "AudioTracer.h"
+
+namespace
+{
+    // unique across every tracer in the process, the thread caches below are shared by all of them
+    std::atomic<juce::uint64> nextSession{ 1 };
+
+    struct CachedRing
+    {
+        juce::uint64 session = 0;
+        void* ring = nullptr;
+    };
+
+    // enough for a few plugin instances recording at once; a miss only costs a claim
+    thread_local std::array<CachedRing, 4> threadRings;
+    thread_local size_t nextThreadRing = 0;
+}
+
+AudioTracer::AudioTracer() : juce::Thread("Audio tracer")
+{
+}
+
+AudioTracer::~AudioTracer()
+{
+    stop();
+}
+
+uint16_t AudioTracer::addName(const juce::String& name)
+{
+    jassert(! isRecording());
+
+    names.push_back(name);
+    return static_cast<uint16_t>(names.size() - 1);
+}
+
+bool AudioTracer::start(const juce::File& file)
+{
+    stop();
+
+    auto newStream = std::make_unique<juce::FileOutputStream>(file);
+
+    if (! newStream->openedOk())
+        return false;
+
+    newStream->setPosition(0);
+    newStream->truncate();
+    newStream->writeText("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", false, false, nullptr);
+
+    stream = std::move(newStream);
+    firstEvent = true;
+
+    for (auto& ring : rings)
+    {
+        // allocated once and kept: a thread that saw the last recording still running may be mid-write
+        if (ring.events.empty())
+            ring.events.resize(eventsPerThread);
+
+        ring.writeIndex.store(0, std::memory_order_relaxed);
+        ring.readIndex.store(0, std::memory_order_relaxed);
+        ring.named = false;
+        ring.claimed.store(false, std::memory_order_release);
+    }
+
+    dropped.store(0, std::memory_order_relaxed);
+    session.store(nextSession.fetch_add(1), std::memory_order_release);
+    recording.store(true, std::memory_order_release);
+
+    startThread(juce::Thread::Priority::low);
+    return true;
+}
+
+void AudioTracer::stop()
+{
+    if (! recording.exchange(false))
+        return;
+
+    stopThread(-1);
+    drain();
+
+    stream->writeText("\n],\"otherData\":{\"droppedEvents\":" + juce::String(getNumDropped()) + "}}\n",
+                      false, false, nullptr);
+    stream->flush();
+    stream.reset();
+}
+
+AudioTracer::Ring* AudioTracer::getRing() noexcept
+{
+    auto current = session.load(std::memory_order_acquire);
+
+    for (auto& cached : threadRings)
+        if (cached.session == current)
+            return static_cast<Ring*>(cached.ring);
+
+    for (auto& ring : rings)
+    {
+        auto expected = false;
+
+        if (ring.claimed.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+        {
+            threadRings[nextThreadRing] = { current, &ring };
+            nextThreadRing = (nextThreadRing + 1) % threadRings.size();
+            return &ring;
+        }
+    }
+
+    return nullptr;
+}
+
+void AudioTracer::push(Phase phase, uint16_t name, int32_t arg) noexcept
+{
+    if (! recording.load(std::memory_order_relaxed))
+        return;
+
+    auto ticks = juce::Time::getHighResolutionTicks();
+    auto* ring = getRing();
+
+    if (ring == nullptr)
+    {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    auto write = ring->writeIndex.load(std::memory_order_relaxed);
+
+    if (write - ring->readIndex.load(std::memory_order_acquire) >= eventsPerThread)
+    {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    ring->events[write & (eventsPerThread - 1)] = { ticks, name, phase, arg };
+    ring->writeIndex.store(write + 1, std::memory_order_release);
+}
+
+void AudioTracer::run()
+{
+    while (! threadShouldExit())
+    {
+        wait(flushIntervalMs);
+        drain();
+    }
+}
+
+void AudioTracer::drain()
+{
+    static constexpr const char* phases[] = { "B", "E", "i" };
+
+    juce::String text;
+
+    auto append = [this, &text](const juce::String& event)
+        {
+            text << (firstEvent ? "" : ",\n") << event;
+            firstEvent = false;
+        };
+
+    for (size_t r = 0; r < rings.size(); ++r)
+    {
+        auto& ring = rings[r];
+
+        if (! ring.claimed.load(std::memory_order_acquire))
+            continue;
+
+        auto tid = juce::String(r + 1);
+
+        if (! ring.named)
+        {
+            append("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + tid
+                   + ",\"args\":{\"name\":\"Audio thread " + tid + "\"}}");
+            ring.named = true;
+        }
+
+        auto read = ring.readIndex.load(std::memory_order_relaxed);
+        auto write = ring.writeIndex.load(std::memory_order_acquire);
+
+        for (; read != write; ++read)
+        {
+            auto& event = ring.events[read & (eventsPerThread - 1)];
+            auto micros = juce::Time::highResolutionTicksToSeconds(event.ticks) * 1.0e6;
+
+            auto json = "{\"name\":" + juce::JSON::toString(juce::var(names[event.name]))
+                      + ",\"ph\":\"" + phases[event.phase] + "\",\"ts\":" + juce::String(micros, 3)
+                      + ",\"pid\":1,\"tid\":" + tid;
+
+            if (event.phase == Instant)
+                json << ",\"s\":\"t\"";
+
+            if (event.arg != 0)
+                json << ",\"args\":{\"value\":" << event.arg << "}";
+
+            append(json + "}");
+        }
+
+        ring.readIndex.store(read, std::memory_order_release);
+    }
+
+    if (text.isNotEmpty() && stream != nullptr)
+        stream->writeText(text, false, false, nullptr);
+}
@@ -0,0 +1,110 @@
+/*
+  ==============================================================================
+
+    AudioTracer.h
+
+    Opt-in timeline of what the audio thread spends its time on, written as
+    a Chrome trace (chrome://tracing, ui.perfetto.dev).
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+    Names are registered up front and events refer to them by index, so an
+    event is 16 bytes: timestamp, name, phase (begin / end / instant) and one
+    integer argument. Writing one is an atomic load while not recording, and
+    otherwise a store into the calling thread's own single-producer ring -
+    no locks, allocation or formatting. A thread claims one of maxThreads
+    rings the first time it writes (a host may call processBlock from more
+    than one thread); once they are all taken, or a ring is full, events are
+    dropped and counted.
+
+    While recording, a background thread drains the rings every
+    flushIntervalMs and appends JSON to the file. Timestamps are
+    juce::Time high resolution ticks in microseconds, the same monotonic
+    clock most host profilers use, so the file can be loaded next to a
+    host trace.
+*/
+class AudioTracer : private juce::Thread
+{
+public:
+    static constexpr int maxThreads = 8;
+    static constexpr size_t eventsPerThread = 1 << 15;
+    static constexpr int flushIntervalMs = 20;
+
+    AudioTracer();
+    ~AudioTracer() override;
+
+    // message thread, before the first start()
+    uint16_t addName(const juce::String& name);
+
+    // message thread: false if the file can't be written
+    bool start(const juce::File& file);
+    void stop();
+
+    bool isRecording() const noexcept { return recording.load(std::memory_order_relaxed); }
+    juce::uint64 getNumDropped() const noexcept { return dropped.load(std::memory_order_relaxed); }
+
+    // any thread
+    void begin(uint16_t name, int32_t arg = 0) noexcept { push(Begin, name, arg); }
+    void end(uint16_t name) noexcept { push(End, name, 0); }
+    void instant(uint16_t name, int32_t arg = 0) noexcept { push(Instant, name, arg); }
+
+    // begin() now, end() when it goes out of scope
+    struct Scope
+    {
+        Scope(AudioTracer& t, uint16_t n, int32_t arg = 0) noexcept : tracer(t), name(n) { tracer.begin(name, arg); }
+        ~Scope() { tracer.end(name); }
+
+        AudioTracer& tracer;
+        const uint16_t name;
+
+        JUCE_DECLARE_NON_COPYABLE(Scope)
+    };
+
+private:
+    enum Phase : uint8_t { Begin, End, Instant };
+
+    struct Event
+    {
+        juce::int64 ticks;
+        uint16_t name;
+        uint8_t phase;
+        int32_t arg;
+    };
+
+    struct Ring
+    {
+        std::atomic<bool> claimed{ false };
+        std::atomic<size_t> writeIndex{ 0 }, readIndex{ 0 };
+        std::vector<Event> events;
+
+        // writer thread only
+        bool named = false;
+    };
+
+    void push(Phase phase, uint16_t name, int32_t arg) noexcept;
+    Ring* getRing() noexcept;
+
+    void run() override;
+    void drain();
+
+    std::array<Ring, maxThreads> rings;
+
+    std::atomic<bool> recording{ false };
+
+    // tells a thread its cached ring belongs to an earlier recording
+    std::atomic<juce::uint64> session{ 0 };
+
+    std::atomic<juce::uint64> dropped{ 0 };
+
+    std::vector<juce::String> names;
+    std::unique_ptr<juce::FileOutputStream> stream;
+    bool firstEvent = true;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioTracer)
+};
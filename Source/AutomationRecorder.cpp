@@ -0,0 +1,302 @@
+/*
+  ==============================================================================
+
+    AutomationRecorder.cpp
+
+  ==============================================================================
+*/
+
+#include "AutomationRecorder.h"
+
+namespace
+{
+    uint32_t toBits(float value) noexcept
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+}
+
+AutomationRecorder::AutomationRecorder() : juce::Thread("Automation recorder")
+{
+}
+
+AutomationRecorder::~AutomationRecorder()
+{
+    stop();
+}
+
+void AutomationRecorder::setParameters(const juce::Array<juce::AudioProcessorParameter*>& newParameters)
+{
+    jassert(! isRecording());
+
+    parameters.assign(newParameters.begin(), newParameters.end());
+    lastValues.assign(parameters.size(), 0.f);
+}
+
+bool AutomationRecorder::start(const juce::File& file, double sampleRate, const juce::MemoryBlock& initialState)
+{
+    stop();
+
+    auto newStream = std::make_unique<juce::FileOutputStream>(file);
+
+    if (! newStream->openedOk())
+        return false;
+
+    newStream->setPosition(0);
+    newStream->truncate();
+
+    newStream->writeInt(magic);
+    newStream->writeInt(version);
+    newStream->writeDouble(sampleRate);
+    newStream->writeInt(static_cast<int>(parameters.size()));
+
+    for (auto* parameter : parameters)
+    {
+        auto* hosted = dynamic_cast<juce::HostedAudioProcessorParameter*>(parameter);
+        newStream->writeString(hosted != nullptr ? hosted->getParameterID() : juce::String());
+    }
+
+    {
+        const juce::ScopedLock lock(streamLock);
+        stream = std::move(newStream);
+        writeRecord({ 0, State, 0, static_cast<uint32_t>(initialState.getSize()) });
+        stream->write(initialState.getData(), initialState.getSize());
+    }
+
+    // allocated by the first recording and kept, like the tracer's rings: most instances never record
+    if (ring.empty())
+        ring.resize(ringSize);
+
+    // anything a block still running from the last recording pushed
+    readIndex.store(writeIndex.load(std::memory_order_acquire), std::memory_order_relaxed);
+
+    dropped.store(0, std::memory_order_relaxed);
+    nextBlockPosition.store(0, std::memory_order_relaxed);
+    session.fetch_add(1, std::memory_order_release);
+    recording.store(true, std::memory_order_release);
+
+    startThread(juce::Thread::Priority::low);
+    return true;
+}
+
+void AutomationRecorder::stop()
+{
+    if (! recording.exchange(false))
+        return;
+
+    stopThread(-1);
+    drain();
+
+    const juce::ScopedLock lock(streamLock);
+
+    writeRecord({ nextBlockPosition.load(), End, 0, static_cast<uint32_t>(getNumDropped()) });
+    stream->flush();
+    stream.reset();
+}
+
+bool AutomationRecorder::beginBlock(int numSamples, int governorLevel) noexcept
+{
+    blockRecording = recording.load(std::memory_order_acquire);
+
+    if (! blockRecording)
+        return false;
+
+    auto current = session.load(std::memory_order_acquire);
+    auto first = current != activeSession;
+
+    if (first)
+    {
+        activeSession = current;
+        position = 0;
+        lastTempo = 0.f;
+    }
+
+    blockStart = position;
+    position += numSamples;
+    nextBlockPosition.store(position, std::memory_order_relaxed);
+
+    push(Block, blockStart, static_cast<size_t>(governorLevel), static_cast<uint32_t>(numSamples));
+
+    if (first)
+    {
+        for (size_t i = 0; i < parameters.size(); ++i)
+        {
+            lastValues[i] = parameters[i]->getValue();
+            push(Parameter, blockStart, i, toBits(lastValues[i]));
+        }
+    }
+
+    return first;
+}
+
+void AutomationRecorder::pollParameters(int offset) noexcept
+{
+    if (! blockRecording)
+        return;
+
+    for (size_t i = 0; i < parameters.size(); ++i)
+    {
+        auto value = parameters[i]->getValue();
+
+        if (value != lastValues[i])
+        {
+            lastValues[i] = value;
+            push(Parameter, blockStart + offset, i, toBits(value));
+        }
+    }
+}
+
+void AutomationRecorder::recordOrderSlot(size_t slot, int option) noexcept
+{
+    if (blockRecording)
+        push(Order, blockStart, slot, static_cast<uint32_t>(option));
+}
+
+void AutomationRecorder::recordTempo(double bpm) noexcept
+{
+    auto tempo = static_cast<float>(bpm);
+
+    if (! blockRecording || tempo == lastTempo)
+        return;
+
+    lastTempo = tempo;
+    push(Tempo, blockStart, 0, toBits(tempo));
+}
+
+void AutomationRecorder::recordState(const void* data, int sizeInBytes)
+{
+    if (! isRecording())
+        return;
+
+    const juce::ScopedLock lock(streamLock);
+
+    if (stream == nullptr)
+        return;
+
+    writeRecord({ nextBlockPosition.load(std::memory_order_relaxed), State, 0, static_cast<uint32_t>(sizeInBytes) });
+    stream->write(data, static_cast<size_t>(sizeInBytes));
+}
+
+void AutomationRecorder::push(Type type, juce::int64 recordPosition, size_t index, uint32_t value) noexcept
+{
+    auto write = writeIndex.load(std::memory_order_relaxed);
+
+    if (write - readIndex.load(std::memory_order_acquire) >= ringSize)
+    {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    ring[write & (ringSize - 1)] = { recordPosition, type, static_cast<uint16_t>(index), value };
+    writeIndex.store(write + 1, std::memory_order_release);
+}
+
+void AutomationRecorder::writeRecord(const Record& record)
+{
+    stream->writeInt64(record.position);
+    stream->writeByte(static_cast<char>(record.type));
+    stream->writeByte(0);
+    stream->writeShort(static_cast<short>(record.index));
+    stream->writeInt(static_cast<int>(record.value));
+}
+
+void AutomationRecorder::run()
+{
+    while (! threadShouldExit())
+    {
+        wait(flushIntervalMs);
+        drain();
+    }
+}
+
+void AutomationRecorder::drain()
+{
+    auto read = readIndex.load(std::memory_order_relaxed);
+    auto write = writeIndex.load(std::memory_order_acquire);
+
+    if (read == write)
+        return;
+
+    {
+        const juce::ScopedLock lock(streamLock);
+
+        for (; read != write; ++read)
+            writeRecord(ring[read & (ringSize - 1)]);
+    }
+
+    readIndex.store(read, std::memory_order_release);
+}
+
+//==============================================================================
+bool AutomationTrace::load(const juce::File& file)
+{
+    *this = {};
+
+    juce::FileInputStream input(file);
+
+    if (! input.openedOk() || input.readInt() != AutomationRecorder::magic || input.readInt() != AutomationRecorder::version)
+        return false;
+
+    sampleRate = input.readDouble();
+
+    for (auto i = input.readInt(); i > 0 && ! input.isExhausted(); --i)
+        parameterIds.add(input.readString());
+
+    constexpr int recordSize = 16;
+
+    while (input.getNumBytesRemaining() >= recordSize)
+    {
+        Change change;
+        change.position = input.readInt64();
+        change.type = static_cast<AutomationRecorder::Type>(input.readByte());
+        input.readByte();
+        change.index = static_cast<uint16_t>(input.readShort());
+        change.value = static_cast<uint32_t>(input.readInt());
+
+        if (change.type == AutomationRecorder::Block)
+        {
+            blocks.push_back({ change.position, static_cast<int>(change.value), change.index });
+        }
+        else if (change.type == AutomationRecorder::End)
+        {
+            complete = true;
+            numDropped = change.value;
+            break;
+        }
+        else
+        {
+            if (change.type == AutomationRecorder::State
+                && input.readIntoMemoryBlock(change.state, static_cast<juce::ssize_t>(change.value)) != change.value)
+                break;
+
+            changes.push_back(std::move(change));
+        }
+    }
+
+    std::stable_sort(changes.begin(), changes.end(), [](const Change& a, const Change& b)
+        {
+            if (a.position != b.position)
+                return a.position < b.position;
+
+            return a.type == AutomationRecorder::State && b.type != AutomationRecorder::State;
+        });
+
+    return true;
+}
+
+int AutomationTrace::getMaxBlockSize() const noexcept
+{
+    auto maxBlockSize = 0;
+
+    for (auto& block : blocks)
+        maxBlockSize = juce::jmax(maxBlockSize, block.numSamples);
+
+    return maxBlockSize;
+}
+
+juce::int64 AutomationTrace::getLengthInSamples() const noexcept
+{
+    return blocks.empty() ? 0 : blocks.back().position + blocks.back().numSamples;
+}
@@ -0,0 +1,174 @@
+/*
+  ==============================================================================
+
+    AutomationRecorder.h
+
+    Records what changes the processor during a session - parameter values,
+    DSP order changes, tempo and state loads - at the sample positions the
+    audio thread saw them, so the session can be replayed offline.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+    The audio thread calls beginBlock() at the start of every block and
+    pollParameters() at every sub-block boundary, just before the parameters
+    are read. A parameter whose value has changed since the last poll is
+    recorded at that sample position; the first block of a recording records
+    every parameter, so a replay starts from the same values. Order, tempo and
+    block records (with the governor's level) come from the processor.
+
+    Records are 16 bytes - position, type, index, value - written into a
+    single-producer ring with no locks or allocation, and appended to the
+    file by a background thread every flushIntervalMs. State loads come from
+    the message thread and go straight to the file with their blob, at the
+    position of the next block. If the ring fills, records are dropped and
+    the count lands in the End record: a replay of that file isn't exact.
+
+    File, little endian:
+
+        header      magic, version, sample rate, parameter ids
+        records     int64 position, uint8 type, uint8 0, uint16 index, uint32 value
+                    a State record's value is the size of the blob following it
+
+    AutomationTrace reads one back. Records come out of the ring in order,
+    but a state load can be written ahead of audio-thread records with
+    earlier positions, so readers sort by position.
+*/
+class AutomationRecorder : private juce::Thread
+{
+public:
+    static constexpr size_t ringSize = 1 << 15;
+    static constexpr int flushIntervalMs = 50;
+
+    static constexpr int magic = 0x52415041;    // "APAR"
+    static constexpr int version = 1;
+
+    enum Type : uint8_t
+    {
+        Block,          // index: governor level, value: number of samples
+        Parameter,      // index: parameter index, value: normalised value, float bits
+        Order,          // index: slot, value: option; one per slot, in slot order
+        Tempo,          // value: bpm, float bits
+        State,          // value: size of the setStateInformation() data after the record
+        End             // value: records dropped
+    };
+
+    AutomationRecorder();
+    ~AutomationRecorder() override;
+
+    // message thread, before any audio: the parameters to poll, in index order
+    void setParameters(const juce::Array<juce::AudioProcessorParameter*>& newParameters);
+
+    // message thread: initialState is replayed before the first block. false if the file can't be written
+    bool start(const juce::File& file, double sampleRate, const juce::MemoryBlock& initialState);
+    void stop();
+
+    bool isRecording() const noexcept { return recording.load(std::memory_order_relaxed); }
+    juce::uint64 getNumDropped() const noexcept { return dropped.load(std::memory_order_relaxed); }
+
+    // audio thread: true for the first block of a recording, when the caller should record its whole order
+    bool beginBlock(int numSamples, int governorLevel) noexcept;
+
+    // audio thread, offset from the start of the block
+    void pollParameters(int offset) noexcept;
+    void recordOrderSlot(size_t slot, int option) noexcept;
+    void recordTempo(double bpm) noexcept;
+
+    // message thread, after the state has been applied
+    void recordState(const void* data, int sizeInBytes);
+
+private:
+    struct Record
+    {
+        juce::int64 position;
+        uint8_t type;
+        uint16_t index;
+        uint32_t value;
+    };
+
+    void push(Type type, juce::int64 position, size_t index, uint32_t value) noexcept;
+
+    void writeRecord(const Record& record);
+
+    void run() override;
+    void drain();
+
+    std::vector<juce::AudioProcessorParameter*> parameters;
+
+    std::vector<Record> ring;
+    std::atomic<size_t> writeIndex{ 0 }, readIndex{ 0 };
+
+    std::atomic<bool> recording{ false };
+
+    // a new value tells the audio thread a new recording has started
+    std::atomic<juce::uint64> session{ 0 };
+
+    std::atomic<juce::uint64> dropped{ 0 };
+
+    // where a state load lands: the start of the block after the one running
+    std::atomic<juce::int64> nextBlockPosition{ 0 };
+
+    // audio thread
+    juce::uint64 activeSession = 0;
+    bool blockRecording = false;
+    juce::int64 position = 0, blockStart = 0;
+    std::vector<float> lastValues;
+    float lastTempo = 0.f;
+
+    juce::CriticalSection streamLock;
+    std::unique_ptr<juce::FileOutputStream> stream;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AutomationRecorder)
+};
+
+/*
+    A file written by AutomationRecorder, read back for a replay: the host's
+    blocks in order, and everything else sorted by position, state loads
+    ahead of whatever else landed on the same sample.
+*/
+struct AutomationTrace
+{
+    struct Block
+    {
+        juce::int64 position = 0;
+        int numSamples = 0;
+        int governorLevel = 0;
+    };
+
+    struct Change
+    {
+        juce::int64 position = 0;
+        AutomationRecorder::Type type = AutomationRecorder::Parameter;
+        uint16_t index = 0;
+        uint32_t value = 0;
+        juce::MemoryBlock state;
+
+        float getFloat() const noexcept
+        {
+            float f;
+            std::memcpy(&f, &value, sizeof(f));
+            return f;
+        }
+    };
+
+    double sampleRate = 0.0;
+    juce::StringArray parameterIds;
+
+    std::vector<Block> blocks;
+    std::vector<Change> changes;
+
+    // false if the recording was cut short, otherwise what it dropped
+    bool complete = false;
+    juce::uint64 numDropped = 0;
+
+    // false if the file isn't a trace this version can read
+    bool load(const juce::File& file);
+
+    int getMaxBlockSize() const noexcept;
+    juce::int64 getLengthInSamples() const noexcept;
+};
@@ -0,0 +1,275 @@
+/*
+  ==============================================================================
+
+    ChorusEngine.cpp
+
+  ==============================================================================
+*/
+
+#include "ChorusEngine.h"
+
+void ChorusEngine::setMaximumDelay(float newMaxCentreDelayMs, float newMaxDepth)
+{
+    maxCentreDelayMs = newMaxCentreDelayMs;
+    maxDepth = newMaxDepth;
+}
+
+void ChorusEngine::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    jassert(spec.sampleRate > 0);
+    jassert(spec.numChannels > 0 && spec.numChannels <= maxChannels);
+
+    sampleRate = spec.sampleRate;
+
+    auto maxDelayMs = maxCentreDelayMs + maximumDelayModulationMs * oscVolumeMultiplier * maxDepth;
+
+    // + 2 for the interpolation partner and the sample being written
+    bufferLength = static_cast<int>(std::ceil(maxDelayMs * sampleRate / 1000.0)) + 2;
+    buffer.assign(static_cast<size_t>(bufferLength) * 2 * maxChannels, 0.f);
+
+    // one sample less covers the rounding of the accumulated delay ramps
+    maxChunkLength = juce::jlimit(1, maxChunkFrames, static_cast<int>(minimumDelayMs * sampleRate / 1000.0) - 1);
+
+    setControlInterval(controlInterval);
+    reset();
+}
+
+void ChorusEngine::setControlInterval(int numSamples) noexcept
+{
+    controlInterval = juce::jlimit(1, 256, numSamples);
+
+    // ~50ms smoothing, applied once per control update
+    smoothingCoefficient = 1.f - std::exp(-static_cast<float>(controlInterval) / (0.05f * static_cast<float>(sampleRate)));
+}
+
+void ChorusEngine::reset()
+{
+    std::fill(buffer.begin(), buffer.end(), 0.f);
+    writePos = 0;
+    samplesUntilControl = 0;
+
+    delaySamples.fill(0.f);
+    delayIncrement.fill(0.f);
+    lastOutput.fill(0.f);
+
+    smoothed = targets;
+    firstControlUpdate = true;
+}
+
+void ChorusEngine::releaseResources()
+{
+    std::vector<float>().swap(buffer);
+    bufferLength = 0;
+    writePos = 0;
+}
+
+void ChorusEngine::copyChannelState(size_t source, size_t destination) noexcept
+{
+    jassert(source < maxChannels && destination < maxChannels);
+
+    for (size_t frame = 0; frame < buffer.size(); frame += maxChannels)
+        buffer[frame + destination] = buffer[frame + source];
+
+    delaySamples[destination] = delaySamples[source];
+    delayIncrement[destination] = delayIncrement[source];
+    lastOutput[destination] = lastOutput[source];
+}
+
+void ChorusEngine::updateControl(int sampleOffset, size_t numChannels) noexcept
+{
+    jassert(modulation != nullptr);
+
+    auto interval = static_cast<float>(controlInterval);
+
+    smoothed.depth += (targets.depth - smoothed.depth) * smoothingCoefficient;
+    smoothed.centreDelayMs += (targets.centreDelayMs - smoothed.centreDelayMs) * smoothingCoefficient;
+    smoothed.feedback += (targets.feedback - smoothed.feedback) * smoothingCoefficient;
+    smoothed.mix += (targets.mix - smoothed.mix) * smoothingCoefficient;
+
+    auto maxDelayMs = maxCentreDelayMs + maximumDelayModulationMs * oscVolumeMultiplier * maxDepth;
+
+    for (size_t ch = 0; ch < numChannels; ++ch)
+    {
+        auto lfo = modulation->getValue(modulationSource, ch, sampleOffset);
+
+        auto delayMs = juce::jlimit(minimumDelayMs, maxDelayMs,
+            smoothed.centreDelayMs + maximumDelayModulationMs * oscVolumeMultiplier * smoothed.depth * lfo);
+        auto target = delayMs * static_cast<float>(sampleRate) / 1000.f;
+
+        if (firstControlUpdate)
+            delaySamples[ch] = target;
+
+        delayIncrement[ch] = (target - delaySamples[ch]) / interval;
+    }
+
+    if (firstControlUpdate)
+    {
+        feedback = smoothed.feedback;
+        mix = smoothed.mix;
+        firstControlUpdate = false;
+    }
+
+    feedbackIncrement = (smoothed.feedback - feedback) / interval;
+    mixIncrement = (smoothed.mix - mix) / interval;
+
+    samplesUntilControl = controlInterval;
+}
+
+void ChorusEngine::process(const juce::dsp::ProcessContextReplacing<float>& context)
+{
+    auto& inputBlock = context.getInputBlock();
+    auto& outputBlock = context.getOutputBlock();
+
+    if (context.usesSeparateInputAndOutputBlocks())
+        outputBlock.copyFrom(inputBlock);
+
+    if (context.isBypassed)
+        return;
+
+    auto numChannels = juce::jmin(outputBlock.getNumChannels(), maxChannels);
+    auto numSamples = outputBlock.getNumSamples();
+
+    for (size_t pos = 0; pos < numSamples;)
+    {
+        // a chunk is shorter than the shortest delay, see prepare(), and never crosses the end of the buffer
+        auto chunk = juce::jmin(maxChunkLength, bufferLength - writePos, static_cast<int>(numSamples - pos));
+
+        if (numChannels == 2)
+            processChunk<2>(outputBlock, pos, chunk);
+        else
+            processChunk<1>(outputBlock, pos, chunk);
+
+        pos += static_cast<size_t>(chunk);
+        writePos += chunk;
+
+        if (writePos == bufferLength)
+            writePos = 0;
+    }
+
+    for (auto& v : lastOutput)
+        v = juce::dsp::util::snapToZero(v);
+}
+
+template<size_t Lanes>
+void ChorusEngine::readTaps(const juce::dsp::AudioBlock<float>& block, size_t start, int offset, int numSamples) noexcept
+{
+    std::array<const float*, Lanes> input;
+
+    for (size_t ch = 0; ch < Lanes; ++ch)
+        input[ch] = block.getChannelPointer(ch) + start + static_cast<size_t>(offset);
+
+    auto* data = buffer.data();
+    auto frame = static_cast<size_t>(writePos + offset) * maxChannels + static_cast<size_t>(bufferLength) * maxChannels;
+    auto value = static_cast<size_t>(offset) * Lanes;
+
+    // the ramps in locals: kept in the members, each store to scratch would have to reload them.
+    // The lanes share one loop so that their ramps, each a chain of adds, overlap
+    std::array<float, Lanes> delay;
+
+    for (size_t ch = 0; ch < Lanes; ++ch)
+        delay[ch] = delaySamples[ch];
+
+    auto currentFeedback = feedback;
+    auto currentMix = mix;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        for (size_t ch = 0; ch < Lanes; ++ch)
+        {
+            auto delayInt = static_cast<int>(delay[ch]);
+            auto frac = delay[ch] - static_cast<float>(delayInt);
+
+            // always inside [0, 2 * bufferLength) thanks to the mirrored copy
+            auto read = frame - static_cast<size_t>(delayInt) * maxChannels + ch;
+            auto a = data[read];
+            auto b = data[read - maxChannels];
+            auto wet = a + frac * (b - a);
+
+            scratch.input[value + ch] = input[ch][i];
+            scratch.wet[value + ch] = wet;
+            scratch.mix[value + ch] = currentMix;
+            scratch.feedback[value + Lanes + ch] = wet * currentFeedback;
+
+            delay[ch] += delayIncrement[ch];
+        }
+
+        currentFeedback += feedbackIncrement;
+        currentMix += mixIncrement;
+
+        frame += maxChannels;
+        value += Lanes;
+    }
+
+    for (size_t ch = 0; ch < Lanes; ++ch)
+        delaySamples[ch] = delay[ch];
+
+    feedback = currentFeedback;
+    mix = currentMix;
+}
+
+template<size_t Lanes>
+void ChorusEngine::processChunk(const juce::dsp::AudioBlock<float>& block, size_t start, int numSamples) noexcept
+{
+    auto* data = buffer.data();
+    auto mirror = static_cast<size_t>(bufferLength) * maxChannels;
+    auto firstFrame = static_cast<size_t>(writePos) * maxChannels;
+    auto numValues = static_cast<size_t>(numSamples) * Lanes;
+
+    for (size_t ch = 0; ch < Lanes; ++ch)
+        scratch.feedback[ch] = lastOutput[ch];
+
+    // the taps, control segment by control segment. Every frame they read is from before this
+    // chunk, so nothing here waits on the writes below
+    for (int i = 0; i < numSamples;)
+    {
+        if (samplesUntilControl == 0)
+            updateControl(static_cast<int>(start) + i, Lanes);
+
+        auto segment = juce::jmin(samplesUntilControl, numSamples - i);
+        readTaps<Lanes>(block, start, i, segment);
+
+        i += segment;
+        samplesUntilControl -= segment;
+    }
+
+    for (size_t ch = 0; ch < Lanes; ++ch)
+        lastOutput[ch] = scratch.feedback[numValues + ch];
+
+    // what goes into the line (over the feedback terms) and the output (over the taps),
+    // Vec::size() / Lanes frames at a time; the end of the last register is never used
+    for (size_t v = 0; v < numValues; v += Vec::size())
+    {
+        auto input = Vec::fromRawArray(scratch.input.data() + v);
+        auto wet = Vec::fromRawArray(scratch.wet.data() + v);
+
+        (input - Vec::fromRawArray(scratch.feedback.data() + v)).copyToRawArray(scratch.feedback.data() + v);
+        Vec::multiplyAdd(input, Vec::fromRawArray(scratch.mix.data() + v), wet - input).copyToRawArray(scratch.wet.data() + v);
+    }
+
+    std::array<float*, Lanes> io;
+
+    for (size_t ch = 0; ch < Lanes; ++ch)
+        io[ch] = block.getChannelPointer(ch) + start;
+
+    if constexpr (Lanes == maxChannels)
+    {
+        // interleaved like the buffer, so the chunk's frames are one contiguous range
+        juce::FloatVectorOperations::copy(data + firstFrame, scratch.feedback.data(), static_cast<int>(numValues));
+        juce::FloatVectorOperations::copy(data + firstFrame + mirror, scratch.feedback.data(), static_cast<int>(numValues));
+
+        for (int i = 0; i < numSamples; ++i)
+            for (size_t ch = 0; ch < Lanes; ++ch)
+                io[ch][i] = scratch.wet[static_cast<size_t>(i) * Lanes + ch];
+    }
+    else
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto frame = firstFrame + static_cast<size_t>(i) * maxChannels;
+            data[frame] = scratch.feedback[static_cast<size_t>(i)];
+            data[frame + mirror] = scratch.feedback[static_cast<size_t>(i)];
+        }
+
+        juce::FloatVectorOperations::copy(io[0], scratch.wet.data(), numSamples);
+    }
+}
@@ -0,0 +1,129 @@
+/*
+  ==============================================================================
+
+    ChorusEngine.h
+
+    Stereo modulated-delay chorus, replaces juce::dsp::Chorus.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ModulationBus.h"
+
+/*
+    Same parameters and delay law as juce::dsp::Chorus
+    (delay = centre + 10 ms * depth * lfo, feedback subtracted from the input,
+    linear dry / wet), but:
+
+    - the LFO comes from the processor's ModulationBus and is read every
+      controlInterval samples, with the delay time ramped linearly in between
+    - both channels live interleaved in one delay buffer. The delay never
+      goes below minimumDelayMs, so a chunk shorter than that only reads
+      frames written before it, and its feedback only reaches later chunks.
+      A chunk is done in two passes: the taps, one interpolated read per
+      lane and sample, then the feedback writes and the mix on whole
+      SIMDRegisters of interleaved frames, stored with plain copies
+    - the buffer is written twice (mirrored), so every read inside a chunk
+      is a plain index with no wrap-around
+    - the buffer is sized from the parameter maxima passed to setMaximumDelay()
+*/
+class ChorusEngine : public juce::dsp::ProcessorBase
+{
+public:
+    static constexpr size_t maxChannels = 2;
+
+    // call before prepare(), with the range ends of the centre delay / depth parameters
+    void setMaximumDelay(float maxCentreDelayMs, float maxDepth);
+
+    void prepare(const juce::dsp::ProcessSpec& spec) override;
+    void process(const juce::dsp::ProcessContextReplacing<float>& context) override;
+    void reset() override;
+
+    // frees what prepare() allocated; prepare() again before the next process()
+    void releaseResources();
+
+    void setModulation(const ModulationBus* bus, ModulationBus::Source source) noexcept
+    {
+        modulation = bus;
+        modulationSource = source;
+    }
+
+    void setDepth(float newDepth) noexcept { targets.depth = newDepth; }
+    void setCentreDelay(float newDelayMs) noexcept { targets.centreDelayMs = newDelayMs; }
+    void setFeedback(float newFeedback) noexcept { targets.feedback = newFeedback; }
+    void setMix(float newMix) noexcept { targets.mix = newMix; }
+
+    void setControlInterval(int numSamples) noexcept;
+
+    // makes one channel's state a copy of another's, for the processor's dual-mono path
+    void copyChannelState(size_t source, size_t destination) noexcept;
+
+private:
+    void updateControl(int sampleOffset, size_t numChannels) noexcept;
+
+    template<size_t Lanes>
+    void processChunk(const juce::dsp::AudioBlock<float>& block, size_t start, int numSamples) noexcept;
+
+    // fills scratch for numSamples frames from offset into the chunk at start, all inside one control segment
+    template<size_t Lanes>
+    void readTaps(const juce::dsp::AudioBlock<float>& block, size_t start, int offset, int numSamples) noexcept;
+
+    static constexpr float maximumDelayModulationMs = 20.f;
+    static constexpr float oscVolumeMultiplier = 0.5f;
+    static constexpr float minimumDelayMs = 1.f;
+
+    struct Settings
+    {
+        float depth = 0.25f;
+        float centreDelayMs = 7.f;
+        float feedback = 0.f;
+        float mix = 0.5f;
+    };
+
+    Settings targets, smoothed;
+
+    using Vec = juce::dsp::SIMDRegister<float>;
+
+    // one chunk's frames, interleaved like the buffer, with room for a last partly used register
+    static constexpr int maxChunkFrames = 128;
+    static constexpr size_t scratchSize = maxChunkFrames * maxChannels + Vec::SIMDNumElements;
+
+    struct Scratch
+    {
+        alignas(Vec::SIMDRegisterSize) std::array<float, scratchSize> input;
+        alignas(Vec::SIMDRegisterSize) std::array<float, scratchSize> wet;
+        alignas(Vec::SIMDRegisterSize) std::array<float, scratchSize> mix;
+
+        // the feedback each frame subtracts: the previous frame's wet * feedback, so one frame late
+        alignas(Vec::SIMDRegisterSize) std::array<float, scratchSize + maxChannels> feedback;
+    };
+
+    Scratch scratch{};
+
+    const ModulationBus* modulation = nullptr;
+    ModulationBus::Source modulationSource = ModulationBus::ChorusLfo;
+    float smoothingCoefficient = 1.f;
+
+    double sampleRate = 44100.0;
+    float maxCentreDelayMs = 100.f;
+    float maxDepth = 1.f;
+
+    // interleaved frames, bufferLength frames long and mirrored once behind itself
+    std::vector<float> buffer;
+    int bufferLength = 0;
+    int writePos = 0;
+
+    // under the shortest delay at this sample rate, see prepare()
+    int maxChunkLength = 1;
+
+    int controlInterval = 16;
+    int samplesUntilControl = 0;
+
+    std::array<float, maxChannels> delaySamples{}, delayIncrement{}, lastOutput{};
+    float feedback = 0.f, feedbackIncrement = 0.f;
+    float mix = 0.f, mixIncrement = 0.f;
+    bool firstControlUpdate = true;
+};
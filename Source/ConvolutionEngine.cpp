@@ -0,0 +1,1032 @@
+/*
+  ==============================================================================
+
+    ConvolutionEngine.cpp
+
+  ==============================================================================
+*/
+
+#include "ConvolutionEngine.h"
+
+namespace
+{
+    constexpr int maxHeadPartitions = (ConvolutionEngine::tailStart - ConvolutionEngine::headLength) / ConvolutionEngine::headLength;
+
+    // how often the loader thread looks for a kernel the audio thread has handed back, while a swap is on
+    constexpr int garbagePollMs = 20;
+
+    constexpr int getFFTOrder(int size)
+    {
+        auto order = 0;
+
+        while ((1 << order) < size)
+            ++order;
+
+        return order;
+    }
+
+    // each spectrum's real and imaginary arrays start on an aligned boundary
+    constexpr size_t paddedBins(int numBins) { return static_cast<size_t>((numBins + 7) & ~7); }
+    constexpr size_t spectrumStride(int numBins) { return 2 * paddedBins(numBins); }
+
+    // scratch holds 2 * fft size floats
+    void forwardTransform(juce::dsp::FFT& fft, float* scratch, const float* input, int numInput, float* re, float* im)
+    {
+        auto size = fft.getSize();
+
+        std::fill(scratch, scratch + 2 * size, 0.f);
+        std::copy_n(input, numInput, scratch);
+
+        fft.performRealOnlyForwardTransform(scratch, true);
+
+        for (int k = 0; k <= size / 2; ++k)
+        {
+            re[k] = scratch[2 * k];
+            im[k] = scratch[2 * k + 1];
+        }
+    }
+
+    // leaves the (1 / size scaled) real result in scratch[0, size)
+    void inverseTransform(juce::dsp::FFT& fft, float* scratch, const float* re, const float* im)
+    {
+        auto size = fft.getSize();
+
+        std::fill(scratch, scratch + 2 * size, 0.f);
+
+        for (int k = 0; k <= size / 2; ++k)
+        {
+            scratch[2 * k] = re[k];
+            scratch[2 * k + 1] = im[k];
+        }
+
+        fft.performRealOnlyInverseTransform(scratch);
+    }
+}
+
+//==============================================================================
+// one thread for every engine in the process: IRs are loaded a few at a time, if that
+class ConvolutionEngine::Worker : private juce::Thread
+{
+public:
+    Worker() : juce::Thread("Convolution loader")
+    {
+        startThread(juce::Thread::Priority::low);
+    }
+
+    ~Worker() override
+    {
+        signalThreadShouldExit();
+        notify();
+        stopThread(-1);
+    }
+
+    void add(ConvolutionEngine& engine)
+    {
+        std::scoped_lock sl(lock);
+        engines.push_back(&engine);
+    }
+
+    // waits for the engine to be finished with if it is being serviced
+    void remove(ConvolutionEngine& engine)
+    {
+        std::scoped_lock sl(lock);
+        engines.erase(std::remove(engines.begin(), engines.end(), &engine), engines.end());
+    }
+
+    void wake() const { notify(); }
+
+private:
+    void run() override
+    {
+        auto polling = false;
+
+        while (! threadShouldExit())
+        {
+            // the audio thread can't wake this one when it hands a kernel back, so a swap is polled until it's over
+            wait(polling ? garbagePollMs : -1);
+
+            std::scoped_lock sl(lock);
+            polling = false;
+
+            for (auto* engine : engines)
+            {
+                engine->service();
+                polling = polling || engine->loader.isSwapInProgress();
+            }
+        }
+    }
+
+    std::mutex lock;
+    std::vector<ConvolutionEngine*> engines;
+};
+
+//==============================================================================
+ConvolutionEngine::Loader::~Loader()
+{
+    delete incoming.exchange(nullptr);
+    delete outgoing.exchange(nullptr);
+}
+
+void ConvolutionEngine::Loader::publish(Kernel* kernel)
+{
+    // one the audio thread never picked up can go straight away
+    delete incoming.exchange(kernel, std::memory_order_acq_rel);
+}
+
+void ConvolutionEngine::Loader::collectGarbage()
+{
+    delete outgoing.exchange(nullptr, std::memory_order_acq_rel);
+}
+
+bool ConvolutionEngine::Loader::isSwapInProgress() const noexcept
+{
+    // in the order the audio thread moves a kernel along, which sets swapping before it takes one
+    // and clears it after it hands one back: between the three loads there is always one to see
+    return incoming.load() != nullptr || swapping.load() || outgoing.load() != nullptr;
+}
+
+size_t ConvolutionEngine::Kernel::getLongestTailSection() const noexcept
+{
+    for (auto section = static_cast<size_t>(numTailSections); --section > 0;)
+        if (numTailPartitions[section] > 0)
+            return section;
+
+    return 0;
+}
+
+ConvolutionEngine::TailSection::TailSection(size_t section)
+    : partition(tailPartitions[section]),
+      bins(tailPartitions[section] + 1),
+      framesPerJob(tailPartitions[section] / headLength),
+      fft(getFFTOrder(2 * tailPartitions[section])),
+      jobStep(tailPartitions[section] / headLength)
+{
+}
+
+//==============================================================================
+ConvolutionEngine::ConvolutionEngine()
+{
+    static_assert(numTailSections == 2 && tailPartitions[1] % tailPartitions[0] == 0,
+                  "tails has an initialiser per section, and every boundary of a section is one of the sections before");
+
+    mix.setCurrentAndTargetValue(1.f);
+    worker->add(*this);
+}
+
+ConvolutionEngine::~ConvolutionEngine()
+{
+    worker->remove(*this);
+
+    for (auto& slot : slots)
+        delete slot.kernel;
+}
+
+int ConvolutionEngine::getMaxTailPartitions(size_t section, double rate) noexcept
+{
+    auto partition = tailPartitions[section];
+    auto end = static_cast<int>(std::ceil(maxLengthSeconds * rate));
+
+    if (section + 1 < static_cast<size_t>(numTailSections))
+        end = juce::jmin(end, 2 * tailPartitions[section + 1]);
+
+    return juce::jmax(0, (end - 2 * partition + partition - 1) / partition);
+}
+
+void ConvolutionEngine::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    jassert(spec.sampleRate > 0);
+    jassert(spec.numChannels > 0 && spec.numChannels <= maxChannels);
+
+    sampleRate = spec.sampleRate;
+    numChannels = spec.numChannels;
+
+    history.allocate(maxChannels * 2 * headLength);
+    headDelayLine.allocate(maxChannels * maxHeadPartitions * spectrumStride(headBins));
+
+    for (size_t section = 0; section < tails.size(); ++section)
+    {
+        auto& tail = tails[section];
+        tail.maxPartitions = getMaxTailPartitions(section, sampleRate);
+        tail.input.allocate(maxChannels * 2 * static_cast<size_t>(tail.partition));
+        tail.delayLine.allocate(maxChannels * static_cast<size_t>(tail.maxPartitions) * spectrumStride(tail.bins));
+    }
+
+    fftScratch.allocate(2 * static_cast<size_t>(tails.back().fft.getSize()));
+
+    for (auto& slot : slots)
+        allocateSlot(slot);
+
+    crossfadeLength = juce::jmax(1, static_cast<int>(crossfadeSeconds * sampleRate));
+    mix.reset(sampleRate, 0.05);
+
+    // whatever was on its way in takes over straight away; nothing is processing
+    if (nextState == NextState::Warming)
+    {
+        delete slots[current].kernel;
+        slots[current].kernel = nullptr;
+        current = 1 - current;
+    }
+    else
+    {
+        delete slots[1 - current].kernel;
+        slots[1 - current].kernel = nullptr;
+    }
+
+    nextState = NextState::Empty;
+
+    auto needsKernel = false;
+
+    {
+        std::scoped_lock sl(loader.lock);
+        loader.sampleRate = sampleRate;
+        loader.swapping = false;
+
+        auto matchesRate = [this](const Kernel* kernel)
+            {
+                return kernel == nullptr || kernel->numChannels == 0 || kernel->sampleRate == sampleRate;
+            };
+
+        // one for another rate isn't any use
+        if (! matchesRate(slots[current].kernel))
+        {
+            delete slots[current].kernel;
+            slots[current].kernel = nullptr;
+        }
+
+        if (! matchesRate(loader.incoming.load(std::memory_order_acquire)))
+            delete loader.incoming.exchange(nullptr);
+
+        loader.collectGarbage();
+
+        needsKernel = loader.source != nullptr && slots[current].kernel == nullptr && loader.incoming.load() == nullptr;
+        loader.buildPending = loader.buildPending || needsKernel;
+    }
+
+    if (needsKernel)
+        requestService();
+
+    reset();
+}
+
+void ConvolutionEngine::allocateSlot(Slot& slot)
+{
+    slot.headOut.allocate(maxChannels * headLength);
+
+    for (size_t section = 0; section < tails.size(); ++section)
+    {
+        slot.tailAcc[section].allocate(maxChannels * spectrumStride(tails[section].bins));
+        slot.tailOut[section].allocate(maxChannels * 2 * static_cast<size_t>(tails[section].partition));
+    }
+}
+
+void ConvolutionEngine::clearSlot(Slot& slot)
+{
+    slot.headOut.clear();
+
+    for (size_t section = 0; section < tails.size(); ++section)
+    {
+        slot.tailAcc[section].clear();
+        slot.tailOut[section].clear();
+    }
+}
+
+void ConvolutionEngine::reset()
+{
+    history.clear();
+
+    // the delay lines aren't cleared, only marked stale
+    headDelayWrite = 0;
+    numHeadWritten = 0;
+
+    for (auto& tail : tails)
+    {
+        // the first job transforms the partition before the one being filled, which has to be silence
+        if (tail.input.data != nullptr)
+            for (size_t ch = 0; ch < maxChannels; ++ch)
+                std::fill_n(tail.input.get(ch * 2 * static_cast<size_t>(tail.partition)), tail.partition, 0.f);
+
+        tail.fill = 0;
+        tail.jobStep = tail.framesPerJob;
+        tail.readIndex = 0;
+        tail.delayWrite = 0;
+        tail.numWritten = 0;
+    }
+
+    // an empty slot's buffers are never read, and a kernel put in one clears them first
+    for (auto& slot : slots)
+        if (slot.kernel != nullptr)
+            clearSlot(slot);
+
+    framePos = 0;
+
+    // a fade in progress is finished; one warming up goes on from silence like everything else
+    crossfadePos = crossfadeLength;
+
+    mix.setCurrentAndTargetValue(mix.getTargetValue());
+    wasBypassed = false;
+    idle = false;
+}
+
+void ConvolutionEngine::releaseResources()
+{
+    history.free();
+    headDelayLine.free();
+    fftScratch.free();
+
+    for (auto& tail : tails)
+    {
+        tail.input.free();
+        tail.delayLine.free();
+    }
+
+    for (auto& slot : slots)
+    {
+        delete slot.kernel;
+        slot.kernel = nullptr;
+
+        slot.headOut.free();
+
+        for (size_t section = 0; section < tails.size(); ++section)
+        {
+            slot.tailAcc[section].free();
+            slot.tailOut[section].free();
+        }
+    }
+
+    nextState = NextState::Empty;
+
+    // the decoded file stays, so prepare() can build the kernel again
+    std::scoped_lock sl(loader.lock);
+    delete loader.incoming.exchange(nullptr);
+    loader.collectGarbage();
+    loader.swapping = false;
+}
+
+//==============================================================================
+void ConvolutionEngine::loadImpulseResponse(const juce::File& file)
+{
+    {
+        std::scoped_lock sl(loader.lock);
+        ++loader.generation;
+        loader.pendingFile = file;
+        loader.readPending = true;
+    }
+
+    requestService();
+}
+
+void ConvolutionEngine::clearImpulseResponse()
+{
+    {
+        std::scoped_lock sl(loader.lock);
+        ++loader.generation;
+        loader.readPending = false;
+        loader.buildPending = false;
+        loader.source.reset();
+
+        // an empty kernel: fades back to the dry signal like any other swap, and the loader thread frees what it replaces
+        loader.publish(new Kernel());
+        loader.collectGarbage();
+    }
+
+    worker->wake();
+}
+
+double ConvolutionEngine::getImpulseResponseLengthSeconds() const
+{
+    std::scoped_lock sl(loader.lock);
+
+    if (loader.source == nullptr || loader.sourceRate <= 0.0)
+        return 0.0;
+
+    return loader.source->getNumSamples() / loader.sourceRate;
+}
+
+std::shared_ptr<const juce::AudioBuffer<float>> ConvolutionEngine::readFile(const juce::File& file, double& fileRate)
+{
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formats.createReaderFor(file));
+
+    if (reader == nullptr || reader->sampleRate <= 0 || reader->lengthInSamples <= 0)
+        return nullptr;
+
+    fileRate = reader->sampleRate;
+
+    auto numSamples = static_cast<int>(juce::jmin(reader->lengthInSamples,
+        static_cast<juce::int64>(std::ceil(maxLengthSeconds * fileRate))));
+    auto numFileChannels = juce::jlimit(1, static_cast<int>(maxChannels), static_cast<int>(reader->numChannels));
+
+    auto buffer = std::make_shared<juce::AudioBuffer<float>>(numFileChannels, numSamples);
+    reader->read(buffer.get(), 0, numSamples, 0, true, numFileChannels > 1);
+
+    // trailing silence would only cost partitions
+    auto threshold = juce::Decibels::decibelsToGain(-100.f);
+    auto length = numSamples;
+
+    while (length > 1)
+    {
+        auto loud = false;
+
+        for (int ch = 0; ch < numFileChannels; ++ch)
+            loud = loud || std::abs(buffer->getSample(ch, length - 1)) > threshold;
+
+        if (loud)
+            break;
+
+        --length;
+    }
+
+    buffer->setSize(numFileChannels, length, true);
+    return buffer;
+}
+
+void ConvolutionEngine::requestService()
+{
+    if (synchronousLoading)
+        service();
+
+    // either way the loader thread has to look out for the kernel the new one replaces
+    worker->wake();
+}
+
+void ConvolutionEngine::service()
+{
+    std::scoped_lock serviceSl(serviceLock);
+
+    juce::File file;
+    auto read = false;
+    auto generation = 0;
+
+    {
+        std::scoped_lock sl(loader.lock);
+        read = std::exchange(loader.readPending, false);
+        file = loader.pendingFile;
+        generation = loader.generation;
+    }
+
+    if (read)
+    {
+        double fileRate = 0.0;
+
+        // an unreadable file leaves whatever was loaded before
+        if (auto source = readFile(file, fileRate))
+        {
+            std::scoped_lock sl(loader.lock);
+
+            if (generation == loader.generation)
+            {
+                loader.source = std::move(source);
+                loader.sourceRate = fileRate;
+                loader.buildPending = true;
+            }
+        }
+    }
+
+    // built outside the lock; a new file or a new rate meanwhile asks for another build
+    for (;;)
+    {
+        std::shared_ptr<const juce::AudioBuffer<float>> source;
+        double sourceRate, targetRate;
+
+        {
+            std::scoped_lock sl(loader.lock);
+
+            if (! std::exchange(loader.buildPending, false))
+                break;
+
+            source = loader.source;
+            sourceRate = loader.sourceRate;
+            targetRate = loader.sampleRate;
+            generation = loader.generation;
+        }
+
+        // not prepared yet: prepare() asks for it
+        if (source == nullptr || targetRate <= 0.0)
+            continue;
+
+        auto kernel = buildKernel(*source, sourceRate, targetRate);
+
+        std::scoped_lock sl(loader.lock);
+
+        if (generation == loader.generation && targetRate == loader.sampleRate && source == loader.source)
+            loader.publish(kernel.release());
+    }
+
+    loader.collectGarbage();
+}
+
+std::unique_ptr<ConvolutionEngine::Kernel> ConvolutionEngine::buildKernel(const juce::AudioBuffer<float>& source,
+    double sourceRate, double targetRate)
+{
+    auto kernel = std::make_unique<Kernel>();
+    kernel->sampleRate = targetRate;
+    kernel->numChannels = static_cast<size_t>(juce::jlimit(1, static_cast<int>(maxChannels), source.getNumChannels()));
+
+    auto numKernelChannels = static_cast<int>(kernel->numChannels);
+    auto ratio = sourceRate / targetRate;
+    auto length = juce::jmin(static_cast<int>(std::ceil(source.getNumSamples() / ratio)),
+                             static_cast<int>(std::ceil(maxLengthSeconds * targetRate)));
+
+    juce::AudioBuffer<float> ir(numKernelChannels, juce::jmax(1, length));
+
+    if (ratio == 1.0)
+    {
+        for (int ch = 0; ch < numKernelChannels; ++ch)
+            ir.copyFrom(ch, 0, source, ch, 0, ir.getNumSamples());
+    }
+    else
+    {
+        // as juce::dsp::Convolution does it
+        juce::AudioBuffer<float> copy(source);
+        juce::MemoryAudioSource memory(copy, false);
+        juce::ResamplingAudioSource resampler(&memory, false, numKernelChannels);
+
+        resampler.setResamplingRatio(ratio);
+        resampler.prepareToPlay(ir.getNumSamples(), targetRate);
+        resampler.getNextAudioBlock(juce::AudioSourceChannelInfo(ir));
+    }
+
+    // unit energy per channel on average, so a plain impulse passes at unity gain
+    auto energy = 0.0;
+
+    for (int ch = 0; ch < numKernelChannels; ++ch)
+        for (int i = 0; i < ir.getNumSamples(); ++i)
+            energy += static_cast<double>(ir.getSample(ch, i)) * ir.getSample(ch, i);
+
+    if (energy > 0.0)
+        ir.applyGain(static_cast<float>(1.0 / std::sqrt(energy / numKernelChannels)));
+
+    length = ir.getNumSamples();
+
+    kernel->numHeadPartitions = juce::jlimit(0, maxHeadPartitions, (length - headLength + headLength - 1) / headLength);
+
+    auto headStride = spectrumStride(headBins);
+    kernel->headSpectra.allocate(kernel->numChannels * static_cast<size_t>(juce::jmax(1, kernel->numHeadPartitions)) * headStride);
+
+    for (size_t section = 0; section < tailPartitions.size(); ++section)
+    {
+        auto partition = tailPartitions[section];
+        auto& numPartitions = kernel->numTailPartitions[section];
+
+        numPartitions = juce::jlimit(0, getMaxTailPartitions(section, targetRate), (length - 2 * partition + partition - 1) / partition);
+        kernel->tailSpectra[section].allocate(kernel->numChannels * static_cast<size_t>(juce::jmax(1, numPartitions)) * spectrumStride(partition + 1));
+    }
+
+    juce::dsp::FFT headTransform(7);
+    std::vector<float> scratch(2 * static_cast<size_t>(2 * tailPartitions.back()));
+
+    for (int ch = 0; ch < numKernelChannels; ++ch)
+    {
+        auto* h = ir.getReadPointer(ch);
+        auto c = static_cast<size_t>(ch);
+
+        for (int k = 0; k < juce::jmin(headLength, length); ++k)
+            kernel->head[c][static_cast<size_t>(headLength - 1 - k)] = h[k];
+
+        // zero padded to twice the partition: the second half of each circular result is the linear one
+        for (int j = 0; j < kernel->numHeadPartitions; ++j)
+        {
+            auto start = headLength + j * headLength;
+            auto* re = kernel->headSpectra.get((c * static_cast<size_t>(kernel->numHeadPartitions) + static_cast<size_t>(j)) * headStride);
+            forwardTransform(headTransform, scratch.data(), h + start, juce::jmin(headLength, length - start), re, re + paddedBins(headBins));
+        }
+    }
+
+    for (size_t section = 0; section < tailPartitions.size(); ++section)
+    {
+        auto partition = tailPartitions[section];
+        auto numPartitions = kernel->numTailPartitions[section];
+        auto stride = spectrumStride(partition + 1);
+
+        juce::dsp::FFT tailTransform(getFFTOrder(2 * partition));
+
+        for (int ch = 0; ch < numKernelChannels; ++ch)
+        {
+            auto* h = ir.getReadPointer(ch);
+            auto c = static_cast<size_t>(ch);
+
+            for (int j = 0; j < numPartitions; ++j)
+            {
+                auto start = 2 * partition + j * partition;
+                auto* re = kernel->tailSpectra[section].get((c * static_cast<size_t>(numPartitions) + static_cast<size_t>(j)) * stride);
+                forwardTransform(tailTransform, scratch.data(), h + start, juce::jmin(partition, length - start), re, re + paddedBins(partition + 1));
+            }
+        }
+    }
+
+    return kernel;
+}
+
+//==============================================================================
+void ConvolutionEngine::process(const juce::dsp::ProcessContextReplacing<float>& context)
+{
+    auto& inputBlock = context.getInputBlock();
+    auto& outputBlock = context.getOutputBlock();
+
+    if (context.usesSeparateInputAndOutputBlocks())
+        outputBlock.copyFrom(inputBlock);
+
+    if (context.isBypassed)
+    {
+        wasBypassed = true;
+        return;
+    }
+
+    // don't play back the tail of whatever came before it was switched out
+    if (wasBypassed)
+    {
+        reset();
+        wasBypassed = false;
+    }
+
+    // with no IR there is nothing to keep up: the first one starts from silence, like after reset()
+    auto hasKernel = [](const Kernel* kernel) { return kernel != nullptr && kernel->numChannels > 0; };
+
+    if (! hasKernel(slots[current].kernel) && nextState == NextState::Empty)
+    {
+        if (loader.incoming.load(std::memory_order_acquire) == nullptr)
+        {
+            mix.skip(static_cast<int>(outputBlock.getNumSamples()));
+            idle = true;
+            return;
+        }
+
+        if (idle)
+            reset();
+    }
+
+    idle = false;
+
+    auto channels = juce::jmin(outputBlock.getNumChannels(), numChannels);
+    auto numSamples = outputBlock.getNumSamples();
+
+    std::array<float, headLength> mixGain, fadeGain, wet, wetNext;
+
+    for (size_t pos = 0; pos < numSamples;)
+    {
+        auto segment = juce::jmin(static_cast<int>(numSamples - pos), headLength - framePos);
+        auto frameOffset = static_cast<size_t>(framePos);
+
+        auto fading = nextState == NextState::FadingOut && crossfadePos < crossfadeLength;
+
+        for (int i = 0; i < segment; ++i)
+        {
+            mixGain[static_cast<size_t>(i)] = mix.getNextValue();
+            fadeGain[static_cast<size_t>(i)] = juce::jmin(1.f, static_cast<float>(crossfadePos + i + 1) / static_cast<float>(crossfadeLength));
+        }
+
+        for (size_t ch = 0; ch < channels; ++ch)
+        {
+            auto* io = outputBlock.getChannelPointer(ch) + pos;
+            auto* x = history.get(ch * 2 * headLength + headLength + frameOffset);
+
+            std::copy_n(io, segment, x);
+
+            // what one slot's kernel makes of this segment, the dry signal for an empty slot
+            auto render = [&](const Slot& slot, float* dest)
+                {
+                    auto* kernel = slot.kernel;
+
+                    if (kernel == nullptr || kernel->numChannels == 0)
+                    {
+                        std::copy_n(x, segment, dest);
+                        return;
+                    }
+
+                    auto& h = kernel->head[juce::jmin(ch, kernel->numChannels - 1)];
+                    auto* headOut = slot.headOut.get(ch * headLength + frameOffset);
+
+                    std::array<const float*, numTailSections> tailOut;
+
+                    for (size_t section = 0; section < tails.size(); ++section)
+                    {
+                        auto& tail = tails[section];
+                        auto partition = static_cast<size_t>(tail.partition);
+
+                        tailOut[section] = slot.tailOut[section].get((ch * 2 + static_cast<size_t>(tail.readIndex)) * partition
+                                                                     + static_cast<size_t>(tail.fill) + frameOffset);
+                    }
+
+                    for (int i = 0; i < segment; ++i)
+                    {
+                        // x[i - headLength + 1] ... x[i], against the reversed head
+                        auto* window = x + i - headLength + 1;
+                        auto sum = 0.f;
+
+                        for (int k = 0; k < headLength; ++k)
+                            sum += h[static_cast<size_t>(k)] * window[k];
+
+                        dest[i] = sum + headOut[i] + tailOut[0][i] + tailOut[1][i];
+                    }
+                };
+
+            render(slots[current], wet.data());
+
+            if (fading)
+            {
+                render(slots[1 - current], wetNext.data());
+
+                for (int i = 0; i < segment; ++i)
+                    wet[static_cast<size_t>(i)] = wetNext[static_cast<size_t>(i)]
+                        + fadeGain[static_cast<size_t>(i)] * (wet[static_cast<size_t>(i)] - wetNext[static_cast<size_t>(i)]);
+            }
+
+            for (int i = 0; i < segment; ++i)
+                io[i] = x[i] + mixGain[static_cast<size_t>(i)] * (wet[static_cast<size_t>(i)] - x[i]);
+        }
+
+        if (fading)
+            crossfadePos = juce::jmin(crossfadeLength, crossfadePos + segment);
+
+        pos += static_cast<size_t>(segment);
+        framePos += segment;
+
+        if (framePos == headLength)
+        {
+            onFrameComplete();
+            framePos = 0;
+        }
+    }
+}
+
+bool ConvolutionEngine::isNextRunning() const noexcept
+{
+    return nextState == NextState::Warming || (nextState == NextState::FadingOut && crossfadePos < crossfadeLength);
+}
+
+void ConvolutionEngine::onFrameComplete()
+{
+    auto* scratch = fftScratch.get();
+    auto headStride = spectrumStride(headBins);
+
+    headDelayWrite = (headDelayWrite + 1) % maxHeadPartitions;
+    numHeadWritten = juce::jmin(maxHeadPartitions, numHeadWritten + 1);
+
+    for (size_t ch = 0; ch < numChannels; ++ch)
+    {
+        auto* frameHistory = history.get(ch * 2 * headLength);
+
+        for (auto& tail : tails)
+        {
+            auto partition = static_cast<size_t>(tail.partition);
+            std::copy_n(frameHistory + headLength, headLength, tail.input.get(ch * 2 * partition + partition + static_cast<size_t>(tail.fill)));
+        }
+
+        // the previous frame and this one, for the 64-sample partitions
+        auto* re = headDelayLine.get((ch * maxHeadPartitions + static_cast<size_t>(headDelayWrite)) * headStride);
+        forwardTransform(headFFT, scratch, frameHistory, 2 * headLength, re, re + paddedBins(headBins));
+    }
+
+    std::array<bool, numTailSections> atBoundary{};
+
+    for (size_t section = 0; section < tails.size(); ++section)
+    {
+        auto& tail = tails[section];
+        tail.fill += headLength;
+
+        if (tail.fill == tail.partition)
+        {
+            onTailBoundary(tail);
+            tail.fill = 0;
+            atBoundary[section] = true;
+        }
+    }
+
+    // a kernel that has run for a whole job of its longest section has everything it needs: it takes over
+    if (nextState == NextState::Warming)
+    {
+        if (atBoundary[warmingSection])
+        {
+            if (warmingJobStarted)
+            {
+                current = 1 - current;
+                nextState = NextState::FadingOut;
+                crossfadePos = 0;
+            }
+
+            warmingJobStarted = true;
+        }
+    }
+    else if (nextState == NextState::Empty && atBoundary[0] && loader.incoming.load() != nullptr)
+    {
+        // flagged before it's taken, see Loader::isSwapInProgress()
+        loader.swapping = true;
+
+        if (auto* kernel = loader.incoming.exchange(nullptr, std::memory_order_acq_rel))
+        {
+            auto& next = slots[1 - current];
+            next.kernel = kernel;
+            clearSlot(next);
+            nextState = NextState::Warming;
+
+            // a job of the section already under way when the kernel comes in doesn't count
+            warmingSection = kernel->getLongestTailSection();
+            warmingJobStarted = atBoundary[warmingSection];
+        }
+        else
+        {
+            loader.swapping = false;
+        }
+    }
+
+    // a finished fade hands its kernel back to be freed; if the last one hasn't been collected
+    // yet, it's tried again next frame and the kernel is no longer convolved meanwhile
+    if (nextState == NextState::FadingOut && crossfadePos >= crossfadeLength)
+    {
+        auto& next = slots[1 - current];
+        Kernel* expected = nullptr;
+
+        if (next.kernel == nullptr || loader.outgoing.compare_exchange_strong(expected, next.kernel, std::memory_order_acq_rel))
+        {
+            next.kernel = nullptr;
+            nextState = NextState::Empty;
+            loader.swapping = false;
+        }
+    }
+
+    for (size_t s = 0; s < slots.size(); ++s)
+        if (s == current || isNextRunning())
+            for (size_t ch = 0; ch < numChannels; ++ch)
+                convolveHead(slots[s], ch);
+
+    for (size_t section = 0; section < tails.size(); ++section)
+        if (tails[section].jobStep < tails[section].framesPerJob)
+            runTailJobStep(section, tails[section].jobStep++);
+
+    // this frame becomes the previous one
+    for (size_t ch = 0; ch < numChannels; ++ch)
+    {
+        auto* frameHistory = history.get(ch * 2 * headLength);
+        std::copy_n(frameHistory + headLength, headLength, frameHistory);
+    }
+}
+
+void ConvolutionEngine::onTailBoundary(TailSection& tail)
+{
+    auto* scratch = fftScratch.get();
+    auto partition = static_cast<size_t>(tail.partition);
+    auto stride = spectrumStride(tail.bins);
+
+    if (tail.maxPartitions > 0)
+    {
+        tail.delayWrite = (tail.delayWrite + 1) % tail.maxPartitions;
+        tail.numWritten = juce::jmin(tail.maxPartitions, tail.numWritten + 1);
+
+        for (size_t ch = 0; ch < numChannels; ++ch)
+        {
+            auto* input = tail.input.get(ch * 2 * partition);
+
+            auto* re = tail.delayLine.get((ch * static_cast<size_t>(tail.maxPartitions) + static_cast<size_t>(tail.delayWrite)) * stride);
+            forwardTransform(tail.fft, scratch, input, 2 * tail.partition, re, re + paddedBins(tail.bins));
+
+            std::copy_n(input + partition, partition, input);
+        }
+    }
+
+    // the job that just finished wrote the other half
+    tail.readIndex = 1 - tail.readIndex;
+    tail.jobStep = 0;
+}
+
+void ConvolutionEngine::runTailJobStep(size_t section, int step)
+{
+    auto& tail = tails[section];
+    auto stride = spectrumStride(tail.bins);
+
+    for (size_t s = 0; s < slots.size(); ++s)
+    {
+        auto& slot = slots[s];
+        auto* kernel = slot.kernel;
+
+        if ((s != current && ! isNextRunning()) || kernel == nullptr || kernel->numChannels == 0)
+            continue;
+
+        // the same share of the partitions every frame; the ones older than the last reset() are silence
+        auto numPartitions = juce::jmin(kernel->numTailPartitions[section], tail.numWritten);
+        auto first = step * numPartitions / tail.framesPerJob;
+        auto last = (step + 1) * numPartitions / tail.framesPerJob;
+
+        for (size_t ch = 0; ch < numChannels; ++ch)
+        {
+            auto* acc = slot.tailAcc[section].get(ch * stride);
+
+            if (step == 0)
+                std::fill(acc, acc + stride, 0.f);
+
+            accumulateTail(slot, section, ch, first, last);
+
+            if (step == tail.framesPerJob - 1)
+            {
+                auto* scratch = fftScratch.get();
+                inverseTransform(tail.fft, scratch, acc, acc + paddedBins(tail.bins));
+
+                auto partition = static_cast<size_t>(tail.partition);
+                auto* out = slot.tailOut[section].get((ch * 2 + static_cast<size_t>(1 - tail.readIndex)) * partition);
+                std::copy_n(scratch + partition, partition, out);
+            }
+        }
+    }
+}
+
+void ConvolutionEngine::convolveHead(Slot& slot, size_t ch)
+{
+    auto* kernel = slot.kernel;
+
+    if (kernel == nullptr || kernel->numChannels == 0)
+        return;
+
+    auto headStride = spectrumStride(headBins);
+    auto kernelChannel = juce::jmin(ch, kernel->numChannels - 1);
+
+    // accumulated at the end of the scratch, the transform uses the start
+    auto* scratch = fftScratch.get();
+    auto* accRe = scratch + fftScratch.size - 2 * paddedBins(headBins);
+    auto* accIm = accRe + paddedBins(headBins);
+
+    std::fill(accRe, accRe + 2 * paddedBins(headBins), 0.f);
+
+    for (int j = 0; j < juce::jmin(kernel->numHeadPartitions, numHeadWritten); ++j)
+    {
+        auto line = static_cast<size_t>((headDelayWrite - j + maxHeadPartitions) % maxHeadPartitions);
+        auto* x = headDelayLine.get((ch * maxHeadPartitions + line) * headStride);
+        auto* h = kernel->headSpectra.get((kernelChannel * static_cast<size_t>(kernel->numHeadPartitions) + static_cast<size_t>(j)) * headStride);
+
+        multiplyAccumulate(accRe, accIm, x, x + paddedBins(headBins), h, h + paddedBins(headBins), headBins);
+    }
+
+    inverseTransform(headFFT, scratch, accRe, accIm);
+    std::copy_n(scratch + headLength, headLength, slot.headOut.get(ch * headLength));
+}
+
+void ConvolutionEngine::accumulateTail(Slot& slot, size_t section, size_t ch, int firstPartition, int lastPartition)
+{
+    auto& tail = tails[section];
+    auto* kernel = slot.kernel;
+    auto stride = spectrumStride(tail.bins);
+    auto kernelChannel = juce::jmin(ch, kernel->numChannels - 1);
+    auto numKernelPartitions = static_cast<size_t>(kernel->numTailPartitions[section]);
+
+    auto* acc = slot.tailAcc[section].get(ch * stride);
+
+    for (int j = firstPartition; j < lastPartition; ++j)
+    {
+        auto line = static_cast<size_t>((tail.delayWrite - j + tail.maxPartitions) % tail.maxPartitions);
+        auto* x = tail.delayLine.get((ch * static_cast<size_t>(tail.maxPartitions) + line) * stride);
+        auto* h = kernel->tailSpectra[section].get((kernelChannel * numKernelPartitions + static_cast<size_t>(j)) * stride);
+
+        multiplyAccumulate(acc, acc + paddedBins(tail.bins), x, x + paddedBins(tail.bins), h, h + paddedBins(tail.bins), tail.bins);
+    }
+}
+
+void ConvolutionEngine::multiplyAccumulate(float* accRe, float* accIm, const float* aRe, const float* aIm,
+                                           const float* bRe, const float* bIm, int numBins) noexcept
+{
+    // split real / imaginary arrays: four independent streams the compiler vectorises
+    for (int k = 0; k < numBins; ++k)
+    {
+        accRe[k] += aRe[k] * bRe[k] - aIm[k] * bIm[k];
+        accIm[k] += aRe[k] * bIm[k] + aIm[k] * bRe[k];
+    }
+}
+
+void ConvolutionEngine::copyChannelState(size_t source, size_t destination) noexcept
+{
+    jassert(source < maxChannels && destination < maxChannels);
+
+    auto copyChannel = [source, destination](AlignedBuffer& buffer, size_t channelSize)
+        {
+            if (buffer.data != nullptr)
+                std::copy_n(buffer.get(source * channelSize), channelSize, buffer.get(destination * channelSize));
+        };
+
+    copyChannel(history, 2 * headLength);
+    copyChannel(headDelayLine, maxHeadPartitions * spectrumStride(headBins));
+
+    for (auto& tail : tails)
+    {
+        copyChannel(tail.input, 2 * static_cast<size_t>(tail.partition));
+        copyChannel(tail.delayLine, static_cast<size_t>(tail.maxPartitions) * spectrumStride(tail.bins));
+    }
+
+    for (auto& slot : slots)
+    {
+        copyChannel(slot.headOut, headLength);
+
+        for (size_t section = 0; section < tails.size(); ++section)
+        {
+            copyChannel(slot.tailAcc[section], spectrumStride(tails[section].bins));
+            copyChannel(slot.tailOut[section], 2 * static_cast<size_t>(tails[section].partition));
+        }
+    }
+}
+
+bool ConvolutionEngine::hasStereoKernel() const noexcept
+{
+    auto isStereo = [](const Kernel* kernel) { return kernel != nullptr && kernel->numChannels > 1; };
+
+    return isStereo(slots[current].kernel)
+        || (nextState != NextState::Empty && isStereo(slots[1 - current].kernel))
+        || isStereo(loader.incoming.load(std::memory_order_acquire));
+}
@@ -0,0 +1,276 @@
+/*
+  ==============================================================================
+
+    ConvolutionEngine.h
+
+    Zero-latency stereo convolution for cabinet / room impulse responses,
+    with IRs loaded and swapped in the background.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+    Non-uniformly partitioned, four sections of the IR:
+
+        [0, 64)         direct form FIR, no latency
+        [64, 2048)      64-sample partitions, 128-point FFTs every 64 samples
+        [2048, 8192)    1024-sample partitions, 2048-point FFTs
+        [8192, 2 s)     4096-sample partitions, 8192-point FFTs
+
+    The first two are computed whenever a 64-sample frame of input is
+    complete. The last two, the tail sections, each have one partition of
+    their own length as slack (their partitions start two of their lengths
+    in), so each job - forward FFT, the multiply-accumulate over every
+    partition, inverse FFT - is spread evenly over the frames that follow
+    it: 16 for the 1024-sample section, 64 for the 4096-sample one. The
+    long partitions keep the late tail cheap: at 48 kHz a 2 s IR is 6 + 22
+    tail partitions, about 1800 bins to accumulate per frame, where
+    1024-sample partitions all the way would be 92 and about 5900.
+
+    loadImpulseResponse() hands the file to a loader thread shared by every
+    engine in the process, which decodes, trims, normalises and resamples it
+    and builds a Kernel (the partition spectra). The audio thread picks it
+    up through an atomic pointer at the next boundary of the longest tail
+    section it uses, runs it silently for one job of that section so its
+    tail is complete, then crossfades from the previous kernel (or the dry
+    signal). Retired kernels go back the same way, and the loader thread
+    keeps looking for them until the swap is over, so they are freed off
+    the audio thread however long the swap took. With no IR loaded the
+    stage passes its input through and does no work.
+
+    reset() leaves the frequency-domain delay lines (1.4 MB for 2 s at
+    48 kHz) as they are: partitions that haven't been written since are
+    skipped rather than cleared.
+*/
+class ConvolutionEngine : public juce::dsp::ProcessorBase
+{
+public:
+    static constexpr size_t maxChannels = 2;
+
+    static constexpr int headLength = 64;
+
+    // each starts at twice its partition length and ends where the next starts
+    static constexpr int numTailSections = 2;
+    static constexpr std::array<int, numTailSections> tailPartitions{ 1024, 4096 };
+    static constexpr int tailStart = 2 * tailPartitions[0];
+
+    static constexpr double maxLengthSeconds = 2.0;
+    static constexpr double crossfadeSeconds = 0.05;
+
+    ConvolutionEngine();
+    ~ConvolutionEngine() override;
+
+    void prepare(const juce::dsp::ProcessSpec& spec) override;
+    void process(const juce::dsp::ProcessContextReplacing<float>& context) override;
+    void reset() override;
+
+    // frees what prepare() allocated, and every kernel; prepare() again before the next process()
+    void releaseResources();
+
+    void setMix(float newMix) noexcept { mix.setTargetValue(newMix); }
+
+    // audio thread: the mono path can't be used with a stereo IR, playing or about to
+    bool hasStereoKernel() const noexcept;
+    void copyChannelState(size_t source, size_t destination) noexcept;
+
+    // any thread but the audio thread. A mono IR is used for both channels
+    void loadImpulseResponse(const juce::File& file);
+    void clearImpulseResponse();
+
+    /*
+        Any thread: load and build kernels on the thread that asks for them,
+        in loadImpulseResponse() and prepare(), instead of on the loader
+        thread. The kernel is then waiting for the audio thread when the call
+        returns, so offline renders and replays pick it up at the same sample
+        every time, however fast the machine.
+    */
+    void setSynchronousLoading(bool shouldBeSynchronous) noexcept { synchronousLoading = shouldBeSynchronous; }
+
+    // of the IR as read and trimmed, 0 until a file has been read
+    double getImpulseResponseLengthSeconds() const;
+
+private:
+    // float storage starting on a 32-byte boundary, for the FFTs and the spectrum loops
+    struct AlignedBuffer
+    {
+        void allocate(size_t numFloats)
+        {
+            storage.calloc(numFloats + alignment);
+            auto address = reinterpret_cast<std::uintptr_t>(storage.get());
+            data = reinterpret_cast<float*>((address + alignment * sizeof(float) - 1) & ~(alignment * sizeof(float) - 1));
+            size = numFloats;
+        }
+
+        void free() { storage.free(); data = nullptr; size = 0; }
+        void clear() { if (data != nullptr) std::fill(data, data + size, 0.f); }
+
+        float* get(size_t offset = 0) const noexcept { return data + offset; }
+
+        static constexpr size_t alignment = 8;
+
+        juce::HeapBlock<float> storage;
+        float* data = nullptr;
+        size_t size = 0;
+    };
+
+    // bins of a real FFT of 2 * partition points, kept as separate real and imaginary arrays
+    static constexpr int headBins = headLength + 1;
+
+    struct Kernel
+    {
+        double sampleRate = 0.0;
+        size_t numChannels = 0;
+
+        std::array<std::array<float, headLength>, maxChannels> head{};  // reversed, for the dot product
+        int numHeadPartitions = 0;
+        std::array<int, numTailSections> numTailPartitions{};
+
+        // [channel][partition][re bins, im bins]
+        AlignedBuffer headSpectra;
+        std::array<AlignedBuffer, numTailSections> tailSpectra;
+
+        // the section whose jobs a swap to this kernel waits for: the longest with any partitions
+        size_t getLongestTailSection() const noexcept;
+    };
+
+    // the engine's side of the loader thread; the lock guards everything but the atomics
+    struct Loader
+    {
+        ~Loader();
+
+        mutable std::mutex lock;
+        int generation = 0;
+        double sampleRate = 0.0;
+
+        // a file to read, and whether the kernel has to be built (again) for the source and rate
+        juce::File pendingFile;
+        bool readPending = false, buildPending = false;
+
+        // the decoded file at its own rate, kept to rebuild when the sample rate changes
+        std::shared_ptr<const juce::AudioBuffer<float>> source;
+        double sourceRate = 0.0;
+
+        // owned by whichever side holds the pointer
+        std::atomic<Kernel*> incoming{ nullptr };
+        std::atomic<Kernel*> outgoing{ nullptr };
+
+        // audio thread: from picking a kernel up until the one it replaced has been handed back
+        std::atomic<bool> swapping{ false };
+
+        void publish(Kernel* kernel);
+        void collectGarbage();
+
+        // a kernel on its way in, playing in or on its way out
+        bool isSwapInProgress() const noexcept;
+    };
+
+    class Worker;
+    friend class Worker;
+
+    // loader thread, or the caller when loading synchronously: reads the pending file, builds the kernel
+    // and frees retired ones
+    void service();
+
+    // runs service() here when synchronous, otherwise on the loader thread
+    void requestService();
+
+    static std::unique_ptr<Kernel> buildKernel(const juce::AudioBuffer<float>& source, double sourceRate, double sampleRate);
+    static std::shared_ptr<const juce::AudioBuffer<float>> readFile(const juce::File& file, double& sampleRate);
+
+    static int getMaxTailPartitions(size_t section, double sampleRate) noexcept;
+
+    // one channel's share of a kernel, at a frame / tail job boundary
+    struct Slot
+    {
+        Kernel* kernel = nullptr;
+
+        AlignedBuffer headOut;                                  // [channel][headLength] for the frame being output
+        std::array<AlignedBuffer, numTailSections> tailAcc;     // [channel][re bins, im bins] of the tail job in progress
+        std::array<AlignedBuffer, numTailSections> tailOut;     // [channel][2][partition], one read while the other is written
+    };
+
+    // the input side of a tail section, which both slots read
+    struct TailSection
+    {
+        explicit TailSection(size_t section);
+
+        const int partition, bins, framesPerJob;
+        juce::dsp::FFT fft;
+        int maxPartitions = 0;
+
+        // [channel][2 * partition]: the previous partition, then the one being filled
+        AlignedBuffer input;
+        int fill = 0;
+        int jobStep = 0;
+        int readIndex = 0;
+
+        // frequency-domain delay line: [channel][partition][re bins, im bins], newest at the write index.
+        // Only the newest numWritten have been written since reset(), the rest are stale
+        AlignedBuffer delayLine;
+        int delayWrite = 0;
+        int numWritten = 0;
+    };
+
+    void allocateSlot(Slot& slot);
+    void clearSlot(Slot& slot);
+
+    // the next slot's kernel is being convolved: warming up, or still heard in a fade
+    bool isNextRunning() const noexcept;
+
+    void onFrameComplete();
+    void onTailBoundary(TailSection& tail);
+    void runTailJobStep(size_t section, int step);
+
+    void convolveHead(Slot& slot, size_t channel);
+    void accumulateTail(Slot& slot, size_t section, size_t channel, int firstPartition, int lastPartition);
+
+    static void multiplyAccumulate(float* accRe, float* accIm, const float* aRe, const float* aIm,
+                                   const float* bRe, const float* bIm, int numBins) noexcept;
+
+    Loader loader;
+    juce::SharedResourcePointer<Worker> worker;
+
+    // held by service(), which the loader thread and a synchronous caller may both be running
+    std::mutex serviceLock;
+    std::atomic<bool> synchronousLoading{ false };
+
+    double sampleRate = 44100.0;
+    size_t numChannels = 2;
+
+    juce::dsp::FFT headFFT{ 7 };
+
+    // [channel][2 * headLength]: the previous frame, then the one being filled
+    AlignedBuffer history;
+    int framePos = 0;
+
+    // [channel][partition][re bins, im bins] like the tail sections', with the same staleness
+    AlignedBuffer headDelayLine;
+    int headDelayWrite = 0;
+    int numHeadWritten = 0;
+
+    std::array<TailSection, numTailSections> tails{ TailSection(0), TailSection(1) };
+
+    AlignedBuffer fftScratch;
+
+    // current is the kernel heard; next is either one warming up or the previous one fading out
+    enum class NextState { Empty, Warming, FadingOut };
+
+    std::array<Slot, 2> slots;
+    size_t current = 0;
+    NextState nextState = NextState::Empty;
+    int crossfadeLength = 1, crossfadePos = 0;
+
+    // a warming kernel takes over at the end of the first whole job of this section
+    size_t warmingSection = 0;
+    bool warmingJobStarted = false;
+
+    juce::SmoothedValue<float> mix;
+    bool wasBypassed = false;
+    bool idle = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ConvolutionEngine)
+};
@@ -0,0 +1,154 @@
+/*
+  ==============================================================================
+
+    CpuGovernor.cpp
+
+  ==============================================================================
+*/
+
+#include "CpuGovernor.h"
+
+void CpuGovernor::prepare(double newSampleRate)
+{
+    jassert(newSampleRate > 0);
+    sampleRate = newSampleRate;
+    reset();
+}
+
+void CpuGovernor::reset() noexcept
+{
+    load = 0.f;
+    level = juce::jmax(0, forcedLevel);
+    secondsSinceStep = 0.0;
+    secondsBelowRecover = 0.0;
+
+    publishedLoad = 0.f;
+    publishedPeakLoad = 0.f;
+    publishedLevel = level;
+}
+
+void CpuGovernor::setEnabled(bool shouldBeEnabled) noexcept
+{
+    if (shouldBeEnabled == enabled)
+        return;
+
+    enabled = shouldBeEnabled;
+
+    if (! enabled)
+    {
+        level = 0;
+        publishedLevel = 0;
+    }
+}
+
+void CpuGovernor::setForcedLevel(int newLevel) noexcept
+{
+    jassert(newLevel <= maxLevel);
+
+    forcedLevel = newLevel;
+
+    if (forcedLevel >= 0)
+    {
+        level = forcedLevel;
+        publishedLevel = level;
+    }
+}
+
+void CpuGovernor::endBlock(int numSamples) noexcept
+{
+    if (numSamples <= 0)
+        return;
+
+    auto elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - blockStartTicks);
+    auto deadline = numSamples / sampleRate;
+    auto blockLoad = static_cast<float>(elapsed / deadline);
+
+    blockCount.fetch_add(1, std::memory_order_relaxed);
+
+    if (blockLoad > 1.f)
+        overrunCount.fetch_add(1, std::memory_order_relaxed);
+
+    if (blockLoad > publishedPeakLoad.load(std::memory_order_relaxed))
+        publishedPeakLoad.store(blockLoad, std::memory_order_relaxed);
+
+    auto bin = juce::jmin(static_cast<size_t>(blockLoad * 10.f), numLoadBins - 1);
+    loadHistogram[bin].fetch_add(1, std::memory_order_relaxed);
+
+    if (! enabled || forcedLevel >= 0)
+        return;
+
+    // ~50ms attack, ~1s release, independent of the block size
+    auto timeConstant = blockLoad > load ? 0.05 : 1.0;
+    auto alpha = static_cast<float>(1.0 - std::exp(-deadline / timeConstant));
+    load += (blockLoad - load) * alpha;
+
+    secondsSinceStep += deadline;
+    secondsBelowRecover = load < recoverLoad ? secondsBelowRecover + deadline : 0.0;
+
+    if (load > degradeLoad && level < maxLevel && secondsSinceStep >= stepHoldSeconds)
+    {
+        ++level;
+        secondsSinceStep = 0.0;
+        secondsBelowRecover = 0.0;
+        degradeCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    else if (level > 0 && secondsBelowRecover >= recoverHoldSeconds)
+    {
+        --level;
+        secondsSinceStep = 0.0;
+        secondsBelowRecover = 0.0;
+    }
+
+    publishedLoad.store(load, std::memory_order_relaxed);
+    publishedLevel.store(level, std::memory_order_relaxed);
+}
+
+QualitySettings CpuGovernor::apply(QualitySettings settings) const noexcept
+{
+    if (level >= 1)
+    {
+        settings.doublePrecision = false;
+        settings.tableCoefficients = true;
+
+        if (settings.saturation == SaturationKernel::Exact)
+            settings.saturation = SaturationKernel::LookupTable;
+    }
+
+    if (level >= 2)
+    {
+        auto normal = QualitySettings::forMode(QualityMode::Normal);
+
+        settings.saturation = SaturationKernel::FastApproximation;
+        settings.modulationInterval = juce::jmax(settings.modulationInterval, normal.modulationInterval);
+        settings.phaserControlInterval = juce::jmax(settings.phaserControlInterval, normal.phaserControlInterval);
+        settings.chorusControlInterval = juce::jmax(settings.chorusControlInterval, normal.chorusControlInterval);
+    }
+
+    if (level >= 3)
+    {
+        auto eco = QualitySettings::forMode(QualityMode::Eco);
+
+        settings.oversampling = false;
+        settings.modulationInterval = juce::jmax(settings.modulationInterval, eco.modulationInterval);
+        settings.phaserControlInterval = juce::jmax(settings.phaserControlInterval, eco.phaserControlInterval);
+        settings.chorusControlInterval = juce::jmax(settings.chorusControlInterval, eco.chorusControlInterval);
+        settings.maxPhaserStages = juce::jmin(settings.maxPhaserStages, eco.maxPhaserStages);
+    }
+
+    return settings;
+}
+
+CpuGovernor::Stats CpuGovernor::getStats() const noexcept
+{
+    Stats stats;
+    stats.load = publishedLoad.load(std::memory_order_relaxed);
+    stats.peakLoad = publishedPeakLoad.load(std::memory_order_relaxed);
+    stats.level = publishedLevel.load(std::memory_order_relaxed);
+    stats.degradeCount = degradeCount.load(std::memory_order_relaxed);
+    stats.overrunCount = overrunCount.load(std::memory_order_relaxed);
+    stats.blockCount = blockCount.load(std::memory_order_relaxed);
+
+    for (size_t i = 0; i < numLoadBins; ++i)
+        stats.loadHistogram[i] = loadHistogram[i].load(std::memory_order_relaxed);
+    return stats;
+}
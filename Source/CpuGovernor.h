@@ -0,0 +1,98 @@
+/*
+  ==============================================================================
+
+    CpuGovernor.h
+
+    Watches how long each block takes against its deadline and steps
+    processing quality down when the headroom runs out.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Quality.h"
+
+/*
+    Audio thread: beginBlock() / endBlock() around the work of a block, then
+    apply() the level to whatever QualitySettings the user asked for.
+
+    Load is the fraction of the block's real-time deadline spent processing,
+    smoothed with a fast attack and a slow release. Above degradeLoad the
+    level goes up one step (at most once per stepHoldSeconds); it comes back
+    down one step only after the load has stayed below recoverLoad for
+    recoverHoldSeconds, so it doesn't bounce between two levels.
+
+    Levels:
+        0: as selected
+        1: no double precision, table tanh / coefficients instead of exact
+        2: approximate tanh, modulation / control updates no finer than Normal
+        3: no oversampling (latency is held), Eco intervals and phaser stages
+
+    Every block's load also lands in a histogram, enabled or not, so a host
+    or a test harness can read the latency distribution and deadline misses.
+
+    getStats() can be called from any thread.
+*/
+class CpuGovernor
+{
+public:
+    static constexpr int maxLevel = 3;
+
+    static constexpr float degradeLoad = 0.7f;
+    static constexpr float recoverLoad = 0.4f;
+    static constexpr double stepHoldSeconds = 0.25;
+    static constexpr double recoverHoldSeconds = 2.0;
+
+    // 10% of the deadline per bin, the last one counts everything from 110% up
+    static constexpr size_t numLoadBins = 12;
+
+    void prepare(double sampleRate);
+    void reset() noexcept;
+
+    // off while the host renders offline: there is no deadline to miss
+    void setEnabled(bool shouldBeEnabled) noexcept;
+
+    // holds the level instead of following the load, for a replay of a recorded session; -1 to follow it again
+    void setForcedLevel(int newLevel) noexcept;
+
+    void beginBlock() noexcept { blockStartTicks = juce::Time::getHighResolutionTicks(); }
+    void endBlock(int numSamples) noexcept;
+
+    int getLevel() const noexcept { return level; }
+
+    // smoothed, 1 = the whole deadline; audio thread, other threads use getStats()
+    float getLoad() const noexcept { return load; }
+
+    QualitySettings apply(QualitySettings settings) const noexcept;
+
+    struct Stats
+    {
+        float load = 0.f;           // smoothed, 1 = the whole deadline
+        float peakLoad = 0.f;       // worst single block since reset
+        int level = 0;
+        juce::uint32 degradeCount = 0;  // times the level has stepped down
+        juce::uint32 overrunCount = 0;  // blocks that took longer than their deadline
+        juce::uint32 blockCount = 0;
+        std::array<juce::uint32, numLoadBins> loadHistogram{};
+    };
+
+    Stats getStats() const noexcept;
+
+private:
+    double sampleRate = 44100.0;
+    bool enabled = true;
+
+    juce::int64 blockStartTicks = 0;
+    float load = 0.f;
+    int level = 0;
+    int forcedLevel = -1;
+    double secondsSinceStep = 0.0;
+    double secondsBelowRecover = 0.0;
+
+    std::atomic<float> publishedLoad{ 0.f }, publishedPeakLoad{ 0.f };
+    std::atomic<int> publishedLevel{ 0 };
+    std::atomic<juce::uint32> degradeCount{ 0 }, overrunCount{ 0 }, blockCount{ 0 };
+    std::array<std::atomic<juce::uint32>, numLoadBins> loadHistogram{};
+};
@@ -0,0 +1,418 @@
+/*
+  ==============================================================================
+
+    DelayEngine.cpp
+
+  ==============================================================================
+*/
+
+#include "DelayEngine.h"
+
+void DelayEngine::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    jassert(spec.sampleRate > 0);
+    jassert(spec.numChannels > 0 && spec.numChannels <= maxChannels);
+
+    sampleRate = spec.sampleRate;
+
+    // + 2 for the interpolation partner and the sample being written
+    bufferLength = static_cast<int>(std::ceil(maxDelayMs * sampleRate / 1000.0)) + 2;
+
+    for (auto& b : buffer)
+        b.assign(static_cast<size_t>(bufferLength) * 2, 0.f);
+
+    for (auto& s : scratch)
+        s.assign(juce::jmax<size_t>(1, spec.maximumBlockSize), 0.f);
+
+    for (auto& s : feedbackScratch)
+        s.assign(juce::jmax<size_t>(1, spec.maximumBlockSize), 0.f);
+
+    rampLength = juce::jmax(1, static_cast<int>(rampTimeSeconds * sampleRate));
+    feedback.reset(sampleRate, rampTimeSeconds);
+    mix.reset(sampleRate, rampTimeSeconds);
+
+    filterDirty = true;
+    reset();
+}
+
+void DelayEngine::reset()
+{
+    for (auto& b : buffer)
+        std::fill(b.begin(), b.end(), 0.f);
+
+    writePos = 0;
+    restart();
+
+    // all zeros already, nothing left to clear
+    freshSamples = bufferLength;
+}
+
+void DelayEngine::restart() noexcept
+{
+    lowCutState.fill(0.f);
+    highCutState.fill(0.f);
+
+    feedback.setCurrentAndTargetValue(feedback.getTargetValue());
+    mix.setCurrentAndTargetValue(mix.getTargetValue());
+
+    updateControl();
+    delaySamples = delayTarget;
+    delayIncrement = 0.f;
+    rampRemaining = 0;
+
+    freshSamples = 0;
+}
+
+void DelayEngine::clearStale(int oldestDistance, int newestDistance) noexcept
+{
+    auto length = static_cast<size_t>(bufferLength);
+
+    // distance d is the sample written d samples before the one at writePos
+    for (auto d = juce::jmax(newestDistance, freshSamples + 1); d <= juce::jmin(oldestDistance, bufferLength); ++d)
+    {
+        auto p = static_cast<size_t>((writePos - d + bufferLength) % bufferLength);
+
+        for (auto& b : buffer)
+        {
+            b[p] = 0.f;
+            b[p + length] = 0.f;
+        }
+    }
+}
+
+void DelayEngine::releaseResources()
+{
+    for (auto& b : buffer)
+        std::vector<float>().swap(b);
+
+    for (auto& s : scratch)
+        std::vector<float>().swap(s);
+
+    for (auto& s : feedbackScratch)
+        std::vector<float>().swap(s);
+
+    bufferLength = 0;
+    writePos = 0;
+}
+
+void DelayEngine::setFeedbackFilter(float newLowCutHz, float newHighCutHz) noexcept
+{
+    if (newLowCutHz == lowCutHz && newHighCutHz == highCutHz)
+        return;
+
+    lowCutHz = newLowCutHz;
+    highCutHz = newHighCutHz;
+    filterDirty = true;
+}
+
+void DelayEngine::updateControl() noexcept
+{
+    auto target = juce::jlimit(minimumDelayMs, maxDelayMs, targetDelayMs) * static_cast<float>(sampleRate) / 1000.f;
+    target = juce::jlimit(2.f, static_cast<float>(bufferLength - 2), target);
+
+    if (target != delayTarget)
+    {
+        delayTarget = target;
+        rampRemaining = rampLength;
+        delayIncrement = (delayTarget - delaySamples) / static_cast<float>(rampLength);
+    }
+
+    if (filterDirty)
+    {
+        auto nyquistSafe = static_cast<float>(0.49 * sampleRate);
+
+        auto g = std::tan(juce::MathConstants<float>::pi * juce::jmin(lowCutHz, nyquistSafe) / static_cast<float>(sampleRate));
+        lowCutG = g / (1.f + g);
+
+        g = std::tan(juce::MathConstants<float>::pi * juce::jmin(highCutHz, nyquistSafe) / static_cast<float>(sampleRate));
+        highCutG = g / (1.f + g);
+
+        filterDirty = false;
+    }
+}
+
+void DelayEngine::process(const juce::dsp::ProcessContextReplacing<float>& context)
+{
+    auto& inputBlock = context.getInputBlock();
+    auto& outputBlock = context.getOutputBlock();
+
+    if (context.usesSeparateInputAndOutputBlocks())
+        outputBlock.copyFrom(inputBlock);
+
+    if (context.isBypassed)
+    {
+        wasBypassed = true;
+        return;
+    }
+
+    // don't play back whatever was left in the line when it was switched out; clearing it
+    // all here would be a 1.5 MB memset on the audio thread, see clearStale()
+    if (wasBypassed)
+    {
+        restart();
+        wasBypassed = false;
+    }
+
+    updateControl();
+
+    auto numChannels = juce::jmin(outputBlock.getNumChannels(), maxChannels);
+    auto numSamples = outputBlock.getNumSamples();
+    auto maxSegment = static_cast<int>(scratch[0].size());
+
+    for (size_t pos = 0; pos < numSamples;)
+    {
+        auto steady = rampRemaining == 0 && ! feedback.isSmoothing() && ! mix.isSmoothing();
+
+        // a segment never crosses the end of the buffer
+        auto segment = juce::jmin(bufferLength - writePos, static_cast<int>(numSamples - pos), maxSegment);
+
+        if (steady)
+        {
+            // ...and never reads anything it writes itself
+            segment = juce::jmin(segment, static_cast<int>(delaySamples));
+
+            if (freshSamples < bufferLength)
+            {
+                auto oldest = static_cast<int>(delaySamples) + 1;
+                clearStale(oldest, oldest - segment);
+            }
+
+            if (numChannels == 2)
+                processSteady<2>(outputBlock, pos, segment);
+            else
+                processSteady<1>(outputBlock, pos, segment);
+        }
+        else
+        {
+            if (rampRemaining > 0)
+                segment = juce::jmin(segment, rampRemaining);
+
+            if (freshSamples < bufferLength)
+            {
+                auto end = rampRemaining > 0 ? delaySamples + delayIncrement * static_cast<float>(segment) : delaySamples;
+                clearStale(static_cast<int>(juce::jmax(delaySamples, end)) + 1,
+                           static_cast<int>(juce::jmin(delaySamples, end)) - segment + 1);
+            }
+
+            if (numChannels == 2)
+                processRamped<2>(outputBlock, pos, segment);
+            else
+                processRamped<1>(outputBlock, pos, segment);
+        }
+
+        pos += static_cast<size_t>(segment);
+        writePos += segment;
+        freshSamples = juce::jmin(bufferLength, freshSamples + segment);
+
+        if (writePos == bufferLength)
+            writePos = 0;
+    }
+
+    for (auto& v : lowCutState)
+        v = juce::dsp::util::snapToZero(v);
+
+    for (auto& v : highCutState)
+        v = juce::dsp::util::snapToZero(v);
+}
+
+void DelayEngine::copyChannelState(size_t source, size_t destination) noexcept
+{
+    jassert(source < maxChannels && destination < maxChannels);
+
+    std::copy(buffer[source].begin(), buffer[source].end(), buffer[destination].begin());
+    lowCutState[destination] = lowCutState[source];
+    highCutState[destination] = highCutState[source];
+}
+
+template<size_t Lanes>
+void DelayEngine::filterFeedback(std::array<float*, Lanes> wet, int numSamples) noexcept
+{
+    for (int i = 0; i < numSamples; ++i)
+    {
+        // one lane per channel
+        for (size_t ch = 0; ch < Lanes; ++ch)
+        {
+            auto x = wet[ch][i];
+
+            auto v = (x - lowCutState[ch]) * lowCutG;
+            auto low = v + lowCutState[ch];
+            lowCutState[ch] = low + v;
+            x -= low;
+
+            v = (x - highCutState[ch]) * highCutG;
+            auto high = v + highCutState[ch];
+            highCutState[ch] = high + v;
+
+            wet[ch][i] = high;
+        }
+    }
+}
+
+template<size_t Lanes>
+void DelayEngine::processSteady(const juce::dsp::AudioBlock<float>& block, size_t start, int numSamples) noexcept
+{
+    using FVO = juce::FloatVectorOperations;
+
+    auto delayInt = static_cast<int>(delaySamples);
+    auto frac = delaySamples - static_cast<float>(delayInt);
+
+    // index of x[t - delayInt - 1]; the window up to + numSamples stays inside the mirrored copy
+    auto read = static_cast<size_t>((writePos - delayInt - 1 + bufferLength) % bufferLength);
+    auto write = static_cast<size_t>(writePos);
+    auto length = static_cast<size_t>(bufferLength);
+
+    std::array<float*, Lanes> io, wet, filtered;
+
+    for (size_t ch = 0; ch < Lanes; ++ch)
+    {
+        io[ch] = block.getChannelPointer(ch) + start;
+        wet[ch] = scratch[ch].data();
+        filtered[ch] = feedbackScratch[ch].data();
+
+        auto* line = buffer[ch].data();
+        FVO::copyWithMultiply(wet[ch], line + read + 1, 1.f - frac, numSamples);
+        FVO::addWithMultiply(wet[ch], line + read, frac, numSamples);
+        FVO::copy(filtered[ch], wet[ch], numSamples);
+    }
+
+    filterFeedback<Lanes>(filtered, numSamples);
+
+    auto fb = feedback.getTargetValue();
+    auto wetGain = mix.getTargetValue();
+
+    if constexpr (Lanes == 2)
+    {
+        if (pingPong)
+        {
+            auto* left = buffer[0].data() + write;
+            auto* right = buffer[1].data() + write;
+
+            // left line takes the mono input plus the right repeats, right takes the left repeats
+            FVO::copyWithMultiply(left, io[0], 0.5f, numSamples);
+            FVO::addWithMultiply(left, io[1], 0.5f, numSamples);
+            FVO::addWithMultiply(left, filtered[1], fb, numSamples);
+            FVO::copyWithMultiply(right, filtered[0], fb, numSamples);
+
+            FVO::copy(left + length, left, numSamples);
+            FVO::copy(right + length, right, numSamples);
+        }
+    }
+
+    for (size_t ch = 0; ch < Lanes; ++ch)
+    {
+        if (Lanes == 1 || ! pingPong)
+        {
+            auto* line = buffer[ch].data() + write;
+            FVO::copyWithMultiply(line, filtered[ch], fb, numSamples);
+            FVO::add(line, io[ch], numSamples);
+            FVO::copy(line + length, line, numSamples);
+        }
+
+        FVO::multiply(io[ch], 1.f - wetGain, numSamples);
+        FVO::addWithMultiply(io[ch], wet[ch], wetGain, numSamples);
+    }
+}
+
+template<size_t Lanes>
+void DelayEngine::processRamped(const juce::dsp::AudioBlock<float>& block, size_t start, int numSamples) noexcept
+{
+    std::array<float*, Lanes> io, wet;
+
+    for (size_t ch = 0; ch < Lanes; ++ch)
+    {
+        io[ch] = block.getChannelPointer(ch) + start;
+        wet[ch] = scratch[ch].data();
+    }
+
+    auto length = static_cast<size_t>(bufferLength);
+    auto ramping = rampRemaining > 0;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto delayInt = static_cast<int>(delaySamples);
+        auto frac = delaySamples - static_cast<float>(delayInt);
+        auto read = static_cast<size_t>((writePos + i - delayInt - 1 + bufferLength) % bufferLength);
+
+        for (size_t ch = 0; ch < Lanes; ++ch)
+        {
+            auto* line = buffer[ch].data();
+            wet[ch][i] = frac * line[read] + (1.f - frac) * line[read + 1];
+        }
+
+        // one sample at a time: the delay can be shorter than anything worth batching here
+        std::array<float, Lanes> filtered;
+        std::array<float*, Lanes> one;
+
+        for (size_t ch = 0; ch < Lanes; ++ch)
+        {
+            filtered[ch] = wet[ch][i];
+            one[ch] = &filtered[ch];
+        }
+
+        filterFeedback<Lanes>(one, 1);
+
+        auto fb = feedback.getNextValue();
+        auto wetGain = mix.getNextValue();
+        auto write = static_cast<size_t>(writePos + i);
+
+        std::array<float, Lanes> toLine;
+
+        if (Lanes == 2 && pingPong)
+        {
+            toLine[0] = 0.5f * (io[0][i] + io[Lanes - 1][i]) + fb * filtered[Lanes - 1];
+            toLine[Lanes - 1] = fb * filtered[0];
+        }
+        else
+        {
+            for (size_t ch = 0; ch < Lanes; ++ch)
+                toLine[ch] = io[ch][i] + fb * filtered[ch];
+        }
+
+        for (size_t ch = 0; ch < Lanes; ++ch)
+        {
+            buffer[ch][write] = toLine[ch];
+            buffer[ch][write + length] = toLine[ch];
+
+            io[ch][i] += wetGain * (wet[ch][i] - io[ch][i]);
+        }
+
+        if (ramping)
+            delaySamples += delayIncrement;
+    }
+
+    if (ramping)
+    {
+        rampRemaining -= numSamples;
+
+        if (rampRemaining == 0)
+            delaySamples = delayTarget;
+    }
+}
+
+juce::StringArray DelayEngine::getSyncDivisionChoices()
+{
+    return juce::StringArray
+    {
+        "1/1",
+        "1/2",
+        "1/2.",
+        "1/4",
+        "1/4.",
+        "1/4T",
+        "1/8",
+        "1/8.",
+        "1/8T",
+        "1/16",
+        "1/16.",
+        "1/16T",
+        "1/32"
+    };
+}
+
+double DelayEngine::getSyncDivisionBeats(int choiceIndex)
+{
+    // in quarter notes, "." is dotted and "T" triplet
+    constexpr std::array<double, 13> beats{ 4.0, 2.0, 3.0, 1.0, 1.5, 2.0 / 3.0, 0.5, 0.75, 1.0 / 3.0,
+                                            0.25, 0.375, 1.0 / 6.0, 0.125 };
+    return beats[static_cast<size_t>(juce::jlimit(0, static_cast<int>(beats.size()) - 1, choiceIndex))];
+}
@@ -0,0 +1,111 @@
+/*
+  ==============================================================================
+
+    DelayEngine.h
+
+    Stereo feedback delay with filtered repeats and ping-pong.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+    - one buffer per channel, written twice (mirrored) so a read window is
+      always a plain contiguous range
+    - while delay time, feedback and mix are steady the block is handled in
+      segments no longer than the delay: the delayed signal is read for the
+      whole segment with one fractional offset and the mix / feedback writes
+      are vector operations. Only the feedback filters run sample by sample.
+    - a delay time change glides over rampTimeSeconds, read sample by sample
+    - the feedback path goes through a low cut and a high cut (one-pole TPT),
+      so the repeats darken / thin out the way tape / analog delays do. Only
+      what is written back into the line is filtered: the first repeat is
+      heard unfiltered, the n-th has been through the filters n - 1 times
+    - ping-pong feeds the mono sum into the left line and crosses the feedback
+      between channels
+    - the buffer is sized from the maximum passed to setMaximumDelay()
+    - leaving bypass doesn't clear the whole line on the audio thread: what
+      was written before is stale, and each read window is zeroed where it
+      still reaches into it, just before it is read
+
+    The processor turns tempo sync into a delay time, see getSyncDivisionBeats().
+*/
+class DelayEngine : public juce::dsp::ProcessorBase
+{
+public:
+    static constexpr size_t maxChannels = 2;
+    static constexpr float minimumDelayMs = 1.f;
+    static constexpr double rampTimeSeconds = 0.05;
+
+    // call before prepare(), with the range end of the delay time parameter
+    void setMaximumDelay(float newMaxDelayMs) { maxDelayMs = newMaxDelayMs; }
+
+    void prepare(const juce::dsp::ProcessSpec& spec) override;
+    void process(const juce::dsp::ProcessContextReplacing<float>& context) override;
+    void reset() override;
+
+    // frees what prepare() allocated; prepare() again before the next process()
+    void releaseResources();
+
+    void setDelayTime(float newDelayMs) noexcept { targetDelayMs = newDelayMs; }
+    void setFeedback(float newFeedback) noexcept { feedback.setTargetValue(newFeedback); }
+    void setMix(float newMix) noexcept { mix.setTargetValue(newMix); }
+    void setPingPong(bool shouldPingPong) noexcept { pingPong = shouldPingPong; }
+    void setFeedbackFilter(float newLowCutHz, float newHighCutHz) noexcept;
+
+    float getMaximumDelayMs() const noexcept { return maxDelayMs; }
+
+    // makes one channel's state a copy of another's, for the processor's dual-mono path
+    void copyChannelState(size_t source, size_t destination) noexcept;
+
+    static juce::StringArray getSyncDivisionChoices();
+    static double getSyncDivisionBeats(int choiceIndex);
+
+private:
+    void updateControl() noexcept;
+
+    // everything reset() does but clearing the line, which is left to clearStale()
+    void restart() noexcept;
+
+    // zeroes the samples oldestDistance .. newestDistance back from writePos that are older than freshSamples
+    void clearStale(int oldestDistance, int newestDistance) noexcept;
+
+    template<size_t Lanes>
+    void processSteady(const juce::dsp::AudioBlock<float>& block, size_t start, int numSamples) noexcept;
+
+    template<size_t Lanes>
+    void processRamped(const juce::dsp::AudioBlock<float>& block, size_t start, int numSamples) noexcept;
+
+    // low cut then high cut, in place
+    template<size_t Lanes>
+    void filterFeedback(std::array<float*, Lanes> wet, int numSamples) noexcept;
+
+    double sampleRate = 44100.0;
+    float maxDelayMs = 2000.f;
+
+    // per channel: bufferLength samples, then the same again
+    std::array<std::vector<float>, maxChannels> buffer;
+    std::array<std::vector<float>, maxChannels> scratch, feedbackScratch;
+    int bufferLength = 0;
+    int writePos = 0;
+
+    // how many samples back from writePos were written since the last restart(), up to bufferLength
+    int freshSamples = 0;
+
+    float targetDelayMs = 350.f;
+    float delaySamples = 0.f, delayTarget = 0.f, delayIncrement = 0.f;
+    int rampRemaining = 0;
+    int rampLength = 1;
+
+    juce::SmoothedValue<float> feedback, mix;
+    bool pingPong = false;
+    bool wasBypassed = false;
+
+    float lowCutHz = 20.f, highCutHz = 20000.f;
+    float lowCutG = 0.f, highCutG = 1.f;
+    bool filterDirty = true;
+    std::array<float, maxChannels> lowCutState{}, highCutState{};
+};
@@ -0,0 +1,344 @@
+/*
+  ==============================================================================
+
+    LadderEngine.cpp
+
+  ==============================================================================
+*/
+
+#include "LadderEngine.h"
+
+LadderEngine::LadderEngine()
+{
+    mode = juce::dsp::LadderFilterMode::LPF24;
+    setMode(juce::dsp::LadderFilterMode::LPF12);
+    setResonance(0.f);
+    setDrive(1.2f);
+    setProcessingRate(1000.0);
+}
+
+void LadderEngine::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    jassert(spec.sampleRate > 0);
+    jassert(spec.numChannels > 0 && spec.numChannels <= maxChannels);
+
+    sampleRate = spec.sampleRate;
+    maximumBlockSize = spec.maximumBlockSize;
+
+    // prepared whether or not High quality is on, so switching to it doesn't allocate
+    oversampler = std::make_unique<juce::dsp::Oversampling<float>>(spec.numChannels, 1,
+        juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR, true, true);
+    oversampler->initProcessing(maximumBlockSize);
+
+    compensationLength = static_cast<size_t>(oversampler->getLatencyInSamples());
+    compensation.assign(compensationLength * maxChannels, 0.f);
+
+    setProcessingRate(oversampling ? sampleRate * 2.0 : sampleRate);
+    reset();
+}
+
+void LadderEngine::reset()
+{
+    for (auto& s : state)
+        s.fill(0.0);
+
+    cutoffTransformSmoother.setCurrentAndTargetValue(cutoffTransformSmoother.getTargetValue());
+    scaledResonanceSmoother.setCurrentAndTargetValue(scaledResonanceSmoother.getTargetValue());
+
+    if (oversampler != nullptr)
+        oversampler->reset();
+
+    std::fill(compensation.begin(), compensation.end(), 0.f);
+    compensationPos = 0;
+}
+
+void LadderEngine::releaseResources()
+{
+    oversampler.reset();
+
+    std::vector<float>().swap(compensation);
+    compensationLength = 0;
+    compensationPos = 0;
+}
+
+void LadderEngine::setMode(juce::dsp::LadderFilterMode newMode) noexcept
+{
+    using Mode = juce::dsp::LadderFilterMode;
+
+    if (newMode == mode)
+        return;
+
+    switch (newMode)
+    {
+    case Mode::LPF12:   A = { { 0.f, 0.f,  1.f, 0.f,  0.f } }; comp = 0.5f; break;
+    case Mode::HPF12:   A = { { 1.f, -2.f, 1.f, 0.f,  0.f } }; comp = 0.f;  break;
+    case Mode::BPF12:   A = { { 0.f, 0.f, -1.f, 1.f,  0.f } }; comp = 0.5f; break;
+    case Mode::LPF24:   A = { { 0.f, 0.f,  0.f, 0.f,  1.f } }; comp = 0.5f; break;
+    case Mode::HPF24:   A = { { 1.f, -4.f, 6.f, -4.f, 1.f } }; comp = 0.f;  break;
+    case Mode::BPF24:   A = { { 0.f, 0.f,  1.f, -2.f, 1.f } }; comp = 0.5f; break;
+    default:            jassertfalse; break;
+    }
+
+    static constexpr auto outputGain = 1.2f;
+
+    for (auto& a : A)
+        a *= outputGain;
+
+    mode = newMode;
+    reset();
+}
+
+void LadderEngine::setCutoffFrequencyHz(float newCutoff) noexcept
+{
+    jassert(newCutoff > 0.f);
+
+    if (newCutoff == cutoffFreqHz)
+        return;
+
+    cutoffFreqHz = newCutoff;
+    updateCutoff();
+}
+
+void LadderEngine::setResonance(float newResonance) noexcept
+{
+    jassert(newResonance >= 0.f && newResonance <= 1.f);
+
+    // mapped into 0.1 - 1 twice, as juce::dsp::LadderFilter does
+    resonance = juce::jmap(juce::jlimit(0.f, 1.f, newResonance), 0.1f, 1.f);
+    scaledResonanceSmoother.setTargetValue(juce::jmap(resonance, 0.1f, 1.f));
+}
+
+void LadderEngine::setDrive(float newDrive) noexcept
+{
+    jassert(newDrive >= 1.f);
+
+    newDrive = juce::jmax(1.f, newDrive);
+
+    if (newDrive == drive)
+        return;
+
+    drive = newDrive;
+    gain = std::pow(drive, -2.642f) * 0.6103f + 0.3903f;
+    drive2 = drive * 0.04f + 0.96f;
+    gain2 = std::pow(drive2, -2.642f) * 0.6103f + 0.3903f;
+}
+
+void LadderEngine::setOversampling(bool shouldOversample, bool holdLatency) noexcept
+{
+    latencyHeld = holdLatency && ! shouldOversample;
+
+    if (shouldOversample == oversampling)
+        return;
+
+    oversampling = shouldOversample;
+    setProcessingRate(oversampling ? sampleRate * 2.0 : sampleRate);
+
+    // the two rates don't share filter state
+    for (auto& s : state)
+        s.fill(0.0);
+
+    if (oversampler != nullptr)
+        oversampler->reset();
+
+    std::fill(compensation.begin(), compensation.end(), 0.f);
+    compensationPos = 0;
+}
+
+int LadderEngine::getLatencyInSamples() const noexcept
+{
+    if (! (oversampling || latencyHeld) || oversampler == nullptr)
+        return 0;
+
+    return static_cast<int>(oversampler->getLatencyInSamples());
+}
+
+void LadderEngine::copyChannelState(size_t source, size_t destination) noexcept
+{
+    jassert(source < maxChannels && destination < maxChannels);
+
+    state[destination] = state[source];
+
+    if (compensationLength > 0)
+        std::copy_n(compensation.begin() + static_cast<std::ptrdiff_t>(source * compensationLength), compensationLength,
+                    compensation.begin() + static_cast<std::ptrdiff_t>(destination * compensationLength));
+}
+
+void LadderEngine::setProcessingRate(double newRate) noexcept
+{
+    processingRate = newRate;
+    cutoffFreqScaler = static_cast<float>(-2.0 * juce::MathConstants<double>::pi / processingRate);
+
+    static constexpr double smootherRampTimeSec = 0.05;
+    cutoffTransformSmoother.reset(processingRate, smootherRampTimeSec);
+    scaledResonanceSmoother.reset(processingRate, smootherRampTimeSec);
+
+    updateCutoff();
+}
+
+void LadderEngine::updateCutoff() noexcept
+{
+    cutoffTransformSmoother.setTargetValue(std::exp(cutoffFreqHz * cutoffFreqScaler));
+}
+
+void LadderEngine::process(const juce::dsp::ProcessContextReplacing<float>& context)
+{
+    auto& inputBlock = context.getInputBlock();
+    auto& outputBlock = context.getOutputBlock();
+
+    if (context.usesSeparateInputAndOutputBlocks())
+        outputBlock.copyFrom(inputBlock);
+
+    if (! oversampling)
+    {
+        if (! context.isBypassed)
+            processAtCurrentRate(outputBlock);
+
+        if (latencyHeld)
+            applyCompensationDelay(outputBlock);
+
+        return;
+    }
+
+    jassert(oversampler != nullptr);
+
+    // the oversampler only takes what it was prepared for
+    auto numSamples = outputBlock.getNumSamples();
+
+    for (size_t pos = 0; pos < numSamples; pos += maximumBlockSize)
+    {
+        auto chunk = outputBlock.getSubBlock(pos, juce::jmin(maximumBlockSize, numSamples - pos));
+        auto upsampled = oversampler->processSamplesUp(chunk);
+
+        if (! context.isBypassed)
+            processAtCurrentRate(upsampled);
+
+        oversampler->processSamplesDown(chunk);
+    }
+}
+
+void LadderEngine::applyCompensationDelay(const juce::dsp::AudioBlock<float>& block) noexcept
+{
+    if (compensationLength == 0)
+        return;
+
+    auto numChannels = juce::jmin(block.getNumChannels(), maxChannels);
+    auto numSamples = block.getNumSamples();
+    auto pos = compensationPos;
+
+    for (size_t ch = 0; ch < numChannels; ++ch)
+    {
+        auto* x = block.getChannelPointer(ch);
+        auto* line = compensation.data() + ch * compensationLength;
+        pos = compensationPos;
+
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            std::swap(x[i], line[pos]);
+
+            if (++pos == compensationLength)
+                pos = 0;
+        }
+    }
+
+    compensationPos = pos;
+}
+
+void LadderEngine::processAtCurrentRate(const juce::dsp::AudioBlock<float>& block) noexcept
+{
+    auto twoLanes = juce::jmin(block.getNumChannels(), maxChannels) == 2;
+
+    auto run = [this, &block, twoLanes](auto precision, auto&& saturate)
+    {
+        using T = decltype(precision);
+
+        if (twoLanes)
+            processKernel<T, 2>(block, saturate);
+        else
+            processKernel<T, 1>(block, saturate);
+    };
+
+    auto dispatch = [this, &run](auto precision)
+    {
+        using T = decltype(precision);
+
+        switch (saturation)
+        {
+        case SaturationKernel::FastApproximation:
+            run(precision, [](T x)
+            {
+                return juce::dsp::FastMathApproximations::tanh(juce::jlimit(T(-5), T(5), x));
+            });
+            break;
+
+        case SaturationKernel::LookupTable:
+            run(precision, [&table = SharedTables::getSaturationTable()](T x)
+            {
+                return static_cast<T>(table(static_cast<float>(x)));
+            });
+            break;
+
+        case SaturationKernel::Exact:
+            run(precision, [](T x) { return std::tanh(x); });
+            break;
+        }
+    };
+
+    if (doublePrecision)
+        dispatch(0.0);
+    else
+        dispatch(0.f);
+}
+
+template<typename T, size_t Lanes, typename Saturate>
+void LadderEngine::processKernel(const juce::dsp::AudioBlock<float>& block, Saturate&& saturate) noexcept
+{
+    std::array<float*, Lanes> io;
+    std::array<std::array<T, 5>, Lanes> s;
+
+    for (size_t ch = 0; ch < Lanes; ++ch)
+    {
+        io[ch] = block.getChannelPointer(ch);
+
+        for (size_t i = 0; i < 5; ++i)
+            s[ch][i] = static_cast<T>(state[ch][i]);
+    }
+
+    const auto A0 = static_cast<T>(A[0]), A1 = static_cast<T>(A[1]), A2 = static_cast<T>(A[2]),
+               A3 = static_cast<T>(A[3]), A4 = static_cast<T>(A[4]);
+    const auto tComp = static_cast<T>(comp);
+    const auto tDrive = static_cast<T>(drive), tGain = static_cast<T>(gain);
+    const auto tDrive2 = static_cast<T>(drive2), tGain2 = static_cast<T>(gain2);
+
+    auto numSamples = block.getNumSamples();
+
+    for (size_t n = 0; n < numSamples; ++n)
+    {
+        const auto a1 = static_cast<T>(cutoffTransformSmoother.getNextValue());
+        const auto scaledResonance = static_cast<T>(scaledResonanceSmoother.getNextValue());
+
+        const auto g = a1 * T(-1) + T(1);
+        const auto b0 = g * T(0.76923076923);
+        const auto b1 = g * T(0.23076923076);
+
+        for (size_t ch = 0; ch < Lanes; ++ch)
+        {
+            auto& st = s[ch];
+
+            const auto dx = tGain * saturate(tDrive * static_cast<T>(io[ch][n]));
+            const auto a = dx + scaledResonance * T(-4) * (tGain2 * saturate(tDrive2 * st[4]) - dx * tComp);
+
+            const auto b = b1 * st[0] + a1 * st[1] + b0 * a;
+            const auto c = b1 * st[1] + a1 * st[2] + b0 * b;
+            const auto d = b1 * st[2] + a1 * st[3] + b0 * c;
+            const auto e = b1 * st[3] + a1 * st[4] + b0 * d;
+
+            st = { a, b, c, d, e };
+
+            io[ch][n] = static_cast<float>(a * A0 + b * A1 + c * A2 + d * A3 + e * A4);
+        }
+    }
+
+    for (size_t ch = 0; ch < Lanes; ++ch)
+        for (size_t i = 0; i < 5; ++i)
+            state[ch][i] = static_cast<double>(juce::dsp::util::snapToZero(s[ch][i]));
+}
@@ -0,0 +1,103 @@
+/*
+  ==============================================================================
+
+    LadderEngine.h
+
+    Stereo Moog-style ladder filter with selectable kernels,
+    replaces juce::dsp::LadderFilter for the ladder filter and overdrive stages.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Quality.h"
+#include "SharedTables.h"
+
+/*
+    Same topology, coefficients and parameter mapping as
+    juce::dsp::LadderFilter (with SaturationKernel::LookupTable and no
+    oversampling it produces the same output), processing both channels
+    as lanes of one loop. On top of that the kernel is selectable:
+
+    - saturation: fast approximation / lookup table / exact tanh
+    - state and maths in float or double
+    - optional 2x oversampling (IIR polyphase, integer latency). While it is
+      on, a bypassed engine still runs the resampling round trip so the
+      reported latency doesn't depend on bypass. With holdLatency, turning
+      it off keeps the same latency through a plain delay, so the CPU
+      governor can drop it without the host's delay compensation changing.
+
+    Everything for every kernel is allocated in prepare(), so switching
+    kernels on the audio thread never allocates.
+*/
+class LadderEngine : public juce::dsp::ProcessorBase
+{
+public:
+    static constexpr size_t maxChannels = 2;
+
+    LadderEngine();
+
+    void prepare(const juce::dsp::ProcessSpec& spec) override;
+    void process(const juce::dsp::ProcessContextReplacing<float>& context) override;
+    void reset() override;
+
+    // frees what prepare() allocated; prepare() again before the next process()
+    void releaseResources();
+
+    void setMode(juce::dsp::LadderFilterMode newMode) noexcept;
+    void setCutoffFrequencyHz(float newCutoff) noexcept;
+    void setResonance(float newResonance) noexcept;
+    void setDrive(float newDrive) noexcept;
+
+    void setSaturationKernel(SaturationKernel newKernel) noexcept { saturation = newKernel; }
+    void setDoublePrecision(bool shouldUseDouble) noexcept { doublePrecision = shouldUseDouble; }
+    void setOversampling(bool shouldOversample, bool holdLatency = false) noexcept;
+
+    // in samples at the host rate, 0 unless oversampling or holding its latency
+    int getLatencyInSamples() const noexcept;
+
+    // makes one channel's state a copy of another's, for the processor's dual-mono path.
+    // Doesn't cover the oversampler's filters, which can't be copied.
+    void copyChannelState(size_t source, size_t destination) noexcept;
+
+private:
+    void processAtCurrentRate(const juce::dsp::AudioBlock<float>& block) noexcept;
+    void applyCompensationDelay(const juce::dsp::AudioBlock<float>& block) noexcept;
+
+    template<typename T, size_t Lanes, typename Saturate>
+    void processKernel(const juce::dsp::AudioBlock<float>& block, Saturate&& saturate) noexcept;
+
+    void setProcessingRate(double newRate) noexcept;
+    void updateCutoff() noexcept;
+
+    juce::dsp::LadderFilterMode mode = juce::dsp::LadderFilterMode::LPF12;
+    std::array<float, 5> A{};
+    float comp = 0.5f;
+
+    float cutoffFreqHz = 200.f;
+    float resonance = 0.1f;
+    float drive = 1.f, gain = 1.f, drive2 = 1.f, gain2 = 1.f;
+
+    double sampleRate = 44100.0;
+    double processingRate = 44100.0;
+    float cutoffFreqScaler = 0.f;
+
+    juce::SmoothedValue<float> cutoffTransformSmoother, scaledResonanceSmoother;
+
+    std::array<std::array<double, 5>, maxChannels> state{};
+
+    SaturationKernel saturation = SaturationKernel::LookupTable;
+    bool doublePrecision = false;
+    bool oversampling = false;
+    bool latencyHeld = false;
+
+    std::unique_ptr<juce::dsp::Oversampling<float>> oversampler;
+    size_t maximumBlockSize = 0;
+
+    // stands in for the oversampler's latency while latencyHeld, one line per channel
+    std::vector<float> compensation;
+    size_t compensationLength = 0;
+    size_t compensationPos = 0;
+};
@@ -0,0 +1,62 @@
+/*
+  ==============================================================================
+
+    LevelMeter.cpp
+
+  ==============================================================================
+*/
+
+#include "LevelMeter.h"
+
+StageLevels measureLevels(const float* data, size_t numSamples) noexcept
+{
+    using Vec = juce::dsp::SIMDRegister<float>;
+
+    StageLevels levels;
+
+    if (data == nullptr || numSamples == 0)
+        return levels;
+
+    float peak = 0.f;
+    float sumOfSquares = 0.f;
+
+    auto* alignedStart = Vec::getNextSIMDAlignedPtr(const_cast<float*>(data));
+    auto head = juce::jmin(numSamples, static_cast<size_t>(alignedStart - data));
+
+    size_t i = 0;
+
+    for (; i < head; ++i)
+    {
+        peak = juce::jmax(peak, std::abs(data[i]));
+        sumOfSquares += data[i] * data[i];
+    }
+
+    auto vPeak = Vec::expand(0.f);
+    auto vSum = Vec::expand(0.f);
+
+    for (; i + Vec::size() <= numSamples; i += Vec::size())
+    {
+        auto v = Vec::fromRawArray(data + i);
+        vPeak = Vec::max(vPeak, Vec::abs(v));
+        vSum = Vec::multiplyAdd(vSum, v, v);
+    }
+
+    alignas(Vec::SIMDRegisterSize) float lanes[Vec::SIMDNumElements];
+    vPeak.copyToRawArray(lanes);
+
+    for (auto lane : lanes)
+        peak = juce::jmax(peak, lane);
+
+    sumOfSquares += vSum.sum();
+
+    for (; i < numSamples; ++i)
+    {
+        peak = juce::jmax(peak, std::abs(data[i]));
+        sumOfSquares += data[i] * data[i];
+    }
+
+    levels.peak = peak;
+    levels.rms = std::sqrt(sumOfSquares / static_cast<float>(numSamples));
+
+    return levels;
+}
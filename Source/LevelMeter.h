@@ -0,0 +1,25 @@
+/*
+  ==============================================================================
+
+    LevelMeter.h
+
+    Peak / RMS measurement used for the per-stage meters.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+struct StageLevels
+{
+    float peak = 0.f;
+    float rms = 0.f;
+};
+
+/*
+    Single pass over the block using juce::dsp::SIMDRegister, scalar only for
+    the unaligned head and the tail. Safe to call on the audio thread.
+*/
+StageLevels measureLevels(const float* data, size_t numSamples) noexcept;
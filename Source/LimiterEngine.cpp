@@ -0,0 +1,342 @@
+/*
+  ==============================================================================
+
+    LimiterEngine.cpp
+
+  ==============================================================================
+*/
+
+#include "LimiterEngine.h"
+
+void LimiterEngine::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    jassert(spec.sampleRate > 0);
+    jassert(spec.numChannels > 0 && spec.numChannels <= maxChannels);
+
+    sampleRate = spec.sampleRate;
+    numChannels = spec.numChannels;
+
+    maxLookahead = static_cast<int>(std::ceil(maxLookaheadMs * sampleRate / 1000.0));
+    lookahead = toSamples(lookaheadMs);
+
+    // the delayed chunk is read after it's written, so a whole chunk on top of the longest window
+    ringLength = maxLookahead + 1 + chunkSize;
+
+    for (auto& line : delayLine)
+        line.assign(static_cast<size_t>(ringLength) * 2, 0.f);
+
+    dequeSample.assign(static_cast<size_t>(maxLookahead) + 1, 0);
+    dequePeak.assign(static_cast<size_t>(maxLookahead) + 1, 0.f);
+    history.assign(static_cast<size_t>(ringLength) * 2, 1.f);
+
+    updateReleaseCoefficient();
+    reset();
+}
+
+void LimiterEngine::reset()
+{
+    for (auto& line : delayLine)
+        std::fill(line.begin(), line.end(), 0.f);
+
+    writePos = 0;
+    wasBypassed = false;
+    fadeFromLookahead = -1;
+
+    resetDetector();
+}
+
+void LimiterEngine::resetDetector() noexcept
+{
+    dequeFront = 0;
+    dequeSize = 0;
+    sampleCount = 0;
+
+    released = 1.f;
+
+    std::fill(history.begin(), history.end(), 1.f);
+    averageSum = lookahead + 1;
+}
+
+void LimiterEngine::sumWindow() noexcept
+{
+    auto* h = history.data() + ringLength;
+    averageSum = 0.0;
+
+    // the window ends at writePos; from the second copy it never starts before the first sample
+    for (int k = writePos - (lookahead + 1); k < writePos; ++k)
+        averageSum += h[k];
+}
+
+int LimiterEngine::toSamples(float ms) const noexcept
+{
+    return juce::jlimit(0, maxLookahead, juce::roundToInt(ms * sampleRate / 1000.0));
+}
+
+void LimiterEngine::setCeiling(float newCeilingDb) noexcept
+{
+    if (newCeilingDb == ceilingDb)
+        return;
+
+    ceilingDb = newCeilingDb;
+    ceiling = juce::Decibels::decibelsToGain(ceilingDb);
+}
+
+void LimiterEngine::setLookahead(float newLookaheadMs) noexcept
+{
+    lookaheadMs = newLookaheadMs;
+
+    // not prepared yet: prepare() picks it up
+    if (delayLine[0].empty())
+        return;
+
+    if (auto newLookahead = toSamples(lookaheadMs); newLookahead != lookahead)
+    {
+        // several changes before the next chunk fade from what was last heard
+        if (fadeFromLookahead < 0)
+            fadeFromLookahead = lookahead;
+
+        lookahead = newLookahead;
+        sumWindow();
+    }
+}
+
+void LimiterEngine::setRelease(float newReleaseMs) noexcept
+{
+    if (newReleaseMs == releaseMs)
+        return;
+
+    releaseMs = newReleaseMs;
+    updateReleaseCoefficient();
+}
+
+void LimiterEngine::updateReleaseCoefficient() noexcept
+{
+    releaseCoefficient = 1.f - std::exp(-1.f / juce::jmax(1.f, releaseMs * static_cast<float>(sampleRate) / 1000.f));
+}
+
+void LimiterEngine::process(const juce::dsp::ProcessContextReplacing<float>& context)
+{
+    auto& inputBlock = context.getInputBlock();
+    auto& outputBlock = context.getOutputBlock();
+
+    if (context.usesSeparateInputAndOutputBlocks())
+        outputBlock.copyFrom(inputBlock);
+
+    // a bypassed limiter has seen none of what's about to come out of the delay
+    if (context.isBypassed)
+        wasBypassed = true;
+    else if (wasBypassed)
+    {
+        resetDetector();
+        wasBypassed = false;
+    }
+
+    auto numSamples = static_cast<int>(outputBlock.getNumSamples());
+
+    for (int start = 0; start < numSamples; start += chunkSize)
+        processChunk(outputBlock, static_cast<size_t>(start), juce::jmin(chunkSize, numSamples - start), context.isBypassed);
+}
+
+void LimiterEngine::processChunk(const juce::dsp::AudioBlock<float>& block, size_t start, int numSamples, bool bypassed) noexcept
+{
+    auto channels = juce::jmin(block.getNumChannels(), numChannels);
+    auto window = lookahead + 1;
+
+    if (! bypassed)
+    {
+        // peak
+        std::fill(peak.begin(), peak.begin() + numSamples, 0.f);
+
+        for (size_t ch = 0; ch < channels; ++ch)
+        {
+            auto* x = block.getChannelPointer(ch) + start;
+
+            for (int i = 0; i < numSamples; ++i)
+                peak[static_cast<size_t>(i)] = juce::jmax(peak[static_cast<size_t>(i)], std::abs(x[i]));
+        }
+
+        // hold
+        auto capacity = static_cast<int>(dequePeak.size());
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto p = peak[static_cast<size_t>(i)];
+
+            // expired ones go first, so with the new sample there are never more than window entries
+            while (dequeSize > 0 && dequeSample[static_cast<size_t>(dequeFront)] <= sampleCount - window)
+            {
+                dequeFront = (dequeFront + 1) % capacity;
+                --dequeSize;
+            }
+
+            // anything no louder than the new sample can never be the maximum again
+            while (dequeSize > 0 && dequePeak[static_cast<size_t>((dequeFront + dequeSize - 1) % capacity)] <= p)
+                --dequeSize;
+
+            jassert(dequeSize < capacity);
+
+            auto back = static_cast<size_t>((dequeFront + dequeSize) % capacity);
+            dequeSample[back] = sampleCount;
+            dequePeak[back] = p;
+            ++dequeSize;
+
+            gain[static_cast<size_t>(i)] = dequePeak[static_cast<size_t>(dequeFront)];
+            ++sampleCount;
+        }
+
+        // target
+        for (int i = 0; i < numSamples; ++i)
+            gain[static_cast<size_t>(i)] = juce::jmin(1.f, ceiling / juce::jmax(gain[static_cast<size_t>(i)], 1.0e-9f));
+
+        // release, the one recursion
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto target = gain[static_cast<size_t>(i)];
+            released = target < released ? target : released + (target - released) * releaseCoefficient;
+            gain[static_cast<size_t>(i)] = released;
+        }
+
+        smoothChunk(numSamples);
+    }
+
+    // gain
+    auto readPos = (writePos - lookahead + ringLength) % ringLength;
+    auto fadeReadPos = (writePos - fadeFromLookahead + ringLength) % ringLength;
+    auto fadeStep = 1.f / static_cast<float>(numSamples);
+
+    for (size_t ch = 0; ch < channels; ++ch)
+    {
+        auto* x = block.getChannelPointer(ch) + start;
+        auto* line = delayLine[ch].data();
+
+        for (int i = 0, pos = writePos; i < numSamples; ++i)
+        {
+            line[pos] = line[pos + ringLength] = x[i];
+
+            if (++pos == ringLength)
+                pos = 0;
+        }
+
+        const float* delayed = line + readPos;
+
+        // the first chunk after a lookahead change: from the old read point to the new one
+        if (fadeFromLookahead >= 0)
+        {
+            auto* previous = line + fadeReadPos;
+
+            for (int i = 0; i < numSamples; ++i)
+                scratch[static_cast<size_t>(i)] = previous[i] + (delayed[i] - previous[i]) * static_cast<float>(i + 1) * fadeStep;
+
+            delayed = scratch.data();
+        }
+
+        if (bypassed)
+            std::copy_n(delayed, numSamples, x);
+        else
+            for (int i = 0; i < numSamples; ++i)
+                x[i] = juce::jlimit(-ceiling, ceiling, delayed[i] * gain[static_cast<size_t>(i)]);
+    }
+
+    writePos = (writePos + numSamples) % ringLength;
+    fadeFromLookahead = -1;
+}
+
+void LimiterEngine::smoothChunk(int numSamples) noexcept
+{
+    auto window = lookahead + 1;
+    auto* h = history.data();
+
+    // the released gains go in first: with a short window, some of them leave again within the chunk
+    for (int i = 0, pos = writePos; i < numSamples; ++i)
+    {
+        h[pos] = h[pos + ringLength] = gain[static_cast<size_t>(i)];
+
+        if (++pos == ringLength)
+            pos = 0;
+    }
+
+    auto* leaving = h + (writePos - window + ringLength) % ringLength;
+
+    for (int i = 0; i < numSamples; ++i)
+        scratch[static_cast<size_t>(i)] = gain[static_cast<size_t>(i)] - leaving[i];
+
+    // the window's sum relative to the chunk's start, a prefix sum of the changes
+    auto base = static_cast<float>(averageSum);
+    auto scale = 1.f / static_cast<float>(window);
+    auto running = 0.f;
+    int i = 0;
+
+    for (; i + static_cast<int>(Vec::size()) <= numSamples; i += static_cast<int>(Vec::size()))
+    {
+        auto sums = prefixSum(Vec::fromRawArray(scratch.data() + i)) + running;
+        running = sums.get(Vec::size() - 1);
+        ((sums + base) * scale).copyToRawArray(gain.data() + i);
+    }
+
+    for (; i < numSamples; ++i)
+    {
+        running += scratch[static_cast<size_t>(i)];
+        gain[static_cast<size_t>(i)] = (running + base) * scale;
+    }
+
+    averageSum += running;
+
+    // summed afresh once per lap of the history, so rounding can't creep up over a long run
+    if (writePos + numSamples >= ringLength)
+    {
+        auto end = (writePos + numSamples) % ringLength;
+        averageSum = 0.0;
+
+        for (int k = end - window; k < end; ++k)
+            averageSum += h[k + ringLength];
+    }
+}
+
+template<typename Register>
+Register LimiterEngine::prefixSum(Register v) noexcept
+{
+    // Register is only ever Vec; as a template parameter it keeps the native shifts below from
+    // being checked against a register type they weren't written for
+    using Vec = Register;
+
+   #if JUCE_USE_SSE_INTRINSICS
+    if constexpr (Vec::SIMDNumElements == 4)
+    {
+        auto x = v.value;
+        x = _mm_add_ps(x, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(x), 4)));
+        x = _mm_add_ps(x, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(x), 8)));
+        return Vec::fromNative(x);
+    }
+    #if defined(__AVX2__)
+    else if constexpr (Vec::SIMDNumElements == 8)
+    {
+        // each half on its own, then the low half's total added to every lane of the high half
+        auto x = v.value;
+        x = _mm256_add_ps(x, _mm256_castsi256_ps(_mm256_slli_si256(_mm256_castps_si256(x), 4)));
+        x = _mm256_add_ps(x, _mm256_castsi256_ps(_mm256_slli_si256(_mm256_castps_si256(x), 8)));
+
+        auto lowTotal = _mm256_permute2f128_ps(x, x, 0x08);
+        return Vec::fromNative(_mm256_add_ps(x, _mm256_shuffle_ps(lowTotal, lowTotal, _MM_SHUFFLE(3, 3, 3, 3))));
+    }
+    #endif
+    else
+   #elif JUCE_USE_ARM_NEON
+    if constexpr (Vec::SIMDNumElements == 4)
+    {
+        auto zero = vdupq_n_f32(0.f);
+        auto x = v.value;
+        x = vaddq_f32(x, vextq_f32(zero, x, 3));
+        x = vaddq_f32(x, vextq_f32(zero, x, 2));
+        return Vec::fromNative(x);
+    }
+    else
+   #endif
+    {
+        // anything else goes through memory
+        alignas(Vec::SIMDRegisterSize) std::array<float, Vec::SIMDNumElements> lanes;
+        v.copyToRawArray(lanes.data());
+        std::partial_sum(lanes.begin(), lanes.end(), lanes.begin());
+
+        return Vec::fromRawArray(lanes.data());
+    }
+}
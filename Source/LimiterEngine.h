@@ -0,0 +1,110 @@
+/*
+  ==============================================================================
+
+    LimiterEngine.h
+
+    Lookahead peak limiter for the plugin's output, channels linked.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+    With a lookahead of L samples the audio is delayed by L and the gain
+    reaches whatever a peak needs by the time it comes out of the delay:
+
+        peak        max |x| over the channels, per sample
+        hold        sliding maximum of the peak over the last L + 1 samples,
+                    a monotonic deque - amortised O(1) per sample whatever L
+        target      ceiling / hold, at most 1
+        release     instant down, one-pole back up
+        smooth      moving average over the last L + 1 samples, so the gain
+                    ramps down over the lookahead instead of stepping. Every
+                    value averaged at a peak's output time is at most what that
+                    peak needs, so the smoothed gain is too.
+
+    Blocks are handled in chunks of up to chunkSize samples, one pass per
+    line above over the chunk. The peak, target and gain passes run over
+    plain arrays with no dependencies between samples, and vectorise; only
+    the deque and the release recursion are scalar. The moving average is
+    a running sum of what enters the window minus what leaves it, both read
+    from a history of released gains laid out like the delay lines, and the
+    running sum is taken a SIMDRegister at a time: a prefix sum across the
+    lanes plus the carry from the register before. The output is clamped to
+    the ceiling as well, so rounding can never let an over through.
+
+    Bypassed, the audio is still delayed so the reported latency stays
+    true. A lookahead change moves the delay's read point without a reset:
+    the next chunk crossfades from the old read point to the new one, and
+    the hold and the average carry on over the new window. Until a whole new
+    lookahead has gone by, a peak may get less warning than it needs, which
+    the clamp catches.
+*/
+class LimiterEngine : public juce::dsp::ProcessorBase
+{
+public:
+    static constexpr size_t maxChannels = 2;
+    static constexpr int chunkSize = 64;
+    static constexpr float maxLookaheadMs = 10.f;
+
+    void prepare(const juce::dsp::ProcessSpec& spec) override;
+    void process(const juce::dsp::ProcessContextReplacing<float>& context) override;
+    void reset() override;
+
+    void setCeiling(float newCeilingDb) noexcept;
+    void setLookahead(float newLookaheadMs) noexcept;
+    void setRelease(float newReleaseMs) noexcept;
+
+    int getLatencyInSamples() const noexcept { return lookahead; }
+
+private:
+    using Vec = juce::dsp::SIMDRegister<float>;
+
+    void processChunk(const juce::dsp::AudioBlock<float>& block, size_t start, int numSamples, bool bypassed) noexcept;
+    void smoothChunk(int numSamples) noexcept;
+    void resetDetector() noexcept;
+    void sumWindow() noexcept;
+    void updateReleaseCoefficient() noexcept;
+
+    int toSamples(float ms) const noexcept;
+
+    // lane k of the result is lanes 0 to k of v added up
+    template<typename Register>
+    static Register prefixSum(Register v) noexcept;
+
+    double sampleRate = 44100.0;
+    size_t numChannels = 2;
+
+    float ceilingDb = 0.f, ceiling = 1.f;
+    float lookaheadMs = 0.f, releaseMs = 100.f;
+    float releaseCoefficient = 1.f;
+    int lookahead = 0, maxLookahead = 0;
+
+    // the lookahead the next chunk crossfades from, or -1
+    int fadeFromLookahead = -1;
+
+    // per channel: ringLength samples, then the same again, so the delayed chunk is contiguous
+    std::array<std::vector<float>, maxChannels> delayLine;
+    int ringLength = 0, writePos = 0;
+
+    // (sample, peak) pairs with falling peaks, oldest first; a ring of maxLookahead + 1, the longest window
+    std::vector<juce::int64> dequeSample;
+    std::vector<float> dequePeak;
+    int dequeFront = 0, dequeSize = 0;
+    juce::int64 sampleCount = 0;
+
+    float released = 1.f;
+
+    // the released gains, laid out like a delay line at writePos, and the sum of the last lookahead + 1
+    std::vector<float> history;
+    double averageSum = 0.0;
+
+    bool wasBypassed = false;
+
+    alignas(Vec::SIMDRegisterSize) std::array<float, chunkSize> peak{};
+    alignas(Vec::SIMDRegisterSize) std::array<float, chunkSize> gain{};
+    alignas(Vec::SIMDRegisterSize) std::array<float, chunkSize> scratch{};
+};
@@ -0,0 +1,121 @@
+/*
+  ==============================================================================
+
+    ModulationBus.cpp
+
+  ==============================================================================
+*/
+
+#include "ModulationBus.h"
+#include "SineTable.h"
+
+void ModulationBus::prepare(double newSampleRate, int maximumBlockSize)
+{
+    sampleRate = newSampleRate;
+
+    // enough for per-sample modulation of a full block, plus the end point
+    maxPoints = juce::jmax(1, maximumBlockSize) + 2;
+
+    for (auto& lfo : lfos)
+        for (auto& p : lfo.points)
+            p.assign(static_cast<size_t>(maxPoints), 0.f);
+
+    reset();
+}
+
+void ModulationBus::reset()
+{
+    for (auto& lfo : lfos)
+        lfo.phase = lfo.settings.initialPhase;
+}
+
+void ModulationBus::copyBlockFrom(const ModulationBus& other) noexcept
+{
+    jassert(other.maxPoints == maxPoints);
+
+    for (size_t source = 0; source < lfos.size(); ++source)
+        for (size_t ch = 0; ch < maxChannels; ++ch)
+            std::copy(other.lfos[source].points[ch].begin(), other.lfos[source].points[ch].end(), lfos[source].points[ch].begin());
+
+    blockInterval = other.blockInterval;
+    inverseBlockInterval = other.inverseBlockInterval;
+}
+
+void ModulationBus::generate(int numSamples, const juce::AudioPlayHead::PositionInfo* position) noexcept
+{
+    jassert(maxPoints > 0);
+
+    // a host block bigger than prepared for gets coarser modulation rather than an overrun
+    blockInterval = juce::jmax(interval, (numSamples + maxPoints - 3) / (maxPoints - 2));
+    inverseBlockInterval = 1.f / static_cast<float>(blockInterval);
+
+    auto numPoints = numSamples / blockInterval + 2;
+
+    juce::Optional<double> bpm, ppq;
+    auto isPlaying = false;
+
+    if (position != nullptr)
+    {
+        bpm = position->getBpm();
+        ppq = position->getPpqPosition();
+        isPlaying = position->getIsPlaying();
+    }
+
+    for (auto& lfo : lfos)
+    {
+        auto& settings = lfo.settings;
+        auto cyclesPerSample = settings.rateHz / sampleRate;
+
+        if (settings.tempoSync)
+        {
+            auto beatsPerSecond = bpm.orFallback(120.0) / 60.0;
+            cyclesPerSample = beatsPerSecond / (settings.beatsPerCycle * sampleRate);
+
+            // lock to the song position while the transport runs, free-run at tempo otherwise
+            if (isPlaying && ppq.hasValue())
+            {
+                auto cycles = *ppq / settings.beatsPerCycle + settings.initialPhase;
+                lfo.phase = cycles - std::floor(cycles);
+            }
+        }
+
+        auto step = cyclesPerSample * blockInterval;
+
+        for (size_t ch = 0; ch < maxChannels; ++ch)
+        {
+            auto* points = lfo.points[ch].data();
+            auto phase = lfo.phase + (ch == 0 ? 0.0 : static_cast<double>(settings.stereoPhaseOffset));
+
+            for (int i = 0; i < numPoints; ++i)
+            {
+                auto p = phase + step * i;
+                points[i] = SineTable::lookup(static_cast<float>(p - std::floor(p)));
+            }
+        }
+
+        lfo.phase += cyclesPerSample * numSamples;
+        lfo.phase -= std::floor(lfo.phase);
+    }
+}
+
+juce::StringArray ModulationBus::getSyncDivisionChoices()
+{
+    return juce::StringArray
+    {
+        "4/1",
+        "2/1",
+        "1/1",
+        "1/2",
+        "1/4",
+        "1/8",
+        "1/16",
+        "1/32"
+    };
+}
+
+double ModulationBus::getSyncDivisionBeats(int choiceIndex)
+{
+    // in quarter notes: 4 bars down to a 32nd
+    constexpr std::array<double, 8> beats{ 16.0, 8.0, 4.0, 2.0, 1.0, 0.5, 0.25, 0.125 };
+    return beats[static_cast<size_t>(juce::jlimit(0, static_cast<int>(beats.size()) - 1, choiceIndex))];
+}
@@ -0,0 +1,95 @@
+/*
+  ==============================================================================
+
+    ModulationBus.h
+
+    LFOs shared by every stage, generated once per block.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+    Each source is a sine LFO rendered once per block, per channel, into a
+    preallocated control buffer with one point every `interval` samples.
+    Stages read it with getValue() at whatever sample offset they update
+    their coefficients, so both channels and every reader share one phase.
+
+    Channel 1 can be offset from channel 0 (stereo width), and a source can
+    lock to the host tempo / position from the AudioPlayHead.
+*/
+class ModulationBus
+{
+public:
+    enum Source
+    {
+        PhaserLfo,
+        ChorusLfo,
+        NumSources
+    };
+
+    static constexpr size_t maxChannels = 2;
+
+    struct LfoSettings
+    {
+        float rateHz = 1.f;
+        bool tempoSync = false;
+        double beatsPerCycle = 1.0;
+        float stereoPhaseOffset = 0.f;  // in cycles, 0.5 = channels in anti-phase
+        double initialPhase = 0.0;      // in cycles, applied on reset()
+    };
+
+    void prepare(double sampleRate, int maximumBlockSize);
+    void reset();
+
+    // distance between control points, 1 = per-sample modulation
+    void setInterval(int numSamples) noexcept { interval = juce::jmax(1, numSamples); }
+    int getInterval() const noexcept { return interval; }
+
+    LfoSettings& getSettings(Source source) noexcept { return lfos[source].settings; }
+
+    // audio thread, once per block before any stage runs
+    void generate(int numSamples, const juce::AudioPlayHead::PositionInfo* position) noexcept;
+
+    // takes the points other's last generate() rendered, so a stage can read them after other has moved on;
+    // both prepared for the same block size, nothing is allocated
+    void copyBlockFrom(const ModulationBus& other) noexcept;
+
+    // value in [-1, 1] at a sample offset into the block passed to generate()
+    float getValue(Source source, size_t channel, int sampleOffset) const noexcept
+    {
+        auto& lfo = lfos[source];
+        auto* points = lfo.points[juce::jmin(channel, maxChannels - 1)].data();
+
+        auto index = sampleOffset / blockInterval;
+        auto frac = static_cast<float>(sampleOffset - index * blockInterval) * inverseBlockInterval;
+
+        auto a = points[index];
+        auto b = points[index + 1];
+        return a + frac * (b - a);
+    }
+
+    static juce::StringArray getSyncDivisionChoices();
+    static double getSyncDivisionBeats(int choiceIndex);
+
+private:
+    struct Lfo
+    {
+        LfoSettings settings;
+        double phase = 0.0;
+        std::array<std::vector<float>, maxChannels> points;
+    };
+
+    std::array<Lfo, NumSources> lfos;
+
+    double sampleRate = 44100.0;
+    int interval = 4;
+    int maxPoints = 0;
+
+    // the interval actually used for the current block (larger than `interval` if the block didn't fit)
+    int blockInterval = 4;
+    float inverseBlockInterval = 0.25f;
+};
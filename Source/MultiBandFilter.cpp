@@ -0,0 +1,381 @@
+/*
+  ==============================================================================
+
+    MultiBandFilter.cpp
+
+  ==============================================================================
+*/
+
+#include "MultiBandFilter.h"
+
+void MultiBandFilter::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    jassert(spec.sampleRate > 0);
+    jassert(spec.numChannels > 0 && spec.numChannels <= maxChannels);
+
+    sampleRate = spec.sampleRate;
+
+    for (size_t band = 0; band < maxBands; ++band)
+        updateCoefficients(band);
+
+    updateActiveBands();
+    reset();
+}
+
+void MultiBandFilter::reset()
+{
+    for (auto& s : s1)
+        s.fill(0.f);
+
+    for (auto& s : s2)
+        s.fill(0.f);
+}
+
+void MultiBandFilter::setBand(size_t band, Mode mode, float frequencyHz, float q, float gainDb) noexcept
+{
+    jassert(band < maxBands);
+
+    Settings newSettings{ mode, frequencyHz, q, gainDb };
+
+    if (newSettings == settings[band])
+        return;
+
+    auto wasActive = isActive(settings[band]);
+    settings[band] = newSettings;
+    updateCoefficients(band);
+
+    if (wasActive == isActive(newSettings))
+        return;
+
+    // a band switched out starts from rest when it's switched back in
+    s1[band].fill(0.f);
+    s2[band].fill(0.f);
+
+    updateActiveBands();
+}
+
+void MultiBandFilter::updateActiveBands() noexcept
+{
+    numActive = 0;
+
+    for (size_t band = 0; band < maxBands; ++band)
+        if (isActive(settings[band]))
+            active[numActive++] = band;
+}
+
+void MultiBandFilter::updateCoefficients(size_t band) noexcept
+{
+    // the formulas of juce::dsp::IIR::Coefficients, in double like them
+    auto& s = settings[band];
+    auto frequency = juce::jlimit(BiquadTrigGrid::minFrequency, 0.49 * sampleRate, static_cast<double>(s.frequency));
+    auto q = juce::jmax(0.01, static_cast<double>(s.q));
+
+    auto* grid = trigGrid != nullptr && trigGrid->sampleRate == sampleRate ? trigGrid : nullptr;
+    auto trig = grid != nullptr ? grid->lookup(frequency) : BiquadTrigGrid::Values{};
+
+    double b0, b1, b2, a0, a1, a2;
+
+    if (s.mode == Peak)
+    {
+        auto A = std::sqrt(juce::Decibels::decibelsToGain(static_cast<double>(s.gainDb), -300.0));
+        auto omega = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+        auto alpha = (grid != nullptr ? trig.sinOmega : std::sin(omega)) / (q * 2.0);
+        auto c2 = grid != nullptr ? -2.0 + 2.0 * trig.oneMinusCosOmega : -2.0 * std::cos(omega);
+
+        b0 = 1.0 + alpha * A;
+        b1 = c2;
+        b2 = 1.0 - alpha * A;
+        a0 = 1.0 + alpha / A;
+        a1 = c2;
+        a2 = 1.0 - alpha / A;
+    }
+    else
+    {
+        auto n = grid != nullptr ? trig.cotHalfOmega : 1.0 / std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+        auto nSquared = n * n;
+        auto invQ = 1.0 / q;
+        auto c1 = 1.0 / (1.0 + invQ * n + nSquared);
+
+        a0 = 1.0;
+        a1 = c1 * 2.0 * (1.0 - nSquared);
+        a2 = c1 * (1.0 - invQ * n + nSquared);
+
+        switch (s.mode)
+        {
+        case BandPass:
+            b0 = c1 * n * invQ;
+            b1 = 0.0;
+            b2 = -c1 * n * invQ;
+            break;
+
+        case Notch:
+            b0 = c1 * (1.0 + nSquared);
+            b1 = a1;
+            b2 = b0;
+            break;
+
+        case AllPass:
+        case Peak:
+        default:
+            b0 = a2;
+            b1 = a1;
+            b2 = 1.0;
+            break;
+        }
+    }
+
+    auto& c = coefficients[band];
+    c.b0 = static_cast<float>(b0 / a0);
+    c.b1 = static_cast<float>(b1 / a0);
+    c.b2 = static_cast<float>(b2 / a0);
+    c.a1 = static_cast<float>(a1 / a0);
+    c.a2 = static_cast<float>(a2 / a0);
+}
+
+void MultiBandFilter::copyChannelState(size_t source, size_t destination) noexcept
+{
+    jassert(source < maxChannels && destination < maxChannels);
+
+    for (size_t band = 0; band < maxBands; ++band)
+    {
+        s1[band][destination] = s1[band][source];
+        s2[band][destination] = s2[band][source];
+    }
+}
+
+void MultiBandFilter::process(const juce::dsp::ProcessContextReplacing<float>& context)
+{
+    auto& inputBlock = context.getInputBlock();
+    auto& outputBlock = context.getOutputBlock();
+
+    if (context.usesSeparateInputAndOutputBlocks())
+        outputBlock.copyFrom(inputBlock);
+
+    if (context.isBypassed || numActive == 0 || outputBlock.getNumSamples() == 0)
+        return;
+
+    auto stereo = outputBlock.getNumChannels() >= 2;
+
+    if (numActive == 1)
+        stereo ? processCascade<1, 2>(outputBlock) : processCascade<1, 1>(outputBlock);
+    else if (numActive <= 4)
+        stereo ? processCascade<4, 2>(outputBlock) : processCascade<4, 1>(outputBlock);
+    else
+        stereo ? processCascade<8, 2>(outputBlock) : processCascade<8, 1>(outputBlock);
+}
+
+template<size_t Channels, typename Register>
+Register MultiBandFilter::shiftLanesUp(Register previous, Register next) noexcept
+{
+    // Register is only ever Vec; as a template parameter it keeps the native shuffles below from
+    // being checked against a register type they weren't written for
+    using Vec = Register;
+    static_assert(Channels < Vec::SIMDNumElements);
+
+   #if JUCE_USE_SSE_INTRINSICS
+    if constexpr (Vec::SIMDNumElements == 4)
+    {
+        if constexpr (Channels == 2)
+            return Vec::fromNative(_mm_shuffle_ps(previous.value, next.value, _MM_SHUFFLE(1, 0, 3, 2)));
+        else
+        {
+            // [p3 p3 n0 n0], then [p3 n0 n1 n2]
+            auto joined = _mm_shuffle_ps(previous.value, next.value, _MM_SHUFFLE(0, 0, 3, 3));
+            return Vec::fromNative(_mm_shuffle_ps(joined, next.value, _MM_SHUFFLE(2, 1, 2, 0)));
+        }
+    }
+    #if defined(__AVX2__)
+    else if constexpr (Vec::SIMDNumElements == 8)
+    {
+        // [p4 .. p7 | n0 .. n3], then the same moves as above inside each half
+        auto joined = _mm256_permute2f128_ps(previous.value, next.value, 0x21);
+
+        if constexpr (Channels == 2)
+            return Vec::fromNative(_mm256_shuffle_ps(joined, next.value, _MM_SHUFFLE(1, 0, 3, 2)));
+        else
+            return Vec::fromNative(_mm256_castsi256_ps(_mm256_alignr_epi8(_mm256_castps_si256(next.value), _mm256_castps_si256(joined), 12)));
+    }
+    #endif
+    else
+   #elif JUCE_USE_ARM_NEON
+    if constexpr (Vec::SIMDNumElements == 4)
+        return Vec::fromNative(vextq_f32(previous.value, next.value, 4 - Channels));
+    else
+   #endif
+    {
+        // anything else goes through memory
+        alignas(Vec::SIMDRegisterSize) std::array<float, 2 * Vec::SIMDNumElements> pair;
+        alignas(Vec::SIMDRegisterSize) std::array<float, Vec::SIMDNumElements> shifted;
+
+        previous.copyToRawArray(pair.data());
+        next.copyToRawArray(pair.data() + Vec::size());
+        std::copy(pair.begin() + Vec::size() - Channels, pair.end() - Channels, shifted.begin());
+
+        return Vec::fromRawArray(shifted.data());
+    }
+}
+
+template<size_t Bands, size_t Channels>
+void MultiBandFilter::processCascade(const juce::dsp::AudioBlock<float>& block) noexcept
+{
+    // lane k * Channels + ch is band k of channel ch, so moving every band's output on to the next
+    // band is a shift of all the lanes, Channels lanes up. Lanes past the last band pass their input through
+    constexpr size_t numRegisters = (Bands * Channels + Vec::size() - 1) / Vec::size();
+    constexpr size_t lanes = numRegisters * Vec::size();
+
+    // the register and the lanes in it where the last band's output comes out
+    constexpr size_t outputRegister = (Bands - 1) * Channels / Vec::size();
+    constexpr size_t outputLane = (Bands - 1) * Channels % Vec::size();
+
+    alignas(Vec::SIMDRegisterSize) std::array<float, lanes> b0, b1, b2, a1, a2, z1, z2;
+    std::array<size_t, lanes> laneBand;
+
+    for (size_t lane = 0; lane < lanes; ++lane)
+    {
+        auto k = lane / Channels;
+        auto ch = lane % Channels;
+        laneBand[lane] = k;
+
+        Coefficients c;
+        z1[lane] = z2[lane] = 0.f;
+
+        if (k < juce::jmin(Bands, numActive))
+        {
+            auto band = active[k];
+            c = coefficients[band];
+            z1[lane] = s1[band][ch];
+            z2[lane] = s2[band][ch];
+        }
+
+        b0[lane] = c.b0;
+        b1[lane] = c.b1;
+        b2[lane] = c.b2;
+        a1[lane] = c.a1;
+        a2[lane] = c.a2;
+    }
+
+    std::array<Vec, numRegisters> vb0, vb1, vb2, va1, va2, vz1, vz2, y;
+
+    for (size_t r = 0; r < numRegisters; ++r)
+    {
+        auto offset = r * Vec::size();
+        vb0[r] = Vec::fromRawArray(b0.data() + offset);
+        vb1[r] = Vec::fromRawArray(b1.data() + offset);
+        vb2[r] = Vec::fromRawArray(b2.data() + offset);
+        va1[r] = Vec::fromRawArray(a1.data() + offset);
+        va2[r] = Vec::fromRawArray(a2.data() + offset);
+        vz1[r] = Vec::fromRawArray(z1.data() + offset);
+        vz2[r] = Vec::fromRawArray(z2.data() + offset);
+        y[r] = Vec::expand(0.f);
+    }
+
+    std::array<float*, Channels> io;
+
+    for (size_t ch = 0; ch < Channels; ++ch)
+        io[ch] = block.getChannelPointer(ch);
+
+    auto numSamples = block.getNumSamples();
+    auto numSteps = numSamples + Bands - 1;
+
+    // one register per step, the input sample in its top Channels lanes and the output wherever the
+    // last band's lanes are, so a step loads and stores whole registers
+    alignas(Vec::SIMDRegisterSize) std::array<float, maxStepsPerChunk * Vec::SIMDNumElements> inputs{}, outputs;
+
+    // band k works on sample t - k; while filling and draining, lanes without a sample keep their state
+    auto step = [&](size_t t, size_t slot, auto masked)
+        {
+            std::array<Vec, numRegisters> x;
+            x[0] = shiftLanesUp<Channels>(Vec::fromRawArray(inputs.data() + slot), y[0]);
+
+            for (size_t r = 1; r < numRegisters; ++r)
+                x[r] = shiftLanesUp<Channels>(y[r - 1], y[r]);
+
+            std::array<Vec, numRegisters> nextZ1, nextZ2;
+
+            for (size_t r = 0; r < numRegisters; ++r)
+            {
+                y[r] = vb0[r] * x[r] + vz1[r];
+                nextZ1[r] = vb1[r] * x[r] - va1[r] * y[r] + vz2[r];
+                nextZ2[r] = vb2[r] * x[r] - va2[r] * y[r];
+            }
+
+            if constexpr (decltype(masked)::value)
+            {
+                // only the Bands - 1 steps at each end of a block, so lane by lane
+                for (size_t r = 0; r < numRegisters; ++r)
+                {
+                    alignas(Vec::SIMDRegisterSize) std::array<float, Vec::SIMDNumElements> current1, current2, next1, next2;
+                    vz1[r].copyToRawArray(current1.data());
+                    vz2[r].copyToRawArray(current2.data());
+                    nextZ1[r].copyToRawArray(next1.data());
+                    nextZ2[r].copyToRawArray(next2.data());
+
+                    for (size_t i = 0; i < Vec::size(); ++i)
+                    {
+                        auto band = laneBand[r * Vec::size() + i];
+
+                        if (t >= band && t - band < numSamples)
+                        {
+                            current1[i] = next1[i];
+                            current2[i] = next2[i];
+                        }
+                    }
+
+                    vz1[r] = Vec::fromRawArray(current1.data());
+                    vz2[r] = Vec::fromRawArray(current2.data());
+                }
+            }
+            else
+            {
+                vz1 = nextZ1;
+                vz2 = nextZ2;
+            }
+
+            y[outputRegister].copyToRawArray(outputs.data() + slot);
+        };
+
+    for (size_t first = 0; first < numSteps; first += maxStepsPerChunk)
+    {
+        auto numChunkSteps = juce::jmin(maxStepsPerChunk, numSteps - first);
+
+        for (size_t i = 0; i < numChunkSteps; ++i)
+            for (size_t ch = 0; ch < Channels; ++ch)
+                inputs[i * Vec::size() + Vec::size() - Channels + ch] = first + i < numSamples ? io[ch][first + i] : 0.f;
+
+        for (size_t i = 0; i < numChunkSteps; ++i)
+        {
+            auto t = first + i;
+            auto slot = i * Vec::size();
+
+            if (t < Bands - 1 || t >= numSamples)
+                step(t, slot, std::true_type{});
+            else
+                step(t, slot, std::false_type{});
+        }
+
+        for (size_t i = 0; i < numChunkSteps; ++i)
+        {
+            auto t = first + i;
+
+            if (t >= Bands - 1)
+                for (size_t ch = 0; ch < Channels; ++ch)
+                    io[ch][t - (Bands - 1)] = outputs[i * Vec::size() + outputLane + ch];
+        }
+    }
+
+    for (size_t r = 0; r < numRegisters; ++r)
+    {
+        vz1[r].copyToRawArray(z1.data() + r * Vec::size());
+        vz2[r].copyToRawArray(z2.data() + r * Vec::size());
+    }
+
+    for (size_t k = 0; k < juce::jmin(Bands, numActive); ++k)
+    {
+        for (size_t ch = 0; ch < Channels; ++ch)
+        {
+            auto band = active[k];
+            s1[band][ch] = juce::dsp::util::snapToZero(z1[k * Channels + ch]);
+            s2[band][ch] = juce::dsp::util::snapToZero(z2[k * Channels + ch]);
+        }
+    }
+}
@@ -0,0 +1,122 @@
+/*
+  ==============================================================================
+
+    MultiBandFilter.h
+
+    Stereo cascade of up to 8 biquads, replaces the per-channel
+    juce::dsp::IIR::Filter of the general filter stage.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SharedTables.h"
+
+/*
+    Each band is a peak, band-pass, notch or all-pass biquad with the
+    coefficients juce::dsp::IIR::Coefficients would make, run in transposed
+    direct form II like juce::dsp::IIR::Filter, and the bands are in series.
+
+    A cascade has a sample-to-sample dependency from one band to the next,
+    so the bands don't run side by side on the same sample. Instead they
+    run as a wavefront: at step t band k works on sample t - k, so all of
+    them do one sample per step. Their state is transposed into the lanes
+    of juce::dsp::SIMDRegisters (one lane per band and channel, both
+    channels together) and each step is a few multiply-adds over those
+    registers plus a shift of every band's output into the next band's
+    input lane, one shuffle per register. A block of n samples takes
+    n + bands - 1 steps, and the first and last bands - 1 of them leave the
+    lanes with no sample yet or no sample left as they were. So each band
+    has seen exactly n samples at the end of every block: no latency, and
+    the output is the same as running the biquads one after another.
+
+    Only the bands that change the signal are run: a peak band at 0 dB is
+    skipped, and its state cleared so it starts from rest when it comes back.
+    The lanes are sized for the bands that are left (1, 4 or 8 per channel),
+    rounded up to whole registers, with unused lanes passing their input
+    through.
+
+    The shuffles are native for SSE, AVX2 and NEON registers; anything else
+    moves the lanes through memory, which is correct but slower.
+*/
+class MultiBandFilter : public juce::dsp::ProcessorBase
+{
+public:
+    static constexpr size_t maxChannels = 2;
+    static constexpr size_t maxBands = 8;
+
+    // in the order of the processor's General Filter Mode choices
+    enum Mode
+    {
+        Peak,
+        BandPass,
+        Notch,
+        AllPass
+    };
+
+    void prepare(const juce::dsp::ProcessSpec& spec) override;
+    void process(const juce::dsp::ProcessContextReplacing<float>& context) override;
+    void reset() override;
+
+    // only recomputes the band's coefficients if something changed
+    void setBand(size_t band, Mode mode, float frequencyHz, float q, float gainDb) noexcept;
+
+    /*
+        nullptr computes the coefficients with sin, cos and tan; a grid for
+        another sample rate is ignored. Only coefficients computed after the
+        call use it, the ones in place stay until their band changes.
+    */
+    void setTrigGrid(const BiquadTrigGrid* grid) noexcept { trigGrid = grid; }
+
+    int getNumActiveBands() const noexcept { return static_cast<int>(numActive); }
+
+    // makes one channel's state a copy of another's, for the processor's dual-mono path
+    void copyChannelState(size_t source, size_t destination) noexcept;
+
+private:
+    struct Settings
+    {
+        Mode mode = Peak;
+        float frequency = 1000.f, q = 1.f, gainDb = 0.f;
+
+        bool operator==(const Settings&) const = default;
+    };
+
+    // normalised by a0: y = b0 x + s1, s1 = b1 x - a1 y + s2, s2 = b2 x - a2 y
+    struct Coefficients
+    {
+        float b0 = 1.f, b1 = 0.f, b2 = 0.f, a1 = 0.f, a2 = 0.f;
+    };
+
+    static bool isActive(const Settings& settings) noexcept { return settings.mode != Peak || settings.gainDb != 0.f; }
+
+    void updateCoefficients(size_t band) noexcept;
+    void updateActiveBands() noexcept;
+
+    using Vec = juce::dsp::SIMDRegister<float>;
+
+    // [the top Channels lanes of previous, then next's lanes]: every lane moved Channels lanes up across the pair
+    template<size_t Channels, typename Register>
+    static Register shiftLanesUp(Register previous, Register next) noexcept;
+
+    template<size_t Bands, size_t Channels>
+    void processCascade(const juce::dsp::AudioBlock<float>& block) noexcept;
+
+    // processCascade() moves the inputs and outputs between the block and whole registers this many steps at a time
+    static constexpr size_t maxStepsPerChunk = 64;
+
+    double sampleRate = 44100.0;
+    const BiquadTrigGrid* trigGrid = nullptr;
+
+    std::array<Settings, maxBands> settings{};
+    std::array<Coefficients, maxBands> coefficients{};
+
+    // the bands that run, in band order
+    std::array<size_t, maxBands> active{};
+    size_t numActive = 0;
+
+    // per band and channel, kept in band order so bands switching in and out don't move anyone's state
+    std::array<std::array<float, maxChannels>, maxBands> s1{}, s2{};
+};
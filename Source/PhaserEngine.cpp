@@ -0,0 +1,239 @@
+/*
+  ==============================================================================
+
+    PhaserEngine.cpp
+
+  ==============================================================================
+*/
+
+#include "PhaserEngine.h"
+
+void PhaserEngine::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    jassert(spec.sampleRate > 0);
+    jassert(spec.numChannels > 0 && spec.numChannels <= maxChannels);
+
+    sampleRate = spec.sampleRate;
+    maxFrequency = static_cast<float>(juce::jmin(20000.0, 0.49 * sampleRate));
+
+    setCentreFrequency(centreFrequency);
+    reset();
+}
+
+void PhaserEngine::reset()
+{
+    for (auto& s : state)
+        s.fill(0.f);
+
+    lastOutput.fill(0.f);
+
+    updateControlRate();
+    oscVolume.setCurrentAndTargetValue(oscVolume.getTargetValue());
+
+    samplesUntilControl = 0;
+    firstControlUpdate = true;
+}
+
+void PhaserEngine::setControlInterval(int numSamples) noexcept
+{
+    numSamples = juce::jlimit(1, 256, numSamples);
+
+    if (numSamples == controlInterval)
+        return;
+
+    controlInterval = numSamples;
+    updateControlRate();
+}
+
+void PhaserEngine::updateControlRate() noexcept
+{
+    // keeps the depth glide where it is, only its step size changes
+    auto volume = oscVolume.getCurrentValue();
+    auto volumeTarget = oscVolume.getTargetValue();
+    oscVolume.reset(sampleRate / controlInterval, 0.05);
+    oscVolume.setCurrentAndTargetValue(volume);
+    oscVolume.setTargetValue(volumeTarget);
+
+    // feedback / mix glide over ~50ms like juce::dsp::Phaser, stepped per control interval
+    rampCoefficient = juce::jmin(1.f, static_cast<float>(controlInterval) / (0.05f * static_cast<float>(sampleRate)));
+}
+
+void PhaserEngine::setCentreFrequency(float newCentreHz) noexcept
+{
+    centreFrequency = newCentreHz;
+    normCentreFrequency = juce::mapFromLog10(centreFrequency, 20.f, maxFrequency);
+}
+
+void PhaserEngine::setNumStages(int newNumStages) noexcept
+{
+    newNumStages = juce::jlimit(1, maxStages, newNumStages);
+
+    // stages switched in start from rest instead of whatever they held when switched out
+    for (auto i = numStages; i < newNumStages; ++i)
+        state[static_cast<size_t>(i)].fill(0.f);
+
+    numStages = newNumStages;
+}
+
+void PhaserEngine::copyChannelState(size_t source, size_t destination) noexcept
+{
+    jassert(source < maxChannels && destination < maxChannels);
+
+    for (auto& s : state)
+        s[destination] = s[source];
+
+    lastOutput[destination] = lastOutput[source];
+    coefficient[destination] = coefficient[source];
+}
+
+void PhaserEngine::updateControl(int sampleOffset, size_t numChannels) noexcept
+{
+    jassert(modulation != nullptr);
+
+    auto volume = oscVolume.getNextValue();
+    auto* grid = coefficientGrid != nullptr && coefficientGrid->sampleRate == sampleRate ? coefficientGrid : nullptr;
+
+    for (size_t ch = 0; ch < numChannels; ++ch)
+    {
+        auto lfo = modulation->getValue(modulationSource, ch, sampleOffset) * volume;
+
+        auto normFrequency = juce::jlimit(0.f, 1.f, lfo + normCentreFrequency);
+
+        if (grid != nullptr)
+        {
+            coefficient[ch] = grid->lookup(normFrequency);
+            continue;
+        }
+
+        auto frequency = juce::mapToLog10(normFrequency, 20.f, maxFrequency);
+
+        auto g = std::tan(juce::MathConstants<float>::pi * frequency / static_cast<float>(sampleRate));
+        coefficient[ch] = g / (1.f + g);
+    }
+
+    auto interval = static_cast<float>(controlInterval);
+
+    if (firstControlUpdate)
+    {
+        feedback = feedbackTarget;
+        mix = mixTarget;
+        firstControlUpdate = false;
+    }
+
+    auto nextFeedback = feedback + (feedbackTarget - feedback) * rampCoefficient;
+    auto nextMix = mix + (mixTarget - mix) * rampCoefficient;
+
+    feedbackIncrement = (nextFeedback - feedback) / interval;
+    mixIncrement = (nextMix - mix) / interval;
+
+    samplesUntilControl = controlInterval;
+}
+
+void PhaserEngine::process(const juce::dsp::ProcessContextReplacing<float>& context)
+{
+    auto& inputBlock = context.getInputBlock();
+    auto& outputBlock = context.getOutputBlock();
+
+    if (context.usesSeparateInputAndOutputBlocks())
+        outputBlock.copyFrom(inputBlock);
+
+    if (context.isBypassed)
+        return;
+
+    auto numChannels = juce::jmin(outputBlock.getNumChannels(), maxChannels);
+    auto numSamples = outputBlock.getNumSamples();
+
+    for (size_t start = 0; start < numSamples; start += chunkSize)
+    {
+        auto chunk = static_cast<int>(juce::jmin(chunkSize, numSamples - start));
+
+        if (numChannels == 2)
+            processChunk<2>(outputBlock, start, chunk);
+        else
+            processChunk<1>(outputBlock, start, chunk);
+    }
+
+    for (auto& s : state)
+        for (auto& v : s)
+            v = juce::dsp::util::snapToZero(v);
+
+    for (auto& v : lastOutput)
+        v = juce::dsp::util::snapToZero(v);
+}
+
+template<size_t Lanes>
+void PhaserEngine::processChunk(const juce::dsp::AudioBlock<float>& block, size_t start, int numSamples) noexcept
+{
+    std::array<float*, Lanes> io;
+
+    for (size_t ch = 0; ch < Lanes; ++ch)
+        io[ch] = block.getChannelPointer(ch) + start;
+
+    // the lanes past the channels get silence, so whatever they held settles to 0
+    for (int i = 0; i < numSamples; ++i)
+        for (size_t lane = 0; lane < Vec::size(); ++lane)
+            frames[static_cast<size_t>(i) * Vec::size() + lane] = lane < Lanes ? io[lane][i] : 0.f;
+
+    for (int pos = 0; pos < numSamples;)
+    {
+        if (samplesUntilControl == 0)
+            updateControl(static_cast<int>(start) + pos, Lanes);
+
+        auto segment = juce::jmin(samplesUntilControl, numSamples - pos);
+        processSegment(static_cast<size_t>(pos), segment);
+
+        pos += segment;
+        samplesUntilControl -= segment;
+    }
+
+    for (int i = 0; i < numSamples; ++i)
+        for (size_t ch = 0; ch < Lanes; ++ch)
+            io[ch][i] = frames[static_cast<size_t>(i) * Vec::size() + ch];
+}
+
+void PhaserEngine::processSegment(size_t offset, int numSamples) noexcept
+{
+    // the TPT stage v = G (x - s), y = v + s, s' = y + v, x' = 2y - x, multiplied out:
+    //     x' = (2G - 1) x + 2 (1 - G) s        s' = 2G x + (1 - 2G) s
+    // so the signal only goes through one multiply-add per stage; the state's terms are off its path
+    auto twoG = Vec::fromRawArray(coefficient.data()) * 2.f;
+    auto a = twoG - Vec::expand(1.f);
+    auto b = Vec::expand(2.f) - twoG;
+    auto d = Vec::expand(1.f) - twoG;
+
+    auto last = Vec::fromRawArray(lastOutput.data());
+
+    std::array<Vec, maxStages> s;
+
+    for (int n = 0; n < numStages; ++n)
+        s[static_cast<size_t>(n)] = Vec::fromRawArray(state[static_cast<size_t>(n)].data());
+
+    auto* frame = frames.data() + offset * Vec::size();
+
+    for (int i = 0; i < numSamples; ++i, frame += Vec::size())
+    {
+        auto input = Vec::fromRawArray(frame);
+        auto x = input - last;
+
+        // TPT allpass cascade, one lane per channel
+        for (int n = 0; n < numStages; ++n)
+        {
+            auto& z = s[static_cast<size_t>(n)];
+            auto stateTerm = b * z;
+
+            z = Vec::multiplyAdd(twoG * x, d, z);
+            x = Vec::multiplyAdd(stateTerm, a, x);
+        }
+
+        last = x * feedback;
+        (input + (x - input) * mix).copyToRawArray(frame);
+
+        feedback += feedbackIncrement;
+        mix += mixIncrement;
+    }
+
+    for (int n = 0; n < numStages; ++n)
+        s[static_cast<size_t>(n)].copyToRawArray(state[static_cast<size_t>(n)].data());
+
+    last.copyToRawArray(lastOutput.data());
+}
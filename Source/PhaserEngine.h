@@ -0,0 +1,112 @@
+/*
+  ==============================================================================
+
+    PhaserEngine.h
+
+    Stereo first-order allpass phaser, replaces juce::dsp::Phaser.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ModulationBus.h"
+#include "SharedTables.h"
+
+/*
+    Follows juce::dsp::Phaser (sine LFO, log-mapped sweep around the centre
+    frequency, TPT first-order allpass stages, feedback subtracted from the
+    input, linear dry / wet) so it nulls against it with the default 6 stages
+    and a control interval of 4, but:
+
+    - the LFO comes from the processor's ModulationBus (start it half a cycle
+      in to match juce::dsp::Oscillator), so both channels share one phase
+      and can be offset for stereo width
+    - the allpass coefficient is computed once per control interval and
+      channel (one tan) and shared by every stage
+    - both channels are processed together on SIMDRegisters, one lane per
+      channel. A chunk of up to chunkSize frames is interleaved into a
+      scratch first and taken apart again after, so every register load and
+      store is a whole frame
+    - the number of stages is selectable (4 / 6 / 8 / 12)
+*/
+class PhaserEngine : public juce::dsp::ProcessorBase
+{
+public:
+    static constexpr size_t maxChannels = 2;
+    static constexpr int maxStages = 12;
+
+    void prepare(const juce::dsp::ProcessSpec& spec) override;
+    void process(const juce::dsp::ProcessContextReplacing<float>& context) override;
+    void reset() override;
+
+    void setModulation(const ModulationBus* bus, ModulationBus::Source source) noexcept
+    {
+        modulation = bus;
+        modulationSource = source;
+    }
+
+    void setDepth(float newDepth) noexcept { oscVolume.setTargetValue(newDepth * 0.5f); }
+    void setCentreFrequency(float newCentreHz) noexcept;
+    void setFeedback(float newFeedback) noexcept { feedbackTarget = newFeedback; }
+    void setMix(float newMix) noexcept { mixTarget = newMix; }
+
+    void setNumStages(int newNumStages) noexcept;
+
+    // nullptr computes every coefficient with tan; a grid for another sample rate is ignored
+    void setCoefficientGrid(const AllpassCoefficientGrid* grid) noexcept { coefficientGrid = grid; }
+
+    void setControlInterval(int numSamples) noexcept;
+
+    // makes one channel's state a copy of another's, for the processor's dual-mono path
+    void copyChannelState(size_t source, size_t destination) noexcept;
+
+private:
+    void updateControlRate() noexcept;
+    void updateControl(int sampleOffset, size_t numChannels) noexcept;
+
+    using Vec = juce::dsp::SIMDRegister<float>;
+
+    static constexpr size_t chunkSize = 64;
+    static_assert(maxChannels <= Vec::SIMDNumElements);
+
+    template<size_t Lanes>
+    void processChunk(const juce::dsp::AudioBlock<float>& block, size_t start, int numSamples) noexcept;
+
+    // frames from offset in the chunk's scratch
+    void processSegment(size_t offset, int numSamples) noexcept;
+
+    double sampleRate = 44100.0;
+    float maxFrequency = 20000.f;
+
+    const ModulationBus* modulation = nullptr;
+    const AllpassCoefficientGrid* coefficientGrid = nullptr;
+    ModulationBus::Source modulationSource = ModulationBus::PhaserLfo;
+
+    float centreFrequency = 1000.f;
+    float normCentreFrequency = 0.5f;
+    float feedbackTarget = 0.f;
+    float mixTarget = 0.5f;
+
+    juce::SmoothedValue<float> oscVolume;
+
+    int numStages = 6;
+    int controlInterval = 4;
+    int samplesUntilControl = 0;
+
+    // allpass coefficient G = g / (1 + g) per channel, shared by all stages; a register wide
+    alignas(Vec::SIMDRegisterSize) std::array<float, Vec::SIMDNumElements> coefficient{};
+
+    float feedback = 0.f, feedbackIncrement = 0.f;
+    float mix = 0.f, mixIncrement = 0.f;
+    float rampCoefficient = 1.f;
+    bool firstControlUpdate = true;
+
+    // a register per stage, and the feedback; lanes past the channels stay at 0
+    alignas(Vec::SIMDRegisterSize) std::array<std::array<float, Vec::SIMDNumElements>, maxStages> state{};
+    alignas(Vec::SIMDRegisterSize) std::array<float, Vec::SIMDNumElements> lastOutput{};
+
+    // one chunk, interleaved a register per frame
+    alignas(Vec::SIMDRegisterSize) std::array<float, chunkSize * Vec::SIMDNumElements> frames{};
+};
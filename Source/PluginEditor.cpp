@@ -16,29 +16,95 @@ AudioPluginprojectAudioProcessorEditor::AudioPluginprojectAudioProcessorEditor (
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
 
-    dspOrderButton.onClick = [this]()
-        {
-            juce::Random r;
-            AudioPluginprojectAudioProcessor::DSP_Order dspOrder;
+    background.setBufferedToImage(true);
+    background.setInterceptsMouseClicks(false, false);
+    addAndMakeVisible(background);
 
-            auto range = juce::Range<int>
-                (static_cast<int>(AudioPluginprojectAudioProcessor::DSP_Option::Phase),
-                    static_cast<int>(AudioPluginprojectAudioProcessor::DSP_Option::End_Of_List));
+    auto addPanel = [this](juce::String title, const std::vector<juce::RangedAudioParameter*>& params)
+        {
+            auto& panel = stagePanels.emplace_back();
+            panel.title = title;
 
-            for (auto& v : dspOrder)
+            for (auto* param : params)
             {
-                auto entry = r.nextInt(range);
-                v = static_cast<AudioPluginprojectAudioProcessor::DSP_Option>(entry);
+                jassert(param != nullptr);
+                auto& knob = panel.knobs.emplace_back(std::make_unique<ParameterKnob>(*param));
+                addAndMakeVisible(*knob);
             }
-            DBG(juce::Base64::toBase64(dspOrder.data(), dspOrder.size()));
-            jassertfalse;
-
-            audioProcessor.dsporderfifo.push(dspOrder);
         };
 
+    addPanel("Phaser", { audioProcessor.phaserRateHz, audioProcessor.phaserDepthPercent,
+        audioProcessor.phaserCenterFreqHz, audioProcessor.phaserFeedbackPercent,
+        audioProcessor.phaserMixPercent, audioProcessor.phaserStages, audioProcessor.phaserStereoPhase,
+        audioProcessor.phaserTempoSync, audioProcessor.phaserSyncDivision, audioProcessor.phaserBypass });
+
+    addPanel("Chorus", { audioProcessor.chorusRateHz, audioProcessor.chorusDepthPercent,
+        audioProcessor.chorusCenterDelayMs, audioProcessor.chorusFeedbackPercent,
+        audioProcessor.chorusMixPercent, audioProcessor.chorusStereoPhase, audioProcessor.chorusTempoSync,
+        audioProcessor.chorusSyncDivision, audioProcessor.chorusBypass });
+
+    addPanel("Overdrive", { audioProcessor.overdriveSaturation, audioProcessor.overdriveBypass });
+
+    addPanel("Ladder Filter", { audioProcessor.LadderFilterMode, audioProcessor.LadderFilterCutoffHz,
+        audioProcessor.LadderFilterResonence, audioProcessor.LadderFilterDrive,
+        audioProcessor.LadderFilterBypass });
+
+    // four knobs per band, then the bypass; only the selected band's are showing
+    std::vector<juce::RangedAudioParameter*> generalFilterParams;
+
+    for (size_t band = 0; band < AudioPluginprojectAudioProcessor::numGeneralFilterBands; ++band)
+    {
+        generalFilterParams.insert(generalFilterParams.end(), { audioProcessor.generalFilterBandMode[band],
+            audioProcessor.generalFilterBandFreqHz[band], audioProcessor.generalFilterBandQuality[band],
+            audioProcessor.generalFilterBandGain[band] });
+
+        generalFilterBandSelector.addItem("Band " + juce::String(band + 1), static_cast<int>(band + 1));
+    }
+
+    generalFilterParams.push_back(audioProcessor.GeneralFilterBypass);
+    addPanel("General Filter", generalFilterParams);
+
+    generalFilterPanel = stagePanels.size() - 1;
+    generalFilterBandSelector.onChange = [this] { showGeneralFilterBand(generalFilterBandSelector.getSelectedItemIndex()); };
+    generalFilterBandSelector.setSelectedItemIndex(0, juce::dontSendNotification);
+    addAndMakeVisible(generalFilterBandSelector);
+    stagePanels.back().footer = &generalFilterBandSelector;
+    showGeneralFilterBand(0);
+
+    addPanel("Delay", { audioProcessor.delayTimeMs, audioProcessor.delayFeedbackPercent,
+        audioProcessor.delayMixPercent, audioProcessor.delayTempoSync, audioProcessor.delaySyncDivision,
+        audioProcessor.delayPingPong, audioProcessor.delayLowCutHz, audioProcessor.delayHighCutHz,
+        audioProcessor.delayBypass });
+
+    addPanel("Convolution", { audioProcessor.convolutionMix, audioProcessor.convolutionBypass });
+
+    impulseResponseButton.onClick = [this] { chooseImpulseResponse(); };
+    updateImpulseResponseButton();
+    addAndMakeVisible(impulseResponseButton);
+    stagePanels.back().footer = &impulseResponseButton;
+
+    addPanel("Reverb", { audioProcessor.reverbSize, audioProcessor.reverbDecaySeconds,
+        audioProcessor.reverbDampingHz, audioProcessor.reverbMixPercent, audioProcessor.reverbBypass });
 
-    addAndMakeVisible(dspOrderButton);
-    setSize (400, 300);
+    addPanel("Limiter", { audioProcessor.limiterCeilingDb, audioProcessor.limiterLookaheadMs,
+        audioProcessor.limiterReleaseMs, audioProcessor.limiterBypass });
+
+    addPanel("Quality", { audioProcessor.qualityMode, audioProcessor.offlineHighQuality,
+        audioProcessor.dualMonoFastPath, audioProcessor.freeUnusedStages });
+
+    traceButton.setButtonText(audioProcessor.isTracing() ? "Stop Trace" : "Record Trace");
+    traceButton.onClick = [this] { toggleTrace(); };
+    addAndMakeVisible(traceButton);
+    stagePanels.back().footer = &traceButton;
+
+    addAndMakeVisible(dspOrderView);
+    addAndMakeVisible(stageMeters);
+    addAndMakeVisible(spectrum);
+
+    setOpaque(true);
+    setSize (1440, 700);
+
+    startTimerHz(frameRateHz);
 }
 
 AudioPluginprojectAudioProcessorEditor::~AudioPluginprojectAudioProcessorEditor()
@@ -46,20 +112,592 @@ AudioPluginprojectAudioProcessorEditor::~AudioPluginprojectAudioProcessorEditor(
 }
 
 //==============================================================================
+void AudioPluginprojectAudioProcessorEditor::timerCallback()
+{
+   #if MEASURE_EDITOR_FRAME_TIME
+    frameTimerCounter.start();
+   #endif
+
+    // every parameter / meter / spectrum change since the last frame ends up
+    // as at most one repaint per component here
+    for (auto& panel : stagePanels)
+        for (auto& knob : panel.knobs)
+            knob->refresh();
+
+    dspOrderView.refresh();
+    stageMeters.refresh();
+    spectrum.refresh();
+
+   #if MEASURE_EDITOR_FRAME_TIME
+    frameTimerCounter.stop();
+   #endif
+}
+
 void AudioPluginprojectAudioProcessorEditor::paint (juce::Graphics& g)
 {
+   #if MEASURE_EDITOR_FRAME_TIME
+    framePaintCounter.start();
+   #endif
+
     // (Our component is opaque, so we must completely fill the background with a solid colour)
     g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));
+}
 
-    g.setColour (juce::Colours::white);
-    g.setFont (juce::FontOptions (15.0f));
-    g.drawFittedText ("Hello World!", getLocalBounds(), juce::Justification::centred, 1);
+void AudioPluginprojectAudioProcessorEditor::paintOverChildren (juce::Graphics&)
+{
+   #if MEASURE_EDITOR_FRAME_TIME
+    framePaintCounter.stop();
+   #endif
 }
 
 void AudioPluginprojectAudioProcessorEditor::resized()
 {
-    // This is generally where you'll want to lay out the positions of any
-    // subcomponents in your editor..
+    auto bounds = getLocalBounds().reduced(8);
+
+    dspOrderView.setBounds(bounds.removeFromTop(48));
+    bounds.removeFromTop(8);
+
+    auto bottom = bounds.removeFromBottom(170);
+    spectrum.setBounds(bottom.removeFromLeft(bottom.getWidth() / 2).reduced(4));
+    stageMeters.setBounds(bottom.reduced(4));
+
+    background.setBounds(getLocalBounds());
+    background.panels.clear();
+
+    constexpr int titleHeight = 22;
+    constexpr int knobHeight = 72;
+    constexpr int knobsPerRow = 2;
+    constexpr int footerHeight = 28;
+
+    auto panelWidth = bounds.getWidth() / juce::jmax(1, static_cast<int>(stagePanels.size()));
+
+    for (auto& panel : stagePanels)
+    {
+        auto area = bounds.removeFromLeft(panelWidth).reduced(4);
+        background.panels.emplace_back(panel.title, area);
+
+        area.removeFromTop(titleHeight);
+        auto knobWidth = area.getWidth() / knobsPerRow;
+
+        // hidden knobs (the general filter's other bands) take no space
+        auto numShowing = 0;
+
+        for (auto& knob : panel.knobs)
+        {
+            if (! knob->isVisible())
+                continue;
+
+            auto column = numShowing % knobsPerRow;
+            auto row = numShowing / knobsPerRow;
+            ++numShowing;
+
+            knob->setBounds(area.getX() + column * knobWidth, area.getY() + row * knobHeight,
+                knobWidth, knobHeight);
+        }
+
+        if (panel.footer != nullptr)
+        {
+            auto rows = (numShowing + knobsPerRow - 1) / knobsPerRow;
+            panel.footer->setBounds(area.withTrimmedTop(rows * knobHeight).removeFromTop(footerHeight).reduced(4, 2));
+        }
+    }
+
+    background.repaint();
+}
+
+void AudioPluginprojectAudioProcessorEditor::chooseImpulseResponse()
+{
+    auto current = audioProcessor.getImpulseResponseFile();
+
+    impulseResponseChooser = std::make_unique<juce::FileChooser>("Load an impulse response",
+        current.existsAsFile() ? current : juce::File(), "*.wav;*.aif;*.aiff;*.flac");
+
+    impulseResponseChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+        [this](const juce::FileChooser& chooser)
+        {
+            auto file = chooser.getResult();
+
+            if (file == juce::File())
+                return;
+
+            audioProcessor.loadImpulseResponse(file);
+            updateImpulseResponseButton();
+        });
+}
+
+void AudioPluginprojectAudioProcessorEditor::updateImpulseResponseButton()
+{
+    auto file = audioProcessor.getImpulseResponseFile();
+    impulseResponseButton.setButtonText(file == juce::File() ? juce::String("Load IR...") : file.getFileNameWithoutExtension());
+    impulseResponseButton.setTooltip(file.getFullPathName());
+}
+
+void AudioPluginprojectAudioProcessorEditor::showGeneralFilterBand(int band)
+{
+    auto& knobs = stagePanels[generalFilterPanel].knobs;
+
+    // the last knob is the bypass, it's for all of them
+    for (size_t i = 0; i + 1 < knobs.size(); ++i)
+        knobs[i]->setVisible(static_cast<int>(i / 4) == band);
+
+    resized();
+}
+
+void AudioPluginprojectAudioProcessorEditor::toggleTrace()
+{
+    if (audioProcessor.isTracing())
+    {
+        audioProcessor.stopTrace();
+        audioProcessor.stopAutomationRecording();
+    }
+    else
+    {
+        // the timeline, and next to it what the session did, to replay whatever the timeline shows
+        auto file = juce::File::getSpecialLocation(juce::File::userDesktopDirectory)
+            .getNonexistentChildFile("AudioPluginTrace-" + juce::Time::getCurrentTime().formatted("%Y%m%d-%H%M%S"), ".json");
+
+        audioProcessor.startTrace(file);
+        audioProcessor.startAutomationRecording(file.withFileExtension(".automation"));
+    }
+
+    traceButton.setButtonText(audioProcessor.isTracing() ? "Stop Trace" : "Record Trace");
+}
+
+void AudioPluginprojectAudioProcessorEditor::BackgroundLayer::paint(juce::Graphics& g)
+{
+    g.fillAll(getLookAndFeel().findColour(juce::ResizableWindow::backgroundColourId));
+
+    g.setFont(juce::FontOptions(14.f, juce::Font::bold));
+
+    for (auto& [title, area] : panels)
+    {
+        g.setColour(juce::Colours::black.withAlpha(0.25f));
+        g.fillRoundedRectangle(area.toFloat(), 6.f);
+
+        g.setColour(juce::Colours::white.withAlpha(0.3f));
+        g.drawRoundedRectangle(area.toFloat(), 6.f, 1.f);
+
+        g.setColour(juce::Colours::white);
+        g.drawFittedText(title, area.withHeight(22), juce::Justification::centred, 1);
+    }
+}
+
+//==============================================================================
+ParameterKnob::ParameterKnob(juce::RangedAudioParameter& param)
+    : parameter(param),
+      isToggle(dynamic_cast<juce::AudioParameterBool*>(&param) != nullptr),
+      name(param.getName(32)),
+      label(param.getLabel()),
+      displayedValue(param.getValue())
+{
+}
+
+bool ParameterKnob::refresh()
+{
+    auto value = parameter.getValue();
+
+    if (value == displayedValue)
+        return false;
+
+    displayedValue = value;
+    repaint();
+    return true;
+}
+
+void ParameterKnob::paint(juce::Graphics& g)
+{
+    auto bounds = getLocalBounds().toFloat().reduced(2.f);
+    auto textArea = bounds.removeFromBottom(26.f);
+    // what refresh() saw this frame: painting never goes back to the parameter
+    auto value = displayedValue;
+
+    g.setColour(juce::Colours::white);
+    g.setFont(juce::FontOptions(11.f));
+    g.drawFittedText(name, textArea.toNearestInt(), juce::Justification::centred, 2);
+
+    auto size = juce::jmin(bounds.getWidth(), bounds.getHeight());
+    auto dial = bounds.withSizeKeepingCentre(size, size).reduced(2.f);
+
+    if (isToggle)
+    {
+        auto led = dial.withSizeKeepingCentre(size * 0.4f, size * 0.4f);
+        g.setColour(value >= 0.5f ? juce::Colours::orange : juce::Colours::darkgrey);
+        g.fillEllipse(led);
+        return;
+    }
+
+    constexpr auto startAngle = juce::MathConstants<float>::pi * 1.25f;
+    constexpr auto endAngle = juce::MathConstants<float>::pi * 2.75f;
+
+    juce::Path track;
+    track.addCentredArc(dial.getCentreX(), dial.getCentreY(), dial.getWidth() * 0.5f, dial.getHeight() * 0.5f,
+        0.f, startAngle, endAngle, true);
+
+    g.setColour(juce::Colours::darkgrey);
+    g.strokePath(track, juce::PathStrokeType(3.f));
+
+    juce::Path valueArc;
+    valueArc.addCentredArc(dial.getCentreX(), dial.getCentreY(), dial.getWidth() * 0.5f, dial.getHeight() * 0.5f,
+        0.f, startAngle, startAngle + (endAngle - startAngle) * value, true);
+
+    g.setColour(juce::Colours::orange);
+    g.strokePath(valueArc, juce::PathStrokeType(3.f));
+
+    g.setColour(juce::Colours::white);
+    g.setFont(juce::FontOptions(10.f));
+    g.drawFittedText(parameter.getText(value, 1024) + label, dial.toNearestInt(),
+        juce::Justification::centred, 1);
+}
+
+void ParameterKnob::mouseDown(const juce::MouseEvent&)
+{
+    if (isToggle)
+        return;
+
+    dragStartValue = parameter.getValue();
+    parameter.beginChangeGesture();
+    isDragging = true;
+}
+
+void ParameterKnob::mouseDrag(const juce::MouseEvent& e)
+{
+    if (! isDragging)
+        return;
+
+    auto pixelsForFullRange = e.mods.isShiftDown() ? 1000.f : 200.f;
+    auto delta = -static_cast<float>(e.getDistanceFromDragStartY()) / pixelsForFullRange;
+
+    parameter.setValueNotifyingHost(juce::jlimit(0.f, 1.f, dragStartValue + delta));
+}
+
+void ParameterKnob::mouseUp(const juce::MouseEvent& e)
+{
+    if (isToggle)
+    {
+        if (! e.mouseWasDraggedSinceMouseDown())
+        {
+            parameter.beginChangeGesture();
+            parameter.setValueNotifyingHost(parameter.getValue() >= 0.5f ? 0.f : 1.f);
+            parameter.endChangeGesture();
+        }
+
+        return;
+    }
+
+    if (isDragging)
+    {
+        parameter.endChangeGesture();
+        isDragging = false;
+    }
+}
+
+void ParameterKnob::mouseDoubleClick(const juce::MouseEvent&)
+{
+    if (isToggle)
+        return;
+
+    parameter.beginChangeGesture();
+    parameter.setValueNotifyingHost(parameter.getDefaultValue());
+    parameter.endChangeGesture();
+}
+
+//==============================================================================
+DspOrderView::DspOrderView(AudioPluginprojectAudioProcessor& p) : audioProcessor(p)
+{
+    order = AudioPluginprojectAudioProcessor::getDefaultDspOrder();
+
+    // start from the order that was last saved / restored, if there is one
+    if (audioProcessor.apvts.state.hasProperty("dspOrder"))
+        order = AudioPluginprojectAudioProcessor::dspOrderFromVar(audioProcessor.apvts.state.getProperty("dspOrder"));
+}
+
+juce::String DspOrderView::getOptionName(DSP_Option option)
+{
+    switch (option)
+    {
+    case DSP_Option::Phase:         return "Phaser";
+    case DSP_Option::Chorus:        return "Chorus";
+    case DSP_Option::OverDrive:     return "Overdrive";
+    case DSP_Option::LadderFilter:  return "Ladder Filter";
+    case DSP_Option::GenralFilter:  return "General Filter";
+    case DSP_Option::Delay:         return "Delay";
+    case DSP_Option::Convolution:   return "Convolution";
+    case DSP_Option::Reverb:        return "Reverb";
+    case DSP_Option::End_Of_List:   break;
+    }
+
+    return "-";
+}
+
+void DspOrderView::refresh()
+{
+    if (pushedOrderFrames > 0)
+        --pushedOrderFrames;
+
+    if (! audioProcessor.chainSnapshot.update())
+        return;
+
+    const auto& latest = audioProcessor.chainSnapshot.getReadBuffer();
+
+    if (latest.order == order)
+        pushedOrderFrames = 0;
+
+    auto changed = false;
+
+    auto set = [&changed](auto& displayed, auto value)
+        {
+            if (displayed != value)
+            {
+                displayed = value;
+                changed = true;
+            }
+        };
+
+    // neither under the mouse nor right after a drop, which the last block may not have seen yet
+    if (draggedSlot < 0 && pushedOrderFrames == 0)
+        set(order, latest.order);
+
+    set(bypassedSlots, latest.bypassedSlots);
+    set(slotLatency, latest.slotLatency);
+    set(latencySamples, latest.latencySamples);
+    set(governorLevel, latest.governorLevel);
+    set(loadPercent, juce::roundToInt(latest.governorLoad * 100.f));
+    set(monoPath, latest.monoPath);
+
+    if (changed)
+        repaint();
+}
+
+juce::Rectangle<int> DspOrderView::getSlotBounds(int slot) const
+{
+    auto slotWidth = (getWidth() - statusWidth) / static_cast<int>(order.size());
+    return { slot * slotWidth, 0, slotWidth, getHeight() };
+}
+
+int DspOrderView::getSlotAt(juce::Point<int> pos) const
+{
+    for (int i = 0; i < static_cast<int>(order.size()); ++i)
+        if (getSlotBounds(i).contains(pos))
+            return i;
+
+    return -1;
+}
+
+void DspOrderView::paint(juce::Graphics& g)
+{
+    g.setFont(juce::FontOptions(13.f));
+
+    for (int i = 0; i < static_cast<int>(order.size()); ++i)
+    {
+        auto area = getSlotBounds(i).reduced(3).toFloat();
+        auto slot = static_cast<size_t>(i);
+        auto passesThrough = (bypassedSlots & (1u << slot)) != 0;
+
+        g.setColour(i == draggedSlot ? juce::Colours::orange.darker()
+            : passesThrough ? juce::Colours::darkslategrey.darker() : juce::Colours::darkslategrey);
+        g.fillRoundedRectangle(area, 5.f);
+
+        if (i == hoveredSlot && hoveredSlot != draggedSlot)
+        {
+            g.setColour(juce::Colours::orange);
+            g.drawRoundedRectangle(area, 5.f, 2.f);
+        }
+
+        auto text = juce::String(i + 1) + ": " + getOptionName(order[slot]);
+
+        if (slotLatency[slot] > 0)
+            text << "\n" << slotLatency[slot] << " smp";
+
+        g.setColour(passesThrough ? juce::Colours::grey : juce::Colours::white);
+        g.drawFittedText(text, area.toNearestInt(), juce::Justification::centred, 2);
+    }
+
+    auto status = getLocalBounds().removeFromRight(statusWidth).reduced(6, 3);
+
+    g.setColour(governorLevel > 0 ? juce::Colours::orange : juce::Colours::lightgrey);
+    g.drawFittedText("Latency " + juce::String(latencySamples) + " smp" + (monoPath ? ", mono" : "")
+        + "\nCPU " + juce::String(loadPercent) + "%, level " + juce::String(governorLevel),
+        status, juce::Justification::centredLeft, 2);
+}
+
+void DspOrderView::mouseDown(const juce::MouseEvent& e)
+{
+    draggedSlot = getSlotAt(e.getPosition());
+    hoveredSlot = draggedSlot;
+    repaint();
+}
+
+void DspOrderView::mouseDrag(const juce::MouseEvent& e)
+{
+    auto slot = getSlotAt(e.getPosition());
+
+    if (slot != hoveredSlot)
+    {
+        hoveredSlot = slot;
+        repaint();
+    }
+}
+
+void DspOrderView::mouseUp(const juce::MouseEvent&)
+{
+    if (draggedSlot >= 0 && hoveredSlot >= 0 && draggedSlot != hoveredSlot)
+    {
+        // move the dragged stage to the drop slot, shifting the ones in between
+        auto first = order.begin();
+
+        if (draggedSlot < hoveredSlot)
+            std::rotate(first + draggedSlot, first + draggedSlot + 1, first + hoveredSlot + 1);
+        else
+            std::rotate(first + hoveredSlot, first + draggedSlot, first + draggedSlot + 1);
+
+        auto pushed = audioProcessor.dsporderfifo.push(order);
+        jassert(pushed);
+        juce::ignoreUnused(pushed);
+
+        pushedOrderFrames = AudioPluginprojectAudioProcessorEditor::frameRateHz;
+    }
+
+    draggedSlot = -1;
+    hoveredSlot = -1;
+    repaint();
+}
+
+//==============================================================================
+StageMeterView::StageMeterView(AudioPluginprojectAudioProcessor& p) : audioProcessor(p)
+{
+    setOpaque(true);
+}
+
+StageMeterView::DisplayLevel StageMeterView::toDisplayLevel(const StageLevels& levels)
+{
+    auto toSteps = [](float gain)
+        {
+            auto db = juce::Decibels::gainToDecibels(gain, -60.f);
+            return juce::jmax(minDisplayStep, juce::roundToInt(db * 2.f));
+        };
+
+    return { toSteps(levels.peak), toSteps(levels.rms) };
+}
+
+void StageMeterView::refresh()
+{
+    if (! audioProcessor.levelSnapshot.update())
+        return;
+
+    const auto& latest = audioProcessor.levelSnapshot.getReadBuffer();
+
+    auto changed = latest.numChannels != displayedChannels;
+    displayedChannels = latest.numChannels;
+
+    for (size_t ch = 0; ch < maxMeterChannels; ++ch)
+    {
+        for (size_t i = 0; i < numMeterPoints; ++i)
+        {
+            auto level = ch < latest.numChannels ? toDisplayLevel(latest.channels[ch][i]) : DisplayLevel{};
+
+            if (level != displayed[ch][i])
+            {
+                displayed[ch][i] = level;
+                changed = true;
+            }
+        }
+    }
+
+    if (changed)
+        repaint();
+}
+
+void StageMeterView::paint(juce::Graphics& g)
+{
+    g.fillAll(juce::Colours::black);
+
+    auto bounds = getLocalBounds().toFloat();
+    auto labelArea = bounds.removeFromBottom(14.f);
+    auto pointWidth = bounds.getWidth() / static_cast<float>(numMeterPoints);
+
+    auto toHeight = [&bounds](int steps)
+        {
+            return juce::jmap(static_cast<float>(steps), static_cast<float>(minDisplayStep), 0.f, 0.f, bounds.getHeight());
+        };
+
+    g.setFont(juce::FontOptions(11.f));
+
+    for (size_t i = 0; i < numMeterPoints; ++i)
+    {
+        auto area = bounds.withX(bounds.getX() + pointWidth * static_cast<float>(i)).withWidth(pointWidth).reduced(4.f, 0.f);
+        auto channelWidth = area.getWidth() / static_cast<float>(maxMeterChannels);
+
+        for (size_t ch = 0; ch < displayedChannels; ++ch)
+        {
+            auto bar = area.withX(area.getX() + channelWidth * static_cast<float>(ch)).withWidth(channelWidth).reduced(1.f, 0.f);
+
+            auto peakHeight = toHeight(displayed[ch][i].peak);
+            auto rmsHeight = toHeight(displayed[ch][i].rms);
+
+            g.setColour(displayed[ch][i].peak >= 0 ? juce::Colours::red : juce::Colours::green.darker());
+            g.fillRect(bar.withTop(bar.getBottom() - peakHeight));
+
+            g.setColour(juce::Colours::lightgreen);
+            g.fillRect(bar.withTop(bar.getBottom() - rmsHeight));
+        }
+
+        g.setColour(juce::Colours::white);
+        g.drawFittedText(i == 0 ? juce::String("In") : juce::String(static_cast<int>(i)),
+            labelArea.withX(area.getX()).withWidth(area.getWidth()).toNearestInt(),
+            juce::Justification::centred, 1);
+    }
+}
+
+//==============================================================================
+SpectrumView::SpectrumView(AudioPluginprojectAudioProcessor& p) : audioProcessor(p)
+{
+    setOpaque(true);
+}
+
+SpectrumView::~SpectrumView()
+{
+    audioProcessor.spectrumAnalyser.setActive(false);
+}
+
+void SpectrumView::visibilityChanged()
+{
+    updateActiveState();
+}
+
+void SpectrumView::parentHierarchyChanged()
+{
+    updateActiveState();
+}
+
+void SpectrumView::updateActiveState()
+{
+    audioProcessor.spectrumAnalyser.setActive(isShowing());
+}
+
+void SpectrumView::refresh()
+{
+    auto changed = false;
+
+    for (auto tap : { SpectrumAnalyser::Input, SpectrumAnalyser::Output })
+        changed = audioProcessor.spectrumAnalyser.getPath(tap).update() || changed;
+
+    if (changed)
+        repaint();
+}
+
+void SpectrumView::paint(juce::Graphics& g)
+{
+    g.fillAll(juce::Colours::black);
+
+    auto bounds = getLocalBounds().toFloat();
+    auto transform = juce::AffineTransform::scale(bounds.getWidth(), bounds.getHeight())
+        .translated(bounds.getX(), bounds.getY());
+
+    g.setColour(juce::Colours::grey);
+    g.strokePath(audioProcessor.spectrumAnalyser.getPath(SpectrumAnalyser::Input).getReadBuffer(),
+        juce::PathStrokeType(1.f), transform);
 
-    dspOrderButton.setBounds(getLocalBounds().reduced(100));
+    g.setColour(juce::Colours::orange);
+    g.strokePath(audioProcessor.spectrumAnalyser.getPath(SpectrumAnalyser::Output).getReadBuffer(),
+        juce::PathStrokeType(1.5f), transform);
 }
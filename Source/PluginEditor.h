@@ -11,10 +11,162 @@
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
 
+// logs message-thread time spent per editor frame (timer + repaint) via juce::PerformanceCounter
+#define MEASURE_EDITOR_FRAME_TIME false
+
+//==============================================================================
+/*
+    Shows peak / RMS after every slot of the chain.
+    refresh() picks up the processor's latest levelSnapshot and only
+    repaints when the (display-resolution) values actually changed.
+*/
+class StageMeterView : public juce::Component
+{
+public:
+    StageMeterView(AudioPluginprojectAudioProcessor&);
+
+    void paint(juce::Graphics&) override;
+    void refresh();
+
+private:
+    AudioPluginprojectAudioProcessor& audioProcessor;
+
+    static constexpr auto numMeterPoints = AudioPluginprojectAudioProcessor::numMeterPoints;
+    static constexpr auto maxMeterChannels = AudioPluginprojectAudioProcessor::maxMeterChannels;
+
+    // levels in half-dB steps, so tiny changes that wouldn't move a pixel don't cause repaints
+    struct DisplayLevel
+    {
+        int peak = minDisplayStep;
+        int rms = minDisplayStep;
+
+        bool operator==(const DisplayLevel&) const = default;
+    };
+
+    static constexpr int minDisplayStep = -120; // -60 dB
+    static DisplayLevel toDisplayLevel(const StageLevels&);
+
+    std::array<std::array<DisplayLevel, numMeterPoints>, maxMeterChannels> displayed;
+    size_t displayedChannels = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StageMeterView)
+};
+
+//==============================================================================
+/*
+    Draws the processor's input / output spectrum.
+    The analyser runs on its own thread; refresh() only swaps in the newest
+    path, and the analyser is switched off while this isn't showing.
+*/
+class SpectrumView : public juce::Component
+{
+public:
+    SpectrumView(AudioPluginprojectAudioProcessor&);
+    ~SpectrumView() override;
+
+    void paint(juce::Graphics&) override;
+    void visibilityChanged() override;
+    void parentHierarchyChanged() override;
+    void refresh();
+
+private:
+    void updateActiveState();
+
+    AudioPluginprojectAudioProcessor& audioProcessor;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrumView)
+};
+
+//==============================================================================
+/*
+    Lightweight rotary / toggle control bound straight to a parameter.
+    Unlike a Slider + attachment it never repaints from a parameter callback:
+    the editor calls refresh() once per frame and it only repaints if the
+    value moved since the last frame.
+*/
+class ParameterKnob : public juce::Component
+{
+public:
+    ParameterKnob(juce::RangedAudioParameter& param);
+
+    void paint(juce::Graphics&) override;
+    bool refresh();
+
+    void mouseDown(const juce::MouseEvent&) override;
+    void mouseDrag(const juce::MouseEvent&) override;
+    void mouseUp(const juce::MouseEvent&) override;
+    void mouseDoubleClick(const juce::MouseEvent&) override;
+
+private:
+    juce::RangedAudioParameter& parameter;
+    const bool isToggle;
+    const juce::String name, label;
+
+    float displayedValue;
+    float dragStartValue = 0.f;
+    bool isDragging = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ParameterKnob)
+};
+
+//==============================================================================
+/*
+    One tile per DSP_Order slot. Dragging a tile onto another slot moves it
+    there and pushes the new order to the processor's dsporderfifo.
+    refresh() picks up the processor's latest chainSnapshot, so the tiles
+    show the order the audio thread is running, which slots it passes
+    through untouched and what each adds in latency, with the total latency
+    and the CPU governor's state next to them.
+*/
+class DspOrderView : public juce::Component
+{
+public:
+    using DSP_Option = AudioPluginprojectAudioProcessor::DSP_Option;
+    using DSP_Order = AudioPluginprojectAudioProcessor::DSP_Order;
+
+    DspOrderView(AudioPluginprojectAudioProcessor&);
+
+    void paint(juce::Graphics&) override;
+
+    void mouseDown(const juce::MouseEvent&) override;
+    void mouseDrag(const juce::MouseEvent&) override;
+    void mouseUp(const juce::MouseEvent&) override;
+
+    static juce::String getOptionName(DSP_Option);
+
+    void refresh();
+
+private:
+    int getSlotAt(juce::Point<int>) const;
+    juce::Rectangle<int> getSlotBounds(int slot) const;
+
+    static constexpr int statusWidth = 150;
+
+    AudioPluginprojectAudioProcessor& audioProcessor;
+    DSP_Order order;
+
+    // from the last chainSnapshot, the load in whole percent so it doesn't repaint for nothing
+    juce::uint32 bypassedSlots = 0;
+    std::array<int, std::tuple_size_v<DSP_Order>> slotLatency{};
+    int latencySamples = 0;
+    int governorLevel = 0;
+    int loadPercent = 0;
+    bool monoPath = false;
+
+    // frames left to wait for a dropped order to reach the audio thread before the snapshot's wins again
+    int pushedOrderFrames = 0;
+
+    int draggedSlot = -1;
+    int hoveredSlot = -1;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DspOrderView)
+};
+
 //==============================================================================
 /**
 */
-class AudioPluginprojectAudioProcessorEditor  : public juce::AudioProcessorEditor
+class AudioPluginprojectAudioProcessorEditor  : public juce::AudioProcessorEditor,
+                                                private juce::Timer
 {
 public:
     AudioPluginprojectAudioProcessorEditor (AudioPluginprojectAudioProcessor&);
@@ -22,14 +174,61 @@ public:
 
     //==============================================================================
     void paint (juce::Graphics&) override;
+    void paintOverChildren (juce::Graphics&) override;
     void resized() override;
 
+    static constexpr int frameRateHz = 30;
+
 private:
+    void timerCallback() override;
+
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     AudioPluginprojectAudioProcessor& audioProcessor;
 
-    juce::TextButton dspOrderButton { "dsp order" };
+    // static panel frames and titles, rendered once per resize and then blitted
+    struct BackgroundLayer : juce::Component
+    {
+        void paint(juce::Graphics&) override;
+
+        std::vector<std::pair<juce::String, juce::Rectangle<int>>> panels;
+    };
+
+    struct StagePanel
+    {
+        juce::String title;
+        std::vector<std::unique_ptr<ParameterKnob>> knobs;
+
+        // laid out in a row under the knobs
+        juce::Component* footer = nullptr;
+    };
+
+    juce::ComboBox generalFilterBandSelector;
+    size_t generalFilterPanel = 0;
+
+    void showGeneralFilterBand(int band);
+
+    juce::TextButton impulseResponseButton;
+    std::unique_ptr<juce::FileChooser> impulseResponseChooser;
+
+    void chooseImpulseResponse();
+    void updateImpulseResponseButton();
+
+    // starts / stops a trace file and an automation recording on the desktop, see AudioTracer and AutomationRecorder
+    juce::TextButton traceButton;
+
+    void toggleTrace();
+
+    BackgroundLayer background;
+    DspOrderView dspOrderView { audioProcessor };
+    std::vector<StagePanel> stagePanels;
+    StageMeterView stageMeters { audioProcessor };
+    SpectrumView spectrum { audioProcessor };
+
+   #if MEASURE_EDITOR_FRAME_TIME
+    juce::PerformanceCounter frameTimerCounter { "editor frame timer", 100 };
+    juce::PerformanceCounter framePaintCounter { "editor frame paint", 100 };
+   #endif
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioPluginprojectAudioProcessorEditor)
 };
@@ -16,6 +16,21 @@ auto getPhaserFeedbackName() { return juce::String("Phaser Feedback %"); }
 auto getPhaserDepthName() { return juce::String("Phaser Depth %"); }
 auto getPhaserMixName() { return juce::String("Phaser Mix %"); }
 auto getPhaserBypassName() { return juce::String("Phaser Bypass"); }
+auto getPhaserStagesName() { return juce::String("Phaser Stages"); }
+auto getPhaserStereoPhaseName() { return juce::String("Phaser Stereo Phase"); }
+auto getPhaserTempoSyncName() { return juce::String("Phaser Tempo Sync"); }
+auto getPhaserSyncDivisionName() { return juce::String("Phaser Sync Division"); }
+
+auto getPhaserStagesChoices()
+{
+    return juce::StringArray
+    {
+        "4",
+        "6",
+        "8",
+        "12"
+    };
+}
 
 
 // chorus : Parameter Name Funcs
@@ -25,6 +40,9 @@ auto getChorusFeedbackName() { return juce::String("Chorus Feedback %"); }
 auto getChorusDepthName() { return juce::String("Chorus Depth %"); }
 auto getChorusMixName() { return juce::String("Chorus Mix %"); }
 auto getChorusBypassName() { return juce::String("Chorus Bypass"); }
+auto getChorusStereoPhaseName() { return juce::String("Chorus Stereo Phase"); }
+auto getChorusTempoSyncName() { return juce::String("Chorus Tempo Sync"); }
+auto getChorusSyncDivisionName() { return juce::String("Chorus Sync Division"); }
 
 auto getOverdriveSaturationName() { return juce::String("Overdrive Saturation"); }
 auto getOverdriveBypassName() { return juce::String("Overdrive Bypass"); }
@@ -67,6 +85,58 @@ auto getGeneralFilterQualityName() { return juce::String("General Filter Quality
 auto getGeneralFilterGainName() { return juce::String("General Filter Gain"); }
 auto getGeneralFilterBypassName() { return juce::String("General Filter Bypass"); }
 
+// band 1 keeps the names, and so the ids, it had before there were more bands
+auto getGeneralFilterBandModeName(size_t band) { return band == 0 ? getGeneralFilterModeName() : "General Filter " + juce::String(band + 1) + " Mode"; }
+auto getGeneralFilterBandFreqName(size_t band) { return band == 0 ? getGeneralFilterFreqName() : "General Filter " + juce::String(band + 1) + " FreqHz"; }
+auto getGeneralFilterBandQualityName(size_t band) { return band == 0 ? getGeneralFilterQualityName() : "General Filter " + juce::String(band + 1) + " Quality"; }
+auto getGeneralFilterBandGainName(size_t band) { return band == 0 ? getGeneralFilterGainName() : "General Filter " + juce::String(band + 1) + " Gain"; }
+
+auto getDelayTimeName() { return juce::String("Delay Time Ms"); }
+auto getDelayFeedbackName() { return juce::String("Delay Feedback %"); }
+auto getDelayMixName() { return juce::String("Delay Mix %"); }
+auto getDelayTempoSyncName() { return juce::String("Delay Tempo Sync"); }
+auto getDelaySyncDivisionName() { return juce::String("Delay Sync Division"); }
+auto getDelayPingPongName() { return juce::String("Delay Ping Pong"); }
+auto getDelayLowCutName() { return juce::String("Delay Low Cut Hz"); }
+auto getDelayHighCutName() { return juce::String("Delay High Cut Hz"); }
+auto getDelayBypassName() { return juce::String("Delay Bypass"); }
+
+auto getConvolutionMixName() { return juce::String("Convolution Mix %"); }
+auto getConvolutionBypassName() { return juce::String("Convolution Bypass"); }
+
+auto getReverbSizeName() { return juce::String("Reverb Size"); }
+auto getReverbDecayName() { return juce::String("Reverb Decay s"); }
+auto getReverbDampingName() { return juce::String("Reverb Damping Hz"); }
+auto getReverbMixName() { return juce::String("Reverb Mix %"); }
+auto getReverbBypassName() { return juce::String("Reverb Bypass"); }
+
+auto getLimiterCeilingName() { return juce::String("Limiter Ceiling dB"); }
+auto getLimiterLookaheadName() { return juce::String("Limiter Lookahead Ms"); }
+auto getLimiterReleaseName() { return juce::String("Limiter Release Ms"); }
+auto getLimiterBypassName() { return juce::String("Limiter Bypass"); }
+
+auto getQualityModeName() { return juce::String("Quality"); }
+auto getOfflineHighQualityName() { return juce::String("Offline High Quality"); }
+auto getDualMonoFastPathName() { return juce::String("Dual Mono Fast Path"); }
+auto getFreeUnusedStagesName() { return juce::String("Free Unused Stages"); }
+
+auto getFreeUnusedStagesChoices()
+{
+    return juce::StringArray
+    {
+        "Never",
+        "10 s",
+        "30 s",
+        "60 s"
+    };
+}
+
+auto getFreeUnusedStagesSeconds(int choiceIndex)
+{
+    constexpr std::array<double, 4> seconds{ 0.0, 10.0, 30.0, 60.0 };
+    return seconds[static_cast<size_t>(juce::jlimit(0, static_cast<int>(seconds.size()) - 1, choiceIndex))];
+}
+
 
 
 //==============================================================================
@@ -83,13 +153,9 @@ AudioPluginprojectAudioProcessor::AudioPluginprojectAudioProcessor()
 #endif
 {
 
-    dspOrder =
-    { {
-        DSP_Option::Phase,
-        DSP_Option::Chorus,
-        DSP_Option::OverDrive,
-        DSP_Option::LadderFilter
-    } };
+    dspOrder = getDefaultDspOrder();
+    stagesInOrder = getStageMask(dspOrder);
+    orderInUse = packDspOrder(dspOrder);
 
     auto floatParams = std::array
     {
@@ -98,12 +164,14 @@ AudioPluginprojectAudioProcessor::AudioPluginprojectAudioProcessor()
         &phaserDepthPercent,
         &phaserFeedbackPercent,
         &phaserMixPercent,
+        &phaserStereoPhase,
 
         &chorusRateHz,
         &chorusCenterDelayMs,
         &chorusFeedbackPercent,
         &chorusDepthPercent ,
         &chorusMixPercent,
+        &chorusStereoPhase,
 
         &overdriveSaturation,
 
@@ -113,7 +181,24 @@ AudioPluginprojectAudioProcessor::AudioPluginprojectAudioProcessor()
 
         &GeneralFilterFreqHz,
         &GeneralFilterQuality,
-        &GeneralFilterGain
+        &GeneralFilterGain,
+
+        &delayTimeMs,
+        &delayFeedbackPercent,
+        &delayMixPercent,
+        &delayLowCutHz,
+        &delayHighCutHz,
+
+        &convolutionMix,
+
+        &reverbSize,
+        &reverbDecaySeconds,
+        &reverbDampingHz,
+        &reverbMixPercent,
+
+        &limiterCeilingDb,
+        &limiterLookaheadMs,
+        &limiterReleaseMs
     };   
 
     auto floatNameFuncs = std::array
@@ -124,12 +209,14 @@ AudioPluginprojectAudioProcessor::AudioPluginprojectAudioProcessor()
         &getPhaserDepthName,
         &getPhaserFeedbackName,
         &getPhaserMixName,
+        &getPhaserStereoPhaseName,
 
         &getChorusRateName,
         &getChorusCenterDelayName,
         &getChorusFeedbackName,
         &getChorusDepthName,
         &getChorusMixName,
+        &getChorusStereoPhaseName,
 
         &getOverdriveSaturationName,
 
@@ -139,7 +226,24 @@ AudioPluginprojectAudioProcessor::AudioPluginprojectAudioProcessor()
 
         &getGeneralFilterFreqName,
         &getGeneralFilterQualityName,
-        &getGeneralFilterGainName
+        &getGeneralFilterGainName,
+
+        &getDelayTimeName,
+        &getDelayFeedbackName,
+        &getDelayMixName,
+        &getDelayLowCutName,
+        &getDelayHighCutName,
+
+        &getConvolutionMixName,
+
+        &getReverbSizeName,
+        &getReverbDecayName,
+        &getReverbDampingName,
+        &getReverbMixName,
+
+        &getLimiterCeilingName,
+        &getLimiterLookaheadName,
+        &getLimiterReleaseName
     };
 
 
@@ -147,14 +251,26 @@ AudioPluginprojectAudioProcessor::AudioPluginprojectAudioProcessor()
 
     auto choiceParams = std::array
     {
+        &phaserStages,
+        &phaserSyncDivision,
+        &chorusSyncDivision,
         &LadderFilterMode,
-        &GeneralFilterMode
+        &GeneralFilterMode,
+        &delaySyncDivision,
+        &qualityMode,
+        &freeUnusedStages
     };
 
     auto choiceNameFuncs = std::array
     {
+        &getPhaserStagesName,
+        &getPhaserSyncDivisionName,
+        &getChorusSyncDivisionName,
         &getLadderfilterModeName,
-        &getGeneralFilterModeName
+        &getGeneralFilterModeName,
+        &getDelaySyncDivisionName,
+        &getQualityModeName,
+        &getFreeUnusedStagesName
     };
 
    
@@ -167,8 +283,11 @@ AudioPluginprojectAudioProcessor::AudioPluginprojectAudioProcessor()
         &chorusBypass,
         &overdriveBypass,
         &LadderFilterBypass,
-        &GeneralFilterBypass
-
+        &GeneralFilterBypass,
+        &delayBypass,
+        &convolutionBypass,
+        &reverbBypass,
+        &limiterBypass
     };
 
     auto BypassNameFuncs = std::array
@@ -177,15 +296,104 @@ AudioPluginprojectAudioProcessor::AudioPluginprojectAudioProcessor()
         &getChorusBypassName,
         &getOverdriveBypassName,
         &getLadderfilterBypassName,
-        &getGeneralFilterBypassName
+        &getGeneralFilterBypassName,
+        &getDelayBypassName,
+        &getConvolutionBypassName,
+        &getReverbBypassName,
+        &getLimiterBypassName
     };
 
 
     initialCachedPrarms<juce::AudioParameterBool*>(BypassParams, BypassNameFuncs);
+
+    auto syncParams = std::array
+    {
+        &phaserTempoSync,
+        &chorusTempoSync,
+        &delayTempoSync,
+        &delayPingPong,
+        &dualMonoFastPath
+    };
+
+    auto syncNameFuncs = std::array
+    {
+        &getPhaserTempoSyncName,
+        &getChorusTempoSyncName,
+        &getDelayTempoSyncName,
+        &getDelayPingPongName,
+        &getDualMonoFastPathName
+    };
+
+    initialCachedPrarms<juce::AudioParameterBool*>(syncParams, syncNameFuncs);
+
+    for (size_t band = 0; band < numGeneralFilterBands; ++band)
+    {
+        generalFilterBandMode[band] = dynamic_cast<juce::AudioParameterChoice*>(apvts.getParameter(getGeneralFilterBandModeName(band)));
+        generalFilterBandFreqHz[band] = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter(getGeneralFilterBandFreqName(band)));
+        generalFilterBandQuality[band] = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter(getGeneralFilterBandQualityName(band)));
+        generalFilterBandGain[band] = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter(getGeneralFilterBandGainName(band)));
+
+        jassert(generalFilterBandMode[band] != nullptr && generalFilterBandFreqHz[band] != nullptr
+            && generalFilterBandQuality[band] != nullptr && generalFilterBandGain[band] != nullptr);
+    }
+
+    offlineHighQuality = dynamic_cast<juce::AudioParameterBool*>(apvts.getParameter(getOfflineHighQualityName()));
+    jassert(offlineHighQuality != nullptr);
+
+    // starts half a cycle in so the sweep matches the old juce::dsp::Phaser
+    modulationBus.getSettings(ModulationBus::PhaserLfo).initialPhase = 0.5;
+
+    phaser.setModulation(&modulationBus, ModulationBus::PhaserLfo);
+    chorus.setModulation(&modulationBus, ModulationBus::ChorusLfo);
+
+    // the parameter ranges don't change, so the line sizes are set once, before the loader
+    // thread can get to these stages; setting them in prepareToPlay would race with it
+    chorus.setMaximumDelay(chorusCenterDelayMs->range.end, chorusDepthPercent->range.end);
+    delay.setMaximumDelay(delayTimeMs->range.end);
+
+    stageLoader.add(static_cast<size_t>(DSP_Option::Phase), phaser);
+    stageLoader.add(static_cast<size_t>(DSP_Option::Chorus), chorus, [this] { chorus.releaseResources(); });
+    stageLoader.add(static_cast<size_t>(DSP_Option::OverDrive), overdrive, [this] { overdrive.releaseResources(); });
+    stageLoader.add(static_cast<size_t>(DSP_Option::LadderFilter), ladderfilter, [this] { ladderfilter.releaseResources(); });
+    stageLoader.add(static_cast<size_t>(DSP_Option::GenralFilter), generalFilter);
+    stageLoader.add(static_cast<size_t>(DSP_Option::Delay), delay, [this] { delay.releaseResources(); });
+    stageLoader.add(static_cast<size_t>(DSP_Option::Convolution), convolution, [this] { convolution.releaseResources(); });
+    stageLoader.add(static_cast<size_t>(DSP_Option::Reverb), reverb, [this] { reverb.releaseResources(); });
+
+    traceNames.block = tracer.addName("processBlock");
+    traceNames.orderFifo = tracer.addName("DSP order FIFO");
+    traceNames.orderSwap = tracer.addName("DSP order swap");
+    traceNames.stageLoading = tracer.addName("Stage loading");
+    traceNames.parameters = tracer.addName("Parameters");
+    traceNames.limiter = tracer.addName("Limiter");
+
+    for (size_t i = 0; i < traceNames.stages.size(); ++i)
+        traceNames.stages[i] = tracer.addName(DspOrderView::getOptionName(static_cast<DSP_Option>(i)));
+
+    automationRecorder.setParameters(getParameters());
+
+    constructionMs = juce::Time::getMillisecondCounterHiRes() - constructionStartMs;
 }
 
 AudioPluginprojectAudioProcessor::~AudioPluginprojectAudioProcessor()
 {
+    cancelPendingUpdate();
+}
+
+AudioPluginprojectAudioProcessor::DSP_Order AudioPluginprojectAudioProcessor::getDefaultDspOrder()
+{
+    DSP_Order order;
+    order.fill(DSP_Option::End_Of_List);
+
+    order[0] = DSP_Option::Phase;
+    order[1] = DSP_Option::Chorus;
+    order[2] = DSP_Option::OverDrive;
+    order[3] = DSP_Option::LadderFilter;
+    order[4] = DSP_Option::Convolution;
+    order[5] = DSP_Option::Delay;
+    order[6] = DSP_Option::Reverb;
+
+    return order;
 }
 
 //==============================================================================
@@ -223,7 +431,39 @@ bool AudioPluginprojectAudioProcessor::isMidiEffect() const
 
 double AudioPluginprojectAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    auto inOrder = stagesInOrder.load(std::memory_order_relaxed);
+
+    auto isRinging = [&](DSP_Option option)
+        {
+            return (inOrder & (1u << static_cast<int>(option))) != 0 && ! isBypassed(option);
+        };
+
+    double tail = 0.0;
+
+    // until the delay's repeats have dropped by 60dB
+    if (isRinging(DSP_Option::Delay))
+    {
+        auto feedback = juce::jlimit(0.01f, 0.95f, delayFeedbackPercent->get());
+        auto repeats = std::ceil(std::log(0.001f) / std::log(feedback));
+
+        // the parameter's time until a block has run the stage
+        auto delayMs = delayTimeInUseMs.load(std::memory_order_relaxed);
+
+        if (delayMs <= 0.f)
+            delayMs = delayTimeMs->get();
+
+        tail += delayMs / 1000.0 * juce::jmax(1.f, repeats);
+    }
+
+    // plus the impulse response, once one has been read
+    if (isRinging(DSP_Option::Convolution) && hasImpulseResponse.load(std::memory_order_relaxed))
+        tail += convolution.getImpulseResponseLengthSeconds();
+
+    // and the reverb's RT60
+    if (isRinging(DSP_Option::Reverb))
+        tail += reverbDecaySeconds->get();
+
+    return tail;
 }
 
 int AudioPluginprojectAudioProcessor::getNumPrograms()
@@ -256,34 +496,80 @@ void AudioPluginprojectAudioProcessor::prepareToPlay (double sampleRate, int sam
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
 
+    auto startMs = juce::Time::getMillisecondCounterHiRes();
+
+    // processBlock never hands the stages more than one sub-block, and never less than that is
+    // planned for: a host announcing small blocks may still send bigger ones later
+    juce::ignoreUnused(samplesPerBlock);
+
     juce::dsp::ProcessSpec spec;
     spec.sampleRate = sampleRate;
-    spec.maximumBlockSize = samplesPerBlock;
+    spec.maximumBlockSize = static_cast<juce::uint32>(subBlockSize);
     spec.numChannels =1;
 
-    leftChannel.prepare(spec);
-    rightChannel.prepare(spec);
+    auto stereoSpec = spec;
+    stereoSpec.numChannels = static_cast<juce::uint32>(juce::jlimit(1, 2, getTotalNumOutputChannels()));
 
-   
-}
+    modulationBus.prepare(sampleRate, static_cast<int>(spec.maximumBlockSize));
+    sharedTables.request(sampleRate);
 
-void AudioPluginprojectAudioProcessor::MonoChannelDSP::prepare(const juce::dsp::ProcessSpec& spec)
-{
-    jassert(spec.numChannels == 1);
-    std::vector<juce::dsp::ProcessorBase*>dsp
+    // the pipeline's threads and buses only exist while prepared for an offline render
+    if (isNonRealtime())
     {
-        &pharser,
-        &choruser,
-        &overdrive,
-        &ladderfilter,
-        &genralfilter
-    };
+        pipeline.prepare();
+        pipelineModulation.resize(maxPipelinedSubBlocks);
 
-    for (auto p : dsp)
+        for (auto& bus : pipelineModulation)
+            bus.prepare(sampleRate, static_cast<int>(spec.maximumBlockSize));
+    }
+    else
     {
-        p->prepare(spec);
-        p->reset();
+        pipeline.release();
+        std::vector<ModulationBus>().swap(pipelineModulation);
     }
+
+    // only what the chain uses now, with an order restored by setStateInformation;
+    // the rest is prepared in the background if and when it's switched in
+    pullDspOrder();
+    requestedQuality = QualitySettings::forMode(getEffectiveQualityMode());
+
+    stageLoader.prepare(stereoSpec, [this](size_t id) { return isStageWanted(static_cast<DSP_Option>(id)); });
+
+    limiter.setCeiling(limiterCeilingDb->get());
+    limiter.setLookahead(limiterLookaheadMs->get());
+    limiter.setRelease(limiterReleaseMs->get());
+    limiter.prepare(stereoSpec);
+
+    governor.prepare(sampleRate);
+    governor.setEnabled(! isNonRealtime());
+
+    convolution.setSynchronousLoading(isNonRealtime() || replaying);
+
+    applyQuality(requestedQuality);
+    updateLatency();
+
+    // on the message thread already, and the host reads it as soon as this returns
+    cancelPendingUpdate();
+    handleAsyncUpdate();
+
+    spectrumAnalyser.prepare(sampleRate);
+
+    // reported through getLoadTimes()
+    prepareToPlayMs = juce::Time::getMillisecondCounterHiRes() - startMs;
+}
+
+void AudioPluginprojectAudioProcessor::reset()
+{
+    // LFO phases, delay lines, filter states and parameter glides all start over;
+    // the governor too, it's off offline but would otherwise carry a level across renders
+    modulationBus.reset();
+    stageLoader.reset();
+    limiter.reset();
+
+    governor.reset();
+
+    monoPathActive = false;
+    secondsDualMono = 0.0;
 }
 
 void AudioPluginprojectAudioProcessor::releaseResources()
@@ -392,6 +678,32 @@ juce::AudioProcessorValueTreeState::ParameterLayout AudioPluginprojectAudioProce
     layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{ name,VirsionHint },
         name, false));
 
+    // phaser stages: 4, 6, 8 or 12 (6 matches the old juce::dsp::Phaser)
+
+    name = getPhaserStagesName();
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID{ name,VirsionHint }, name, getPhaserStagesChoices(), 1));
+
+    // phaser stereo phase 0 -> 180 degrees
+
+    name = getPhaserStereoPhaseName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ name,VirsionHint }
+        , name
+        , juce::NormalisableRange<float>(0.f, 180.f, 1.f, 1.f)
+        , 0.f
+        , "deg"));
+
+    // phaser tempo sync + division
+
+    name = getPhaserTempoSyncName();
+    layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{ name,VirsionHint },
+        name, false));
+
+    name = getPhaserSyncDivisionName();
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID{ name,VirsionHint }, name, ModulationBus::getSyncDivisionChoices(), 2));
+
 
     /*
     Chours:
@@ -462,6 +774,26 @@ juce::AudioProcessorValueTreeState::ParameterLayout AudioPluginprojectAudioProce
     layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{ name,VirsionHint },
         name, false));
 
+    // chorus stereo phase 0 -> 180 degrees
+
+    name = getChorusStereoPhaseName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ name,VirsionHint }
+        , name
+        , juce::NormalisableRange<float>(0.f, 180.f, 1.f, 1.f)
+        , 0.f
+        , "deg"));
+
+    // chorus tempo sync + division
+
+    name = getChorusTempoSyncName();
+    layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{ name,VirsionHint },
+        name, false));
+
+    name = getChorusSyncDivisionName();
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID{ name,VirsionHint }, name, ModulationBus::getSyncDivisionChoices(), 4));
+
 
     /*
         overdrive:
@@ -583,190 +915,1121 @@ juce::AudioProcessorValueTreeState::ParameterLayout AudioPluginprojectAudioProce
         , 0.f
         , "db"));
 
+    // bands 2 to 8 have band 1's ranges, their frequencies spread out and 0 dB, so they're off until used
+    constexpr std::array<float, numGeneralFilterBands> generalFilterBandFreqs{ 750.f, 60.f, 120.f, 250.f, 500.f, 1000.f, 1500.f, 2000.f };
+
+    for (size_t band = 1; band < numGeneralFilterBands; ++band)
+    {
+        name = getGeneralFilterBandModeName(band);
+        layout.add(std::make_unique<juce::AudioParameterChoice>(
+            juce::ParameterID{ name,VirsionHint }, name, getGenralFiltersChoices(), 0));
+
+        name = getGeneralFilterBandFreqName(band);
+        layout.add(std::make_unique<juce::AudioParameterFloat>(
+            juce::ParameterID{ name,VirsionHint }
+            , name
+            , juce::NormalisableRange<float>(20.f, 2000.f, 1.f, 1.f)
+            , generalFilterBandFreqs[band]
+            , "Hz"));
+
+        name = getGeneralFilterBandQualityName(band);
+        layout.add(std::make_unique<juce::AudioParameterFloat>(
+            juce::ParameterID{ name,VirsionHint }
+            , name
+            , juce::NormalisableRange<float>(0.1f, 10.f, 0.05f, 1.f)
+            , 1.f
+            , ""));
+
+        name = getGeneralFilterBandGainName(band);
+        layout.add(std::make_unique<juce::AudioParameterFloat>(
+            juce::ParameterID{ name,VirsionHint }
+            , name
+            , juce::NormalisableRange<float>(-24.f, 24.f, 0.5f, 1.f)
+            , 0.f
+            , "db"));
+    }
+
     // general filter Bypass
 
     name = getGeneralFilterBypassName();
     layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{ name,VirsionHint },
         name, false));
 
-    return layout;
- }
+    /*
+        Delay:
+            Time : ms (1 to 2000)
+            Feedback : 0 to 0.95
+            Mix : 0 to 1
+            Tempo Sync + Sync Division, Ping Pong
+            Low Cut / High Cut : feedback path filters, Hz
+    */
 
- void AudioPluginprojectAudioProcessor::MonoChannelDSP::updateDSPFromParams()
- {
-     pharser.dsp.setRate(p.phaserRateHz->get());
-     pharser.dsp.setCentreFrequency(p.phaserCenterFreqHz->get());
-     pharser.dsp.setDepth(p.phaserDepthPercent->get());
-     pharser.dsp.setFeedback(p.phaserFeedbackPercent->get());
-     pharser.dsp.setMix(p.phaserMixPercent->get());
+    name = getDelayTimeName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ name,VirsionHint }
+        , name
+        , juce::NormalisableRange<float>(1.f, 2000.f, 0.1f, 0.4f)
+        , 350.f
+        , "ms"));
 
-     choruser.dsp.setRate(p.chorusRateHz->get());
-     choruser.dsp.setDepth(p.chorusDepthPercent->get());
-     choruser.dsp.setCentreDelay(p.chorusCenterDelayMs->get());
-     choruser.dsp.setFeedback(p.chorusFeedbackPercent->get());
-     choruser.dsp.setMix(p.chorusMixPercent->get());
+    name = getDelayFeedbackName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ name,VirsionHint }
+        , name
+        , juce::NormalisableRange<float>(0.f, 0.95f, 0.01f, 1.f)
+        , 0.35f
+        , "%"));
 
-     overdrive.dsp.setDrive(p.overdriveSaturation->get());
+    name = getDelayMixName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ name,VirsionHint }
+        , name
+        , juce::NormalisableRange<float>(0.f, 1.f, 0.01f, 1.f)
+        , 0.3f
+        , "%"));
 
+    name = getDelayTempoSyncName();
+    layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{ name,VirsionHint },
+        name, false));
 
-     ladderfilter.dsp.setMode(static_cast<juce::dsp::LadderFilterMode>(p.LadderFilterMode->getIndex()));
-     ladderfilter.dsp.setCutoffFrequencyHz(p.LadderFilterCutoffHz->get());
-     ladderfilter.dsp.setResonance(p.LadderFilterResonence->get());
-     ladderfilter.dsp.setDrive(p.LadderFilterDrive->get());
- }
+    name = getDelaySyncDivisionName();
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID{ name,VirsionHint }, name, DelayEngine::getSyncDivisionChoices(), 6));
 
-void AudioPluginprojectAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
-{
-    juce::ScopedNoDenormals noDenormals;
-    auto totalNumInputChannels  = getTotalNumInputChannels();
-    auto totalNumOutputChannels = getTotalNumOutputChannels();
+    name = getDelayPingPongName();
+    layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{ name,VirsionHint },
+        name, false));
 
-    // In case we have more outputs than inputs, this code clears any output
-    // channels that didn't contain input data, (because these aren't
-    // guaranteed to be empty - they may contain garbage).
-    // This is here to avoid people getting screaming feedback
-    // when they first compile a plugin, but obviously you don't need to keep
-    // this code if your algorithm always overwrites all the output channels.
-    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
-        buffer.clear (i, 0, buffer.getNumSamples());
+    name = getDelayLowCutName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ name,VirsionHint }
+        , name
+        , juce::NormalisableRange<float>(20.f, 2000.f, 1.f, 0.3f)
+        , 80.f
+        , "Hz"));
 
+    name = getDelayHighCutName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ name,VirsionHint }
+        , name
+        , juce::NormalisableRange<float>(1000.f, 20000.f, 1.f, 0.3f)
+        , 8000.f
+        , "Hz"));
 
-    
-    
-    leftChannel.updateDSPFromParams();
-    rightChannel.updateDSPFromParams();
+    name = getDelayBypassName();
+    layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{ name,VirsionHint },
+        name, false));
 
-    auto newDSPOrder =  DSP_Order();
+    /*
+        Convolution:
+            Mix : 0 to 1
+    */
 
+    name = getConvolutionMixName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ name,VirsionHint }
+        , name
+        , juce::NormalisableRange<float>(0.f, 1.f, 0.01f, 1.f)
+        , 1.f
+        , "%"));
 
-    while (dsporderfifo.pull(newDSPOrder))
-    {
-#if VERIFY_BYPASS_FUNCTIONALITY
-        jassertfalse;
+    name = getConvolutionBypassName();
+    layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{ name,VirsionHint },
+        name, false));
 
-#endif
-    }
+    /*
+        Reverb:
+            Size : 0 to 1
+            Decay : s
+            Damping : Hz
+            Mix : 0 to 1
+    */
 
-    if (newDSPOrder != DSP_Order())
-    {
-        dspOrder = newDSPOrder;
-    }
+    name = getReverbSizeName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ name,VirsionHint }
+        , name
+        , juce::NormalisableRange<float>(0.f, 1.f, 0.01f, 1.f)
+        , 0.5f
+        , ""));
 
-    auto block = juce::dsp::AudioBlock<float>(buffer);
-    leftChannel.process(block.getSingleChannelBlock(0), dspOrder);
-    rightChannel.process(block.getSingleChannelBlock(1), dspOrder);
-  
+    name = getReverbDecayName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ name,VirsionHint }
+        , name
+        , juce::NormalisableRange<float>(0.2f, static_cast<float>(ReverbEngine::maxDecaySeconds), 0.01f, 0.4f)
+        , 2.f
+        , "s"));
 
-}
+    name = getReverbDampingName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ name,VirsionHint }
+        , name
+        , juce::NormalisableRange<float>(1000.f, 20000.f, 1.f, 0.3f)
+        , 6000.f
+        , "Hz"));
 
-void AudioPluginprojectAudioProcessor::MonoChannelDSP::process(juce::dsp::AudioBlock<float> block,
-    const DSP_Order& dsp_order)
-{
-    DSP_Pointers DspPointers;
-    DspPointers.fill({}); //this was previously that DspPointers.fill(nullptr);
+    name = getReverbMixName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ name,VirsionHint }
+        , name
+        , juce::NormalisableRange<float>(0.f, 1.f, 0.01f, 1.f)
+        , 0.25f
+        , "%"));
 
-    for (size_t i = 0; i < DspPointers.size(); ++i)
-    {
-        switch (p.dspOrder[i])
-        {
-        case DSP_Option::Phase:
-            DspPointers[i].processor = &pharser;
-            DspPointers[i].bypass = p.phaserBypass->get();
-            break;
-        case DSP_Option::Chorus:
-            DspPointers[i].processor = &choruser;
-            DspPointers[i].bypass = p.chorusBypass->get();
-            break;
-        case DSP_Option::OverDrive:
-            DspPointers[i].processor = &overdrive;
-            DspPointers[i].bypass = p.overdriveBypass->get();
-            break;
-        case DSP_Option::LadderFilter:
-            DspPointers[i].processor = &ladderfilter;
-            DspPointers[i].bypass = p.LadderFilterBypass->get();
-            break;
-        case DSP_Option::GenralFilter:
-            DspPointers[i].processor = &genralfilter;
-            DspPointers[i].bypass = p.GeneralFilterBypass->get();
-        case DSP_Option::End_Of_List:
-            jassertfalse;
-            break;
-        }
-    }
+    // in the chain from the start but switched off, so it costs nothing until it's wanted
+    name = getReverbBypassName();
+    layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{ name,VirsionHint },
+        name, true));
 
+    /*
+        Limiter:
+            Ceiling : dBFS
+            Lookahead : ms
+            Release : ms
+    */
 
-    auto context = juce::dsp::ProcessContextReplacing<float>(block);
+    name = getLimiterCeilingName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ name,VirsionHint }
+        , name
+        , juce::NormalisableRange<float>(-12.f, 0.f, 0.1f, 1.f)
+        , -0.3f
+        , "dB"));
 
-    for (size_t i = 0; i < DspPointers.size(); ++i)
-    {
-        if (DspPointers[i].processor != nullptr)
-        {
-            juce::ScopedValueSetter<bool>svs(context.isBypassed, DspPointers[i].bypass);
-#if VERIFY_BYPASS_FUNCTIONALITY
-            if (context.isBypassed)
-            {
-                jassertfalse;
-            }
-            if (DspPointers[i].processor == &genralfilter)
-            {
-                continue;
-            }
+    name = getLimiterLookaheadName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ name,VirsionHint }
+        , name
+        , juce::NormalisableRange<float>(0.f, LimiterEngine::maxLookaheadMs, 0.1f, 1.f)
+        , 1.5f
+        , "ms"));
 
+    name = getLimiterReleaseName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ name,VirsionHint }
+        , name
+        , juce::NormalisableRange<float>(10.f, 1000.f, 1.f, 0.4f)
+        , 100.f
+        , "ms"));
 
-#endif
+    name = getLimiterBypassName();
+    layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{ name,VirsionHint },
+        name, false));
 
+    /*
+        Quality:
+            Mode : Eco, Normal, High
+            Offline High Quality : use High while the host renders offline
+    */
 
+    name = getQualityModeName();
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID{ name,VirsionHint }, name, QualitySettings::getModeChoices(), 1));
 
-            DspPointers[i].bypass = p.phaserBypass->get();
-            DspPointers[i].processor->process(context);
-        }
-    }
-}
+    name = getOfflineHighQualityName();
+    layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{ name,VirsionHint },
+        name, true));
 
-//==============================================================================
-bool AudioPluginprojectAudioProcessor::hasEditor() const
-{
-    return true; // (change this to false if you choose to not supply an editor)
-}
+    name = getDualMonoFastPathName();
+    layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{ name,VirsionHint },
+        name, true));
 
-juce::AudioProcessorEditor* AudioPluginprojectAudioProcessor::createEditor()
-{
-   //return new AudioPluginprojectAudioProcessorEditor (*this);
+    name = getFreeUnusedStagesName();
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID{ name,VirsionHint }, name, getFreeUnusedStagesChoices(), 0));
 
-    return new juce::GenericAudioProcessorEditor(*this);
-}
+    return layout;
+ }
 
-//==============================================================================
+ void AudioPluginprojectAudioProcessor::updateDSPFromParams()
+ {
+     limiter.setCeiling(limiterCeilingDb->get());
+     limiter.setLookahead(limiterLookaheadMs->get());
+     limiter.setRelease(limiterReleaseMs->get());
+
+     updateModulationFromParams();
+
+     for (auto option : { DSP_Option::Phase, DSP_Option::Chorus, DSP_Option::OverDrive, DSP_Option::LadderFilter, DSP_Option::GenralFilter,
+                          DSP_Option::Delay, DSP_Option::Convolution, DSP_Option::Reverb })
+         updateStageFromParams(option);
+ }
+
+ void AudioPluginprojectAudioProcessor::updateModulationFromParams()
+ {
+     auto& phaserLfo = modulationBus.getSettings(ModulationBus::PhaserLfo);
+     phaserLfo.rateHz = phaserRateHz->get();
+     phaserLfo.stereoPhaseOffset = phaserStereoPhase->get() / 360.f;
+     phaserLfo.tempoSync = phaserTempoSync->get();
+     phaserLfo.beatsPerCycle = ModulationBus::getSyncDivisionBeats(phaserSyncDivision->getIndex());
+
+     auto& chorusLfo = modulationBus.getSettings(ModulationBus::ChorusLfo);
+     chorusLfo.rateHz = chorusRateHz->get();
+     chorusLfo.stereoPhaseOffset = chorusStereoPhase->get() / 360.f;
+     chorusLfo.tempoSync = chorusTempoSync->get();
+     chorusLfo.beatsPerCycle = ModulationBus::getSyncDivisionBeats(chorusSyncDivision->getIndex());
+ }
+
+ void AudioPluginprojectAudioProcessor::updateStageFromParams(DSP_Option option)
+ {
+     // stages that aren't prepared may be in the loader thread's hands, their settings catch up once they are
+     if (getStereoProcessor(option) == nullptr || ! stageLoader.isReady(static_cast<size_t>(option)))
+         return;
+
+     switch (option)
+     {
+     case DSP_Option::Phase:
+     {
+         phaser.setCentreFrequency(phaserCenterFreqHz->get());
+         phaser.setDepth(phaserDepthPercent->get());
+         phaser.setFeedback(phaserFeedbackPercent->get());
+         phaser.setMix(phaserMixPercent->get());
+
+         // exact tan until the shared grid for this rate has been built
+         auto* tables = currentQuality.tableCoefficients ? sharedTables.get() : nullptr;
+         phaser.setCoefficientGrid(tables != nullptr ? &tables->phaserAllpass : nullptr);
+
+         phaser.setNumStages(juce::jmin(getPhaserStagesChoices()[phaserStages->getIndex()].getIntValue(),
+             currentQuality.maxPhaserStages));
+         break;
+     }
+
+     case DSP_Option::Chorus:
+         chorus.setDepth(chorusDepthPercent->get());
+         chorus.setCentreDelay(chorusCenterDelayMs->get());
+         chorus.setFeedback(chorusFeedbackPercent->get());
+         chorus.setMix(chorusMixPercent->get());
+         break;
+
+     case DSP_Option::OverDrive:
+         overdrive.setDrive(overdriveSaturation->get());
+         break;
+
+     case DSP_Option::LadderFilter:
+         ladderfilter.setMode(static_cast<juce::dsp::LadderFilterMode>(LadderFilterMode->getIndex()));
+         ladderfilter.setCutoffFrequencyHz(LadderFilterCutoffHz->get());
+         ladderfilter.setResonance(LadderFilterResonence->get());
+         ladderfilter.setDrive(LadderFilterDrive->get());
+         break;
+
+     case DSP_Option::GenralFilter:
+     {
+         // exact trigonometry until the shared grid for this rate has been built, as for the phaser
+         auto* tables = currentQuality.tableCoefficients ? sharedTables.get() : nullptr;
+         generalFilter.setTrigGrid(tables != nullptr ? &tables->biquadTrig : nullptr);
+
+         for (size_t band = 0; band < numGeneralFilterBands; ++band)
+             generalFilter.setBand(band, static_cast<MultiBandFilter::Mode>(generalFilterBandMode[band]->getIndex()),
+                 generalFilterBandFreqHz[band]->get(), generalFilterBandQuality[band]->get(), generalFilterBandGain[band]->get());
+         break;
+     }
+
+     case DSP_Option::Convolution:
+         convolution.setMix(convolutionMix->get());
+         break;
+
+     case DSP_Option::Reverb:
+         reverb.setSize(reverbSize->get());
+         reverb.setDecay(reverbDecaySeconds->get());
+         reverb.setDamping(reverbDampingHz->get());
+         reverb.setMix(reverbMixPercent->get());
+         break;
+
+     case DSP_Option::Delay:
+     {
+         auto delayMs = delayTimeMs->get();
+
+         if (delayTempoSync->get())
+             delayMs = static_cast<float>(60000.0 / hostBpm * DelayEngine::getSyncDivisionBeats(delaySyncDivision->getIndex()));
+
+         // synced times longer than the buffer (slow tempo, long division) are held at the maximum
+         delayMs = juce::jmin(delayMs, delay.getMaximumDelayMs());
+         delayTimeInUseMs.store(delayMs, std::memory_order_relaxed);
+
+         delay.setDelayTime(delayMs);
+         delay.setFeedback(delayFeedbackPercent->get());
+         delay.setMix(delayMixPercent->get());
+         delay.setPingPong(delayPingPong->get());
+         delay.setFeedbackFilter(delayLowCutHz->get(), delayHighCutHz->get());
+         break;
+     }
+
+     default:
+         break;
+     }
+ }
+
+ QualityMode AudioPluginprojectAudioProcessor::getEffectiveQualityMode() const
+ {
+     if (isNonRealtime() && offlineHighQuality->get())
+         return QualityMode::High;
+
+     return static_cast<QualityMode>(qualityMode->getIndex());
+ }
+
+ void AudioPluginprojectAudioProcessor::applyQuality(const QualitySettings& requested)
+ {
+     requestedQuality = requested;
+
+     auto settings = governor.apply(requested);
+     currentQuality = settings;
+
+     modulationBus.setInterval(settings.modulationInterval);
+
+     // the others get theirs when they turn ready, see updateStageLoading()
+     auto ready = [this](DSP_Option option) { return stageLoader.isReady(static_cast<size_t>(option)); };
+
+     if (ready(DSP_Option::Phase))
+         phaser.setControlInterval(settings.phaserControlInterval);
+
+     if (ready(DSP_Option::Chorus))
+         chorus.setControlInterval(settings.chorusControlInterval);
+
+     if (ready(DSP_Option::Reverb))
+         reverb.setNumLines(settings.reverbLines);
+
+     for (auto [option, ladder] : { std::pair{ DSP_Option::OverDrive, &overdrive }, std::pair{ DSP_Option::LadderFilter, &ladderfilter } })
+     {
+         if (! ready(option))
+             continue;
+
+         ladder->setSaturationKernel(settings.saturation);
+         ladder->setDoublePrecision(settings.doublePrecision);
+         ladder->setOversampling(settings.oversampling, requested.oversampling);
+     }
+ }
+
+ bool AudioPluginprojectAudioProcessor::canUseMonoPath() const
+ {
+     if (! dualMonoFastPath->get() || currentQuality.oversampling)
+         return false;
+
+     for (auto option : dspOrder)
+     {
+         if (isBypassed(option))
+             continue;
+
+         if ((option == DSP_Option::Phase && phaserStereoPhase->get() != 0.f)
+             || (option == DSP_Option::Chorus && chorusStereoPhase->get() != 0.f)
+             || (option == DSP_Option::Delay && delayPingPong->get())
+             || option == DSP_Option::Reverb
+             || (option == DSP_Option::Convolution && stageLoader.isReady(static_cast<size_t>(option))
+                 && convolution.hasStereoKernel()))
+             return false;
+     }
+
+     return true;
+ }
+
+ void AudioPluginprojectAudioProcessor::copyLeftStateToRight()
+ {
+     auto ready = [this](DSP_Option option) { return stageLoader.isReady(static_cast<size_t>(option)); };
+
+     if (ready(DSP_Option::Phase))           phaser.copyChannelState(0, 1);
+     if (ready(DSP_Option::Chorus))          chorus.copyChannelState(0, 1);
+     if (ready(DSP_Option::OverDrive))       overdrive.copyChannelState(0, 1);
+     if (ready(DSP_Option::LadderFilter))    ladderfilter.copyChannelState(0, 1);
+     if (ready(DSP_Option::GenralFilter))    generalFilter.copyChannelState(0, 1);
+     if (ready(DSP_Option::Delay))           delay.copyChannelState(0, 1);
+     if (ready(DSP_Option::Convolution))     convolution.copyChannelState(0, 1);
+ }
+
+ AudioPluginprojectAudioProcessor::MonoTransition AudioPluginprojectAudioProcessor::updateMonoPath(const juce::dsp::AudioBlock<float>& block)
+ {
+     auto numSamples = block.getNumSamples();
+
+     auto dualMono = block.getNumChannels() == 2
+         && std::memcmp(block.getChannelPointer(0), block.getChannelPointer(1), numSamples * sizeof(float)) == 0;
+
+     auto allowed = dualMono && canUseMonoPath();
+
+     if (monoPathActive)
+     {
+         if (! allowed)
+         {
+             // the right engines pick up exactly where the left ones are
+             copyLeftStateToRight();
+             monoPathActive = false;
+             secondsDualMono = 0.0;
+         }
+
+         return MonoTransition::None;
+     }
+
+     if (! allowed)
+     {
+         secondsDualMono = 0.0;
+         return MonoTransition::None;
+     }
+
+     secondsDualMono += static_cast<double>(numSamples) / getSampleRate();
+
+     return secondsDualMono >= monoEntrySeconds ? MonoTransition::Enter : MonoTransition::None;
+ }
+
+ void AudioPluginprojectAudioProcessor::glideRightOntoLeft(const juce::dsp::AudioBlock<float>& subBlock, size_t offset, size_t blockLength) noexcept
+ {
+     auto* left = subBlock.getChannelPointer(0);
+     auto* right = subBlock.getChannelPointer(1);
+     auto step = 1.f / static_cast<float>(juce::jmax<size_t>(1, blockLength));
+
+     for (size_t i = 0; i < subBlock.getNumSamples(); ++i)
+         right[i] += (left[i] - right[i]) * static_cast<float>(offset + i + 1) * step;
+ }
+
+ void AudioPluginprojectAudioProcessor::updateLatency()
+ {
+     // oversampled stages and the limiter add latency whether bypassed or not, so only the order,
+     // quality and lookahead matter
+     auto latency = limiter.getLatencyInSamples();
+
+     for (auto option : dspOrder)
+         latency += getStageLatency(option);
+
+     // setLatencySamples() calls the host back, which mustn't happen on this thread
+     if (chainLatency.exchange(latency, std::memory_order_relaxed) != latency)
+         triggerAsyncUpdate();
+ }
+
+ void AudioPluginprojectAudioProcessor::handleAsyncUpdate()
+ {
+     auto latency = chainLatency.load(std::memory_order_relaxed);
+
+     if (latency != getLatencySamples())
+         setLatencySamples(latency);
+ }
+
+ int AudioPluginprojectAudioProcessor::getStageLatency(DSP_Option option) const
+ {
+     if (option == DSP_Option::End_Of_List || ! stageLoader.isReady(static_cast<size_t>(option)))
+         return 0;
+
+     if (option == DSP_Option::OverDrive)
+         return overdrive.getLatencyInSamples();
+
+     if (option == DSP_Option::LadderFilter)
+         return ladderfilter.getLatencyInSamples();
+
+     return 0;
+ }
+
+ void AudioPluginprojectAudioProcessor::publishChainSnapshot()
+ {
+     static_assert(std::tuple_size_v<DSP_Order> <= 32, "one bit per slot in bypassedSlots");
+
+     auto& snapshot = chainSnapshot.getWriteBuffer();
+
+     snapshot.order = dspOrder;
+     snapshot.bypassedSlots = 0;
+
+     for (size_t i = 0; i < dspOrder.size(); ++i)
+     {
+         auto option = dspOrder[i];
+
+         if (option == DSP_Option::End_Of_List || isBypassed(option) || ! stageLoader.isReady(static_cast<size_t>(option)))
+             snapshot.bypassedSlots |= 1u << i;
+
+         snapshot.slotLatency[i] = getStageLatency(option);
+     }
+
+     snapshot.latencySamples = chainLatency.load(std::memory_order_relaxed);
+     snapshot.governorLevel = governor.getLevel();
+     snapshot.governorLoad = governor.getLoad();
+     snapshot.monoPath = monoPathActive;
+
+     chainSnapshot.publish();
+ }
+
+void AudioPluginprojectAudioProcessor::pullDspOrder()
+{
+    AudioTracer::Scope scope(tracer, traceNames.orderFifo);
+
+    auto newDSPOrder =  DSP_Order();
+
+
+    while (dsporderfifo.pull(newDSPOrder))
+    {
+#if VERIFY_BYPASS_FUNCTIONALITY
+        jassertfalse;
+
+#endif
+    }
+
+    if (newDSPOrder != DSP_Order())
+    {
+        if (newDSPOrder != dspOrder)
+            tracer.instant(traceNames.orderSwap);
+
+        dspOrder = newDSPOrder;
+        stagesInOrder.store(getStageMask(dspOrder), std::memory_order_relaxed);
+        orderInUse.store(packDspOrder(dspOrder), std::memory_order_relaxed);
+
+        for (size_t i = 0; i < dspOrder.size(); ++i)
+            automationRecorder.recordOrderSlot(i, static_cast<int>(dspOrder[i]));
+    }
+}
+
+juce::uint32 AudioPluginprojectAudioProcessor::getStageMask(const DSP_Order& order)
+{
+    juce::uint32 mask = 0;
+
+    for (auto option : order)
+        if (option != DSP_Option::End_Of_List)
+            mask |= 1u << static_cast<int>(option);
 
-static AudioPluginprojectAudioProcessor::DSP_Order fromVar(const juce::var&v)
+    return mask;
+}
+
+juce::uint32 AudioPluginprojectAudioProcessor::packDspOrder(const DSP_Order& order)
+{
+    static_assert(std::tuple_size_v<DSP_Order> * 4 <= 32 && static_cast<int>(DSP_Option::End_Of_List) < 16,
+                  "the order no longer fits in 32 bits");
+
+    juce::uint32 packed = 0;
+
+    for (size_t i = 0; i < order.size(); ++i)
+        packed |= static_cast<juce::uint32>(order[i]) << (i * 4);
+
+    return packed;
+}
+
+AudioPluginprojectAudioProcessor::DSP_Order AudioPluginprojectAudioProcessor::unpackDspOrder(juce::uint32 packed)
+{
+    DSP_Order order;
+
+    for (size_t i = 0; i < order.size(); ++i)
+        order[i] = static_cast<DSP_Option>((packed >> (i * 4)) & 0xfu);
+
+    return order;
+}
+
+bool AudioPluginprojectAudioProcessor::isStageWanted(DSP_Option option) const
+{
+    if (std::find(dspOrder.begin(), dspOrder.end(), option) == dspOrder.end())
+        return false;
+
+    if (option == DSP_Option::Convolution && ! hasImpulseResponse.load(std::memory_order_relaxed))
+        return false;
+
+    // an oversampled ladder adds its latency bypassed or not, so it's kept ready either way
+    if ((option == DSP_Option::OverDrive || option == DSP_Option::LadderFilter) && requestedQuality.oversampling)
+        return true;
+
+    return ! isBypassed(option);
+}
+
+void AudioPluginprojectAudioProcessor::updateStageLoading(int numSamples)
+{
+    AudioTracer::Scope scope(tracer, traceNames.stageLoading);
+
+    stageLoader.setReleaseTime(getFreeUnusedStagesSeconds(freeUnusedStages->getIndex()));
+    stageLoader.setSynchronous(isNonRealtime() || replaying);
+    convolution.setSynchronousLoading(isNonRealtime() || replaying);
+
+    auto anyNewlyReady = false;
+
+    for (auto option : { DSP_Option::Phase, DSP_Option::Chorus, DSP_Option::OverDrive, DSP_Option::LadderFilter, DSP_Option::GenralFilter,
+                         DSP_Option::Delay, DSP_Option::Convolution, DSP_Option::Reverb })
+        anyNewlyReady |= stageLoader.update(static_cast<size_t>(option), isStageWanted(option), numSamples);
+
+    // everything that skipped it while the stage wasn't ready
+    if (anyNewlyReady)
+        applyQuality(requestedQuality);
+}
+
+AudioPluginprojectAudioProcessor::LoadTimes AudioPluginprojectAudioProcessor::getLoadTimes() const
+{
+    LoadTimes times;
+    times.constructionMs = constructionMs;
+    times.prepareToPlayMs = prepareToPlayMs.load();
+    times.backgroundPrepareMs = stageLoader.getBackgroundPrepareMs();
+    times.numStagesReady = stageLoader.getNumReady();
+
+    return times;
+}
+
+void AudioPluginprojectAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
-    using T = AudioPluginprojectAudioProcessor::DSP_Order;
-    T dspOrder;
+    juce::ScopedNoDenormals noDenormals;
+    AudioTracer::Scope blockScope(tracer, traceNames.block, buffer.getNumSamples());
+    governor.beginBlock();
+
+    // a new recording starts from the whole order, not just the next change to it
+    if (automationRecorder.beginBlock(buffer.getNumSamples(), governor.getLevel()))
+        for (size_t i = 0; i < dspOrder.size(); ++i)
+            automationRecorder.recordOrderSlot(i, static_cast<int>(dspOrder[i]));
+
+    auto totalNumInputChannels  = getTotalNumInputChannels();
+    auto totalNumOutputChannels = getTotalNumOutputChannels();
+
+    // In case we have more outputs than inputs, this code clears any output
+    // channels that didn't contain input data, (because these aren't
+    // guaranteed to be empty - they may contain garbage).
+    // This is here to avoid people getting screaming feedback
+    // when they first compile a plugin, but obviously you don't need to keep
+    // this code if your algorithm always overwrites all the output channels.
+    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
+        buffer.clear (i, 0, buffer.getNumSamples());
 
-    jassert(v.isBinaryData());
 
-    if (v.isBinaryData() == false)
+    // a mode change, the host going offline or the governor changing level shows up here,
+    // before anything is rendered
+    governor.setEnabled(! isNonRealtime());
+
+    if (auto requested = QualitySettings::forMode(getEffectiveQualityMode());
+        requested != requestedQuality || governor.apply(requested) != currentQuality)
+        applyQuality(requested);
+
+    juce::Optional<juce::AudioPlayHead::PositionInfo> position;
+
+    if (auto* playHead = getPlayHead())
+        position = playHead->getPosition();
+
+    if (position && position->getBpm())
+        hostBpm = juce::jmax(1.0, *position->getBpm());
+
+    automationRecorder.recordTempo(hostBpm);
+
+    pullDspOrder();
+    updateStageLoading(buffer.getNumSamples());
+    updateLatency();
+
+    auto block = juce::dsp::AudioBlock<float>(buffer);
+    auto numSamples = block.getNumSamples();
+
+    auto monoTransition = updateMonoPath(block);
+
+    auto& levels = levelSnapshot.getWriteBuffer();
+    levels.numChannels = juce::jmin(block.getNumChannels(), maxMeterChannels);
+
+    // meters cover the whole host block: peaks are maxed and energy summed over the sub-blocks
+    MeterEnergy energy{};
+    std::array<StageLevels, maxMeterChannels> previous{};
+
+    for (auto& channel : levels.channels)
+        channel.fill({});
+
+    auto measure = [&](const juce::dsp::AudioBlock<float>& subBlock, size_t point, bool unchanged)
+        {
+            auto n = static_cast<float>(subBlock.getNumSamples());
+
+            for (size_t ch = 0; ch < juce::jmin(levels.numChannels, subBlock.getNumChannels()); ++ch)
+            {
+                // a bypassed or empty slot doesn't change the signal, so reuse the previous reading
+                auto part = unchanged ? previous[ch] : measureLevels(subBlock.getChannelPointer(ch), subBlock.getNumSamples());
+                previous[ch] = part;
+
+                auto& level = levels.channels[ch][point];
+                level.peak = juce::jmax(level.peak, part.peak);
+                energy[ch][point] += part.rms * part.rms * n;
+            }
+        };
+
+    if (canPipeline(numSamples))
     {
-        dspOrder.fill(AudioPluginprojectAudioProcessor::DSP_Option::End_Of_List);
+        processPipelined(block, position, monoTransition == MonoTransition::Enter, levels, energy);
     }
     else
     {
-        auto mb = *v.getBinaryData();
-        juce::MemoryInputStream mis(mb, false);
-        std::vector<int>arr;
-        while (!mis.isExhausted())
+        for (size_t start = 0; start < numSamples; start += subBlockSize)
+        {
+            auto subBlock = block.getSubBlock(start, juce::jmin(subBlockSize, numSamples - start));
+
+            // parameters and modulation move on at every sub-block boundary
+            auto subPosition = position;
+
+            if (subPosition && start > 0)
+                if (auto ppq = subPosition->getPpqPosition())
+                    subPosition->setPpqPosition(*ppq + static_cast<double>(start) / getSampleRate() * hostBpm / 60.0);
+
+            {
+                AudioTracer::Scope scope(tracer, traceNames.parameters);
+
+                if (replayChanges)
+                    replayChanges(static_cast<int>(start));
+
+                automationRecorder.pollParameters(static_cast<int>(start));
+                updateDSPFromParams();
+            }
+
+            modulationBus.generate(static_cast<int>(subBlock.getNumSamples()), subPosition ? &*subPosition : nullptr);
+
+            spectrumAnalyser.pushSamples(SpectrumAnalyser::Input, subBlock);
+
+            // on the dual-mono path the chain only sees the left channel
+            auto chainBlock = monoPathActive ? subBlock.getSingleChannelBlock(0) : subBlock;
+            measure(chainBlock, 0, false);
+
+            for (size_t i = 0; i < dspOrder.size(); ++i)
+            {
+                auto option = dspOrder[i];
+                auto bypass = isBypassed(option);
+
+    #if VERIFY_BYPASS_FUNCTIONALITY
+                if (bypass)
+                {
+                    jassertfalse;
+                }
+    #endif
+
+                // the slot number as the argument, to tell repeated stages apart
+                std::optional<AudioTracer::Scope> stageScope;
+
+                if (option != DSP_Option::End_Of_List)
+                    stageScope.emplace(tracer, traceNames.stages[static_cast<size_t>(option)], static_cast<int32_t>(i + 1));
+
+                processStage(option, chainBlock, bypass);
+
+                stageScope.reset();
+                measure(chainBlock, i + 1, bypass || option == DSP_Option::End_Of_List);
+            }
+
+            if (monoPathActive)
+                subBlock.getSingleChannelBlock(1).copyFrom(chainBlock);
+
+            if (monoTransition == MonoTransition::Enter)
+                glideRightOntoLeft(subBlock, start, numSamples);
+
+            {
+                AudioTracer::Scope scope(tracer, traceNames.limiter);
+
+                auto limiterContext = juce::dsp::ProcessContextReplacing<float>(subBlock);
+                limiterContext.isBypassed = limiterBypass->get();
+                limiter.process(limiterContext);
+            }
+
+            spectrumAnalyser.pushSamples(SpectrumAnalyser::Output, subBlock);
+        }
+    }
+
+    // this block was still processed in stereo and has glided onto the left channel;
+    // from here on the right engines only get the left state when the path is left
+    if (monoTransition == MonoTransition::Enter)
+        monoPathActive = true;
+
+    if (monoPathActive && levels.numChannels > 1)
+    {
+        levels.channels[1] = levels.channels[0];
+        energy[1] = energy[0];
+    }
+
+    for (size_t ch = 0; ch < levels.numChannels; ++ch)
+        for (size_t point = 0; point < numMeterPoints; ++point)
+            levels.channels[ch][point].rms = std::sqrt(energy[ch][point] / static_cast<float>(juce::jmax<size_t>(1, numSamples)));
+
+    levelSnapshot.publish();
+    publishChainSnapshot();
+
+    governor.endBlock(buffer.getNumSamples());
+
+}
+
+bool AudioPluginprojectAudioProcessor::canPipeline(size_t numSamples)
+{
+    if (! isNonRealtime() || ! pipeline.isPrepared() || monoPathActive || numSamples <= subBlockSize)
+        return false;
+
+    std::array<bool, static_cast<size_t>(DSP_Option::End_Of_List)> used{};
+    auto numStages = 0;
+
+    for (auto option : dspOrder)
+    {
+        if (option == DSP_Option::End_Of_List)
+            continue;
+
+        auto index = static_cast<size_t>(option);
+
+        // the same engine would be run from two threads at once
+        if (used[index])
+            return false;
+
+        used[index] = true;
+
+        if (getStereoProcessor(option) != nullptr)
         {
-            arr.push_back(mis.readInt());
+            if (! stageLoader.isReady(index))
+                continue;
+
+            // fades share one scratch buffer
+            if (stageLoader.getFadeInRemaining(index) > 0)
+                return false;
         }
 
-        jassert(arr.size() == dspOrder.size());
+        ++numStages;
+    }
 
-        for (size_t i = 0; i < dspOrder.size(); ++i)
+    return numStages > 1;
+}
+
+void AudioPluginprojectAudioProcessor::processPipelined(const juce::dsp::AudioBlock<float>& block,
+                                                        const juce::Optional<juce::AudioPlayHead::PositionInfo>& position,
+                                                        bool enteringMono, LevelSnapshot& levels, MeterEnergy& energy)
+{
+    auto numSamples = block.getNumSamples();
+
+    static_assert(std::tuple_size_v<DSP_Order> <= StagePipeline::maxStages);
+
+    // the slots with something to run, one pipeline stage each
+    std::array<size_t, std::tuple_size_v<DSP_Order>> slots{};
+    auto numStages = 0;
+
+    for (size_t i = 0; i < dspOrder.size(); ++i)
+    {
+        auto option = dspOrder[i];
+
+        if (option == DSP_Option::End_Of_List
+            || (getStereoProcessor(option) != nullptr && ! stageLoader.isReady(static_cast<size_t>(option))))
+            continue;
+
+        slots[static_cast<size_t>(numStages++)] = i;
+    }
+
+    // each stage only writes its own meter point: nothing is shared between the threads
+    auto measure = [&](const juce::dsp::AudioBlock<float>& subBlock, size_t point)
+        {
+            auto n = static_cast<float>(subBlock.getNumSamples());
+
+            for (size_t ch = 0; ch < juce::jmin(levels.numChannels, subBlock.getNumChannels()); ++ch)
+            {
+                auto part = measureLevels(subBlock.getChannelPointer(ch), subBlock.getNumSamples());
+
+                auto& level = levels.channels[ch][point];
+                level.peak = juce::jmax(level.peak, part.peak);
+                energy[ch][point] += part.rms * part.rms * n;
+            }
+        };
+
+    constexpr auto waveSize = maxPipelinedSubBlocks * subBlockSize;
+
+    for (size_t waveStart = 0; waveStart < numSamples; waveStart += waveSize)
+    {
+        auto waveLength = juce::jmin(waveSize, numSamples - waveStart);
+        auto numSubBlocks = (waveLength + subBlockSize - 1) / subBlockSize;
+
+        auto getSubBlock = [&](size_t k)
+            {
+                auto start = waveStart + k * subBlockSize;
+                return block.getSubBlock(start, juce::jmin(subBlockSize, numSamples - start));
+            };
+
+        // everything the stages share, in the serial loop's order, before any of them runs
+        for (size_t k = 0; k < numSubBlocks; ++k)
+        {
+            auto start = waveStart + k * subBlockSize;
+            auto subBlock = getSubBlock(k);
+            auto subPosition = position;
+
+            if (subPosition && start > 0)
+                if (auto ppq = subPosition->getPpqPosition())
+                    subPosition->setPpqPosition(*ppq + static_cast<double>(start) / getSampleRate() * hostBpm / 60.0);
+
+            {
+                AudioTracer::Scope scope(tracer, traceNames.parameters);
+                automationRecorder.pollParameters(static_cast<int>(start));
+                updateModulationFromParams();
+            }
+
+            modulationBus.generate(static_cast<int>(subBlock.getNumSamples()), subPosition ? &*subPosition : nullptr);
+            pipelineModulation[k].copyBlockFrom(modulationBus);
+
+            spectrumAnalyser.pushSamples(SpectrumAnalyser::Input, subBlock);
+            measure(subBlock, 0);
+        }
+
+        // ready stages that aren't in the chain are never processed, their settings only need to be current
+        for (auto option : { DSP_Option::Phase, DSP_Option::Chorus, DSP_Option::OverDrive, DSP_Option::LadderFilter, DSP_Option::GenralFilter,
+                             DSP_Option::Delay, DSP_Option::Convolution, DSP_Option::Reverb })
+            if (std::find(dspOrder.begin(), dspOrder.end(), option) == dspOrder.end())
+                updateStageFromParams(option);
+
+        auto work = [&](int stage, int k)
+            {
+                auto slot = slots[static_cast<size_t>(stage)];
+                auto option = dspOrder[slot];
+                auto subBlock = getSubBlock(static_cast<size_t>(k));
+
+                AudioTracer::Scope scope(tracer, traceNames.stages[static_cast<size_t>(option)], static_cast<int32_t>(slot + 1));
+
+                if (option == DSP_Option::Phase)
+                    phaser.setModulation(&pipelineModulation[static_cast<size_t>(k)], ModulationBus::PhaserLfo);
+                else if (option == DSP_Option::Chorus)
+                    chorus.setModulation(&pipelineModulation[static_cast<size_t>(k)], ModulationBus::ChorusLfo);
+
+                updateStageFromParams(option);
+                processStage(option, subBlock, isBypassed(option));
+                measure(subBlock, slot + 1);
+            };
+
+        pipeline.run(numStages, static_cast<int>(numSubBlocks), work);
+
+        phaser.setModulation(&modulationBus, ModulationBus::PhaserLfo);
+        chorus.setModulation(&modulationBus, ModulationBus::ChorusLfo);
+
+        for (size_t k = 0; k < numSubBlocks; ++k)
+        {
+            auto subBlock = getSubBlock(k);
+
+            if (enteringMono)
+                glideRightOntoLeft(subBlock, waveStart + k * subBlockSize, numSamples);
+
+            {
+                AudioTracer::Scope scope(tracer, traceNames.limiter);
+
+                limiter.setCeiling(limiterCeilingDb->get());
+                limiter.setLookahead(limiterLookaheadMs->get());
+                limiter.setRelease(limiterReleaseMs->get());
+
+                auto limiterContext = juce::dsp::ProcessContextReplacing<float>(subBlock);
+                limiterContext.isBypassed = limiterBypass->get();
+                limiter.process(limiterContext);
+            }
+
+            spectrumAnalyser.pushSamples(SpectrumAnalyser::Output, subBlock);
+        }
+    }
+
+    // a slot that ran nothing reads the same as the point before it, as the serial loop measures it
+    for (size_t i = 0; i < dspOrder.size(); ++i)
+    {
+        if (std::find(slots.begin(), slots.begin() + numStages, i) != slots.begin() + numStages)
+            continue;
+
+        for (size_t ch = 0; ch < levels.numChannels; ++ch)
+        {
+            levels.channels[ch][i + 1] = levels.channels[ch][i];
+            energy[ch][i + 1] = energy[ch][i];
+        }
+    }
+}
+
+bool AudioPluginprojectAudioProcessor::isBypassed(DSP_Option option) const
+{
+    switch (option)
+    {
+    case DSP_Option::Phase:         return phaserBypass->get();
+    case DSP_Option::Chorus:        return chorusBypass->get();
+    case DSP_Option::OverDrive:     return overdriveBypass->get();
+    case DSP_Option::LadderFilter:  return LadderFilterBypass->get();
+    case DSP_Option::GenralFilter:  return GeneralFilterBypass->get();
+    case DSP_Option::Delay:         return delayBypass->get();
+    case DSP_Option::Convolution:   return convolutionBypass->get();
+    case DSP_Option::Reverb:        return reverbBypass->get();
+    case DSP_Option::End_Of_List:   break;
+    }
+
+    return false;
+}
+
+juce::dsp::ProcessorBase* AudioPluginprojectAudioProcessor::getStereoProcessor(DSP_Option option)
+{
+    switch (option)
+    {
+    case DSP_Option::Phase:
+        return &phaser;
+    case DSP_Option::Chorus:
+        return &chorus;
+    case DSP_Option::OverDrive:
+        return &overdrive;
+    case DSP_Option::LadderFilter:
+        return &ladderfilter;
+    case DSP_Option::GenralFilter:
+        return &generalFilter;
+    case DSP_Option::Delay:
+        return &delay;
+    case DSP_Option::Convolution:
+        return &convolution;
+    case DSP_Option::Reverb:
+        return &reverb;
+    default:
+        break;
+    }
+
+    return nullptr;
+}
+
+void AudioPluginprojectAudioProcessor::processStage(DSP_Option option, juce::dsp::AudioBlock<float> block, bool bypass)
+{
+    auto* stereo = getStereoProcessor(option);
+    auto index = static_cast<size_t>(option);
+
+    // an empty slot, or a stage not prepared yet or freed: the signal goes through untouched
+    if (stereo == nullptr || ! stageLoader.isReady(index))
+        return;
+
+    auto numSamples = block.getNumSamples();
+    auto numChannels = juce::jmin(block.getNumChannels(), fadeInScratch.size());
+    auto fadeInRemaining = bypass ? 0 : stageLoader.getFadeInRemaining(index);
+
+    if (fadeInRemaining > 0)
+        for (size_t ch = 0; ch < numChannels; ++ch)
+            std::copy_n(block.getChannelPointer(ch), numSamples, fadeInScratch[ch].data());
+
+    auto context = juce::dsp::ProcessContextReplacing<float>(block);
+    context.isBypassed = bypass;
+    stereo->process(context);
+
+    if (fadeInRemaining > 0)
+    {
+        // just prepared in the background: glide in from the dry signal
+        auto fadeInLength = static_cast<float>(stageLoader.getFadeInLength());
+        auto done = fadeInLength - static_cast<float>(fadeInRemaining);
+
+        for (size_t ch = 0; ch < numChannels; ++ch)
         {
-            dspOrder[i] = static_cast<AudioPluginprojectAudioProcessor::DSP_Option>(arr[i]);
+            auto* wet = block.getChannelPointer(ch);
+            auto* dry = fadeInScratch[ch].data();
+
+            for (size_t i = 0; i < numSamples; ++i)
+            {
+                auto gain = juce::jmin(1.f, (done + static_cast<float>(i + 1)) / fadeInLength);
+                wet[i] = dry[i] + gain * (wet[i] - dry[i]);
+            }
         }
+
+        stageLoader.advanceFadeIn(index, static_cast<int>(numSamples));
+    }
+}
+
+//==============================================================================
+bool AudioPluginprojectAudioProcessor::hasEditor() const
+{
+    return true; // (change this to false if you choose to not supply an editor)
+}
+
+juce::AudioProcessorEditor* AudioPluginprojectAudioProcessor::createEditor()
+{
+    return new AudioPluginprojectAudioProcessorEditor (*this);
+}
+
+//==============================================================================
+
+AudioPluginprojectAudioProcessor::DSP_Order AudioPluginprojectAudioProcessor::dspOrderFromVar(const juce::var& v)
+{
+    DSP_Order dspOrder;
+    dspOrder.fill(DSP_Option::End_Of_List);
+
+    auto* mb = v.getBinaryData();
+
+    if (mb == nullptr)
         return dspOrder;
+
+    juce::MemoryInputStream mis(*mb, false);
+    std::vector<int> arr;
+
+    while (! mis.isExhausted())
+        arr.push_back(mis.readInt());
+
+    // an order is always saved whole, so a shorter one comes from a version with fewer
+    // options, where End_Of_List was the saved length. Slots it didn't have stay empty.
+    auto savedEndOfList = static_cast<int>(arr.size());
+
+    for (size_t i = 0; i < juce::jmin(arr.size(), dspOrder.size()); ++i)
+    {
+        if (juce::isPositiveAndBelow(arr[i], juce::jmin(savedEndOfList, static_cast<int>(DSP_Option::End_Of_List))))
+            dspOrder[i] = static_cast<DSP_Option>(arr[i]);
     }
+
+    return dspOrder;
 }
 
 static juce::var ToVar( const AudioPluginprojectAudioProcessor::DSP_Order& t)
@@ -792,7 +2055,8 @@ void AudioPluginprojectAudioProcessor::getStateInformation(juce::MemoryBlock& de
     juce::MemoryBlock mb;
     juce::MemoryOutputStream mos(mb, false);
 
-    for (auto v : dspOrder)
+    // dspOrder belongs to the audio thread, which may be processing right now
+    for (auto v : unpackDspOrder(orderInUse.load(std::memory_order_relaxed)))
         mos.writeInt(static_cast<int>(v));
 
  
@@ -813,25 +2077,18 @@ void AudioPluginprojectAudioProcessor::setStateInformation(const void* data, int
 
         if (apvts.state.hasProperty("dspOrder"))
         {
-         
-            juce::var v = apvts.state.getProperty("dspOrder");
-
-            if (v.isBinaryData())
-            {
-                auto mb = *v.getBinaryData();
-                juce::MemoryInputStream mis(mb, false);
+            dsporderfifo.push(dspOrderFromVar(apvts.state.getProperty("dspOrder")));
+        }
 
-                AudioPluginprojectAudioProcessor::DSP_Order order;
+        auto file = getImpulseResponseFile();
+        hasImpulseResponse = file.existsAsFile();
 
-                for (size_t i = 0; i < order.size() && !mis.isExhausted(); i++)
-                {
-                    int x = mis.readInt();
-                    order[i] = static_cast<AudioPluginprojectAudioProcessor::DSP_Option>(x);
-                }
+        if (hasImpulseResponse)
+            convolution.loadImpulseResponse(file);
+        else
+            convolution.clearImpulseResponse();
 
-                dsporderfifo.push(order);
-            }
-        }
+        automationRecorder.recordState(data, sizeInBytes);
 
         DBG(apvts.state.toXmlString());
 
@@ -852,6 +2109,133 @@ void AudioPluginprojectAudioProcessor::setStateInformation(const void* data, int
 }
 
 
+void AudioPluginprojectAudioProcessor::loadImpulseResponse(const juce::File& file)
+{
+    apvts.state.setProperty("impulseResponse", file.getFullPathName(), nullptr);
+    convolution.loadImpulseResponse(file);
+    hasImpulseResponse = true;
+
+    recordCurrentState();
+}
+
+void AudioPluginprojectAudioProcessor::clearImpulseResponse()
+{
+    apvts.state.removeProperty("impulseResponse", nullptr);
+    convolution.clearImpulseResponse();
+    hasImpulseResponse = false;
+
+    recordCurrentState();
+}
+
+juce::File AudioPluginprojectAudioProcessor::getImpulseResponseFile() const
+{
+    auto path = apvts.state.getProperty("impulseResponse").toString();
+    return path.isNotEmpty() ? juce::File(path) : juce::File();
+}
+
+bool AudioPluginprojectAudioProcessor::startAutomationRecording(const juce::File& file)
+{
+    juce::MemoryBlock state;
+    getStateInformation(state);
+
+    return automationRecorder.start(file, getSampleRate(), state);
+}
+
+void AudioPluginprojectAudioProcessor::recordCurrentState()
+{
+    // an impulse response isn't a parameter: a replay loads it with the whole state
+    if (! automationRecorder.isRecording())
+        return;
+
+    juce::MemoryBlock state;
+    getStateInformation(state);
+    automationRecorder.recordState(state.getData(), static_cast<int>(state.getSize()));
+}
+
+void AudioPluginprojectAudioProcessor::replayAutomation(const AutomationTrace& trace, juce::AudioBuffer<float>& audio)
+{
+    jassert(! isRecordingAutomation());
+    jassert(trace.sampleRate > 0);
+
+    auto maxBlockSize = juce::jmax(1, trace.getMaxBlockSize());
+
+    replaying = true;
+    setNonRealtime(false);
+    setPlayConfigDetails(audio.getNumChannels(), audio.getNumChannels(), trace.sampleRate, maxBlockSize);
+    prepareToPlay(trace.sampleRate, maxBlockSize);
+
+    // matched by id, in case parameters have been added since the trace was recorded
+    std::vector<juce::RangedAudioParameter*> parameters;
+
+    for (auto& id : trace.parameterIds)
+        parameters.push_back(apvts.getParameter(id));
+
+    auto change = trace.changes.begin();
+    auto order = DSP_Order();
+
+    auto applyChangesUpTo = [&](juce::int64 position)
+        {
+            for (; change != trace.changes.end() && change->position <= position; ++change)
+            {
+                switch (change->type)
+                {
+                case AutomationRecorder::Parameter:
+                    if (change->index < parameters.size() && parameters[change->index] != nullptr)
+                        parameters[change->index]->setValueNotifyingHost(change->getFloat());
+                    break;
+
+                case AutomationRecorder::Order:
+                    if (change->index < order.size())
+                        order[change->index] = static_cast<DSP_Option>(change->value);
+
+                    if (change->index + 1u == order.size())
+                        dsporderfifo.push(order);
+                    break;
+
+                case AutomationRecorder::Tempo:
+                    hostBpm = juce::jmax(1.0, static_cast<double>(change->getFloat()));
+                    break;
+
+                case AutomationRecorder::State:
+                    setStateInformation(change->state.getData(), static_cast<int>(change->state.getSize()));
+                    break;
+
+                default:
+                    break;
+                }
+            }
+        };
+
+    // changes inside a block are applied where processBlock polls the parameters, so each
+    // recorded block is replayed as one block, the size the host gave it
+    juce::int64 blockStart = 0;
+    replayChanges = [&](int offset) { applyChangesUpTo(blockStart + offset); };
+
+    juce::MidiBuffer midi;
+
+    for (auto& block : trace.blocks)
+    {
+        if (block.position + block.numSamples > audio.getNumSamples())
+            break;
+
+        governor.setForcedLevel(block.governorLevel);
+
+        // order, tempo and state are picked up at the start of the block
+        blockStart = block.position;
+        applyChangesUpTo(blockStart);
+
+        juce::AudioBuffer<float> part(audio.getArrayOfWritePointers(), audio.getNumChannels(),
+                                      static_cast<int>(block.position), block.numSamples);
+        processBlock(part, midi);
+        midi.clear();
+    }
+
+    replayChanges = nullptr;
+    governor.setForcedLevel(-1);
+    releaseResources();
+    replaying = false;
+}
+
 //==============================================================================
 // This creates new instances of the plugin..
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
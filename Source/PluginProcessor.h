@@ -10,12 +10,34 @@
 
 #include <JuceHeader.h>
 #include "fifo.h"
+#include "TripleBuffer.h"
+#include "LevelMeter.h"
+#include "SpectrumAnalyser.h"
+#include "ModulationBus.h"
+#include "ChorusEngine.h"
+#include "PhaserEngine.h"
+#include "LadderEngine.h"
+#include "CpuGovernor.h"
+#include "DelayEngine.h"
+#include "SharedTables.h"
+#include "StageLoader.h"
+#include "ConvolutionEngine.h"
+#include "LimiterEngine.h"
+#include "ReverbEngine.h"
+#include "MultiBandFilter.h"
+#include "AudioTracer.h"
+#include "AutomationRecorder.h"
+#include "StagePipeline.h"
 
 //==============================================================================
 /**
 */
-class AudioPluginprojectAudioProcessor  : public juce::AudioProcessor
+class AudioPluginprojectAudioProcessor  : public juce::AudioProcessor,
+                                          private juce::AsyncUpdater
 {
+    // taken before any other member is constructed, see getLoadTimes()
+    const double constructionStartMs = juce::Time::getMillisecondCounterHiRes();
+
 public:
     //==============================================================================
     AudioPluginprojectAudioProcessor();
@@ -25,6 +47,9 @@ public:
     void prepareToPlay (double sampleRate, int samplesPerBlock) override;
     void releaseResources() override;
 
+    // back to the state right after prepareToPlay, so the same input renders the same output again
+    void reset() override;
+
    #ifndef JucePlugin_PreferredChannelConfigurations
     bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
    #endif
@@ -61,6 +86,9 @@ public:
         OverDrive,
         LadderFilter,
         GenralFilter,
+        Delay,
+        Convolution,
+        Reverb,
         End_Of_List
     };
 
@@ -72,6 +100,11 @@ public:
 
    Fifo<DSP_Order>dsporderfifo;
 
+   static DSP_Order getDefaultDspOrder();
+
+   // reads the "dspOrder" state property, including ones saved before later options were added
+   static DSP_Order dspOrderFromVar(const juce::var& v);
+
    /*
         Phaser:
             Rate : Hz
@@ -79,6 +112,9 @@ public:
             feedback : -1 to +1
             Center Freq: Hz
             Mix : 0 to 1
+            Stages : 4, 6, 8 or 12 allpass stages
+            Stereo Phase : 0 to 180 degrees between left / right LFO
+            Tempo Sync : lock the LFO to the host tempo, Sync Division sets the cycle length
 
    
    
@@ -90,6 +126,10 @@ public:
    juce::AudioParameterFloat* phaserDepthPercent = nullptr;
    juce::AudioParameterFloat* phaserMixPercent = nullptr;
    juce::AudioParameterBool* phaserBypass = nullptr;
+   juce::AudioParameterChoice* phaserStages = nullptr;
+   juce::AudioParameterFloat* phaserStereoPhase = nullptr;
+   juce::AudioParameterBool* phaserTempoSync = nullptr;
+   juce::AudioParameterChoice* phaserSyncDivision = nullptr;
 
    /*
       Chours:
@@ -98,6 +138,7 @@ public:
           feedback : -1 to +1
           Center delay: ms (1 to 100)
           Mix : 0 to 1
+          Stereo Phase / Tempo Sync / Sync Division : as for the phaser
 
     */
 
@@ -107,6 +148,9 @@ public:
    juce::AudioParameterFloat* chorusDepthPercent = nullptr;
    juce::AudioParameterFloat* chorusMixPercent = nullptr;
    juce::AudioParameterBool* chorusBypass = nullptr;
+   juce::AudioParameterFloat* chorusStereoPhase = nullptr;
+   juce::AudioParameterBool* chorusTempoSync = nullptr;
+   juce::AudioParameterChoice* chorusSyncDivision = nullptr;
 
    // overdrive
 
@@ -130,10 +174,12 @@ public:
 
    /*
        general filter: https://docs.juce.com/develop/structdsp_1_1IIR_1_1Coefficients.html
+       up to 8 bands in series, each with its own
        Mode: Peak, bandpass, notch, allpass,
        freq: 20hz - 20,000hz in 1hz steps
        Q: 0.1 - 10 in 0.05 steps
        gain: -24db to +24db in 0.5db increments
+       a peak band at 0 dB does nothing and is skipped, bands 2 to 8 start that way
    */
 
    juce::AudioParameterChoice*GeneralFilterMode = nullptr;
@@ -142,68 +188,359 @@ public:
    juce::AudioParameterFloat* GeneralFilterGain = nullptr;
    juce::AudioParameterBool* GeneralFilterBypass = nullptr;
 
-   
+   // every band's, band 1 is the four above
+   static constexpr size_t numGeneralFilterBands = MultiBandFilter::maxBands;
+
+   std::array<juce::AudioParameterChoice*, numGeneralFilterBands> generalFilterBandMode{};
+   std::array<juce::AudioParameterFloat*, numGeneralFilterBands> generalFilterBandFreqHz{};
+   std::array<juce::AudioParameterFloat*, numGeneralFilterBands> generalFilterBandQuality{};
+   std::array<juce::AudioParameterFloat*, numGeneralFilterBands> generalFilterBandGain{};
+
+   /*
+       Delay:
+           Time : ms (1 to 2000), or Sync Division at the host tempo when Tempo Sync is on
+           Feedback : 0 to 0.95
+           Mix : 0 to 1
+           Ping Pong : mono input into the left line, repeats bounce between channels
+           Low Cut / High Cut : Hz, filters in the feedback path
+   */
+
+   juce::AudioParameterFloat* delayTimeMs = nullptr;
+   juce::AudioParameterFloat* delayFeedbackPercent = nullptr;
+   juce::AudioParameterFloat* delayMixPercent = nullptr;
+   juce::AudioParameterBool* delayTempoSync = nullptr;
+   juce::AudioParameterChoice* delaySyncDivision = nullptr;
+   juce::AudioParameterBool* delayPingPong = nullptr;
+   juce::AudioParameterFloat* delayLowCutHz = nullptr;
+   juce::AudioParameterFloat* delayHighCutHz = nullptr;
+   juce::AudioParameterBool* delayBypass = nullptr;
+
+   /*
+       Convolution:
+           Mix : 0 to 1
+           the impulse response is a file, kept as the "impulseResponse" state property
+   */
+
+   juce::AudioParameterFloat* convolutionMix = nullptr;
+   juce::AudioParameterBool* convolutionBypass = nullptr;
+
+   /*
+       Reverb:
+           Size : 0 to 1
+           Decay : RT60 in seconds (0.2 to 10)
+           Damping : Hz, where the tail starts to darken
+           Mix : 0 to 1
+           8 delay lines in Eco quality, 16 otherwise
+   */
+
+   juce::AudioParameterFloat* reverbSize = nullptr;
+   juce::AudioParameterFloat* reverbDecaySeconds = nullptr;
+   juce::AudioParameterFloat* reverbDampingHz = nullptr;
+   juce::AudioParameterFloat* reverbMixPercent = nullptr;
+   juce::AudioParameterBool* reverbBypass = nullptr;
+
+   /*
+       Output limiter, after the chain whatever its order:
+           Ceiling : dBFS (-12 to 0)
+           Lookahead : ms (0 to 10), reported as latency whether bypassed or not
+           Release : ms (10 to 1000)
+   */
+
+   juce::AudioParameterFloat* limiterCeilingDb = nullptr;
+   juce::AudioParameterFloat* limiterLookaheadMs = nullptr;
+   juce::AudioParameterFloat* limiterReleaseMs = nullptr;
+   juce::AudioParameterBool* limiterBypass = nullptr;
+
+   // message thread: decoded and swapped in on a background thread, or before it returns while rendering
+   // offline or replaying; an unreadable file changes nothing
+   void loadImpulseResponse(const juce::File& file);
+   void clearImpulseResponse();
+   juce::File getImpulseResponseFile() const;
+
+   /*
+       Quality:
+           Mode : Eco, Normal, High (see QualitySettings::forMode)
+           Offline High Quality : render with High whatever the mode while the host renders offline
+   */
+
+   juce::AudioParameterChoice* qualityMode = nullptr;
+   juce::AudioParameterBool* offlineHighQuality = nullptr;
+
+   // process bit-identical L / R input once and copy it, see updateMonoPath()
+   juce::AudioParameterBool* dualMonoFastPath = nullptr;
+
+   // Never, or how long a stage has to be out of the chain before its memory is freed
+   juce::AudioParameterChoice* freeUnusedStages = nullptr;
+
+   // the mode actually running, after the offline override
+   QualityMode getEffectiveQualityMode() const;
+
+   // how hard the audio thread is working and how often it had to cut quality, any thread
+   CpuGovernor::Stats getGovernorStats() const { return governor.getStats(); }
+
+   struct LoadTimes
+   {
+       double constructionMs = 0.0;
+       double prepareToPlayMs = 0.0;        // the last call
+       double backgroundPrepareMs = 0.0;    // all stages the loader thread has prepared since
+       int numStagesReady = 0;
+   };
+
+   // how long this instance took to get going, any thread
+   LoadTimes getLoadTimes() const;
+
+   // message thread: Chrome trace of processBlock, its stages, parameter updates and order swaps
+   bool startTrace(const juce::File& file) { return tracer.start(file); }
+   void stopTrace() { tracer.stop(); }
+   bool isTracing() const noexcept { return tracer.isRecording(); }
+
+   // message thread: parameter, order, tempo and state changes with their sample positions, see AutomationRecorder
+   bool startAutomationRecording(const juce::File& file);
+   void stopAutomationRecording() { automationRecorder.stop(); }
+   bool isRecordingAutomation() const noexcept { return automationRecorder.isRecording(); }
+
+   /*
+       Runs audio through this instance in place the way the recorded session
+       ran: one processBlock call per recorded block, and every change
+       applied at the sub-block boundary the live processor first saw it
+       at, from the same point in processBlock. Meant for a fresh
+       instance no host is playing, in a benchmark or profiling harness; it
+       prepares and releases the instance itself. Sample 0 of audio is the
+       first sample of the recording; a trace longer than audio stops early.
+
+       Stages are prepared, and the impulse responses of state loads read,
+       synchronously, as offline, and the CPU governor replays the recorded
+       levels instead of reacting to the replay's own timing, so the output
+       doesn't depend on how fast the machine is. The
+       play head's position isn't recorded, only its tempo: tempo-synced
+       LFOs keep the tempo but not the phase the host's transport gave them.
+   */
+   void replayAutomation(const AutomationTrace& trace, juce::AudioBuffer<float>& audio);
+
+   /*
+       Level meters:
+           point 0 is the chain input, point i + 1 is the output of slot i.
+           written by the audio thread once per block, read by the editor.
+   */
+
+   static constexpr size_t numMeterPoints = static_cast<size_t>(DSP_Option::End_Of_List) + 1;
+   static constexpr size_t maxMeterChannels = 2;
+
+   using StageLevelArray = std::array<StageLevels, numMeterPoints>;
+
+   struct LevelSnapshot
+   {
+       std::array<StageLevelArray, maxMeterChannels> channels;
+       size_t numChannels = 0;
+   };
+
+   TripleBuffer<LevelSnapshot> levelSnapshot;
+
+   /*
+       What the chain actually ran in the last block, for the editor: dspOrder
+       and everything else here belong to the audio thread, and an order sent
+       through dsporderfifo only counts once a block has pulled it.
+       Written by the audio thread at the end of every block, read by the
+       editor at its frame rate.
+   */
+   struct ChainSnapshot
+   {
+       DSP_Order order{};
+
+       // bit i: slot i went through untouched, bypassed, empty or its stage not prepared
+       juce::uint32 bypassedSlots = 0;
+
+       // what each slot adds, and the total reported to the host (with the limiter's lookahead)
+       std::array<int, std::tuple_size_v<DSP_Order>> slotLatency{};
+       int latencySamples = 0;
+
+       int governorLevel = 0;
+       float governorLoad = 0.f;
+
+       bool monoPath = false;
+   };
+
+   TripleBuffer<ChainSnapshot> chainSnapshot;
+
+   // chain input / output spectrum, only does any work while an editor is showing
+   SpectrumAnalyser spectrumAnalyser;
+
 
 private:
 
     DSP_Order dspOrder;
 
-    template<typename DSP>
-    struct DSP_Choices :juce::dsp::ProcessorBase
-    {
-        void prepare(const juce::dsp::ProcessSpec& spec) override
-        {
-            dsp.prepare(spec);
-        }
+    /*
+        Host blocks are processed in sub-blocks of at most this many samples,
+        whatever size the host uses, so every stage's state and scratch stays
+        in cache and nothing is ever asked to process more than prepare()
+        planned for. Parameters and modulation are updated per sub-block.
+    */
+    static constexpr size_t subBlockSize = 64;
 
-        void process(const juce::dsp::ProcessContextReplacing<float>& context) override
-        {
-            dsp.process(context);
-        }
+    // LFOs for every stage, rendered once per block
+    ModulationBus modulationBus;
 
-        void reset()override
-        {
-            dsp.reset();
-        }
+    // this instance's reference to the process-wide tables for the current sample rate
+    SharedTables::Subscription sharedTables;
 
-        DSP dsp;
+    // stages that process both channels together
+    PhaserEngine phaser;
+    ChorusEngine chorus;
 
-    };
+    // overdrive is the drive section of a ladder filter left at its defaults
+    LadderEngine overdrive, ladderfilter;
 
-    struct MonoChannelDSP
-    {
-        MonoChannelDSP(AudioPluginprojectAudioProcessor& proc) : p(proc) {}
+    MultiBandFilter generalFilter;
+
+    DelayEngine delay;
 
-        DSP_Choices<juce::dsp::DelayLine<float>> delay;
-        DSP_Choices<juce::dsp::Phaser<float>>pharser;
-        DSP_Choices<juce::dsp::Chorus<float>>choruser;
-        DSP_Choices<juce::dsp::LadderFilter<float>>overdrive, ladderfilter;
-        DSP_Choices < juce::dsp::IIR::Filter<float>>genralfilter;
+    ConvolutionEngine convolution;
+    ReverbEngine reverb;
 
-        void prepare(const juce::dsp::ProcessSpec& spec);
+    // without one the convolution stage is dry, and not worth its partitions' memory
+    std::atomic<bool> hasImpulseResponse{ false };
 
-        void updateDSPFromParams();
+    // always prepared: it's on the output, not in the chain
+    LimiterEngine limiter;
 
-        void process( juce::dsp::AudioBlock<float> block,const DSP_Order& dsp_order);
+    /*
+        Prepares the stereo stages above when they enter the chain and frees
+        them once they have been out of it for a while, see StageLoader.
+        Declared after them: it goes first and waits for any stage being
+        prepared on the loader thread.
+    */
+    StageLoader stageLoader;
 
+    bool isStageWanted(DSP_Option option) const;
+    void updateStageLoading(int numSamples);
 
-    private:
-        AudioPluginprojectAudioProcessor& p;
-    };
+    // dry copy of a sub-block for a stage fading in
+    std::array<std::array<float, subBlockSize>, 2> fadeInScratch{};
+
+    double constructionMs = 0.0;
+    std::atomic<double> prepareToPlayMs{ 0.0 };
 
+    // from the play head, for tempo-synced delay times
+    double hostBpm = 120.0;
 
-    MonoChannelDSP leftChannel{ *this };
-    MonoChannelDSP rightChannel{ *this };
-    
+    // what getTailLengthSeconds() needs from the audio thread: a bit per option in dspOrder, and the delay time in use
+    std::atomic<juce::uint32> stagesInOrder{ 0 };
+    std::atomic<float> delayTimeInUseMs{ 0.f };
 
+    // dspOrder for getStateInformation(), 4 bits per slot: chainSnapshot has the editor as its only reader
+    std::atomic<juce::uint32> orderInUse{ 0 };
 
-    struct ProcessState
+    static juce::uint32 packDspOrder(const DSP_Order& order);
+    static DSP_Order unpackDspOrder(juce::uint32 packed);
+
+    // steps quality down when the blocks come close to their deadline
+    CpuGovernor governor;
+
+    AudioTracer tracer;
+
+    // registered with the tracer by the constructor
+    struct TraceNames
     {
-        juce::dsp::ProcessorBase* processor = nullptr;
-        bool bypass = false;
+        uint16_t block = 0, orderFifo = 0, orderSwap = 0, stageLoading = 0, parameters = 0, limiter = 0;
+        std::array<uint16_t, static_cast<size_t>(DSP_Option::End_Of_List)> stages{};
     };
 
-    using DSP_Pointers = std::array < ProcessState, static_cast<size_t>(DSP_Option::End_Of_List)>;
+    TraceNames traceNames;
+
+    AutomationRecorder automationRecorder;
+
+    // set by replayAutomation() while it drives the processor: replayChanges applies the
+    // recorded changes up to an offset into the block, at the sub-block boundaries
+    bool replaying = false;
+    std::function<void(int)> replayChanges;
+
+    // message thread: the whole state into the automation recording, for changes that aren't parameters
+    void recordCurrentState();
+
+    /*
+        Offline, the chain runs as a pipeline: the stages spread over the
+        calling thread and whichever threads of the process-wide pool are
+        free, sub-blocks handed from one stage to the next in order (see
+        StagePipeline). The LFOs are rendered for every sub-block of a wave
+        up front, each into its own bus, and each stage updates its own
+        settings before each sub-block. So every stage gets the same calls
+        and input as in the serial loop, and renders are bit-identical.
+
+        A block is processed serially instead when the pipeline can't keep
+        that promise or has nothing to gain: rendering in real time, or
+        offline with the pipeline not prepared (prepareToPlay() wasn't
+        offline), the dual-mono path, a stage still fading in, one stage in
+        two slots, fewer than two stages to run, or a single sub-block.
+    */
+    static constexpr size_t maxPipelinedSubBlocks = 64;
+
+    StagePipeline pipeline;
+
+    // one per sub-block of a wave, only allocated while prepared offline
+    std::vector<ModulationBus> pipelineModulation;
+
+    using MeterEnergy = std::array<std::array<float, numMeterPoints>, maxMeterChannels>;
+
+    bool canPipeline(size_t numSamples);
+    void processPipelined(const juce::dsp::AudioBlock<float>& block, const juce::Optional<juce::AudioPlayHead::PositionInfo>& position,
+                          bool enteringMono, LevelSnapshot& levels, MeterEnergy& energy);
+
+    // requestedQuality is what the user / offline override asks for, currentQuality what is
+    // running after the governor
+    QualitySettings requestedQuality = QualitySettings::forMode(QualityMode::Normal);
+    QualitySettings currentQuality = requestedQuality;
+
+    void applyQuality(const QualitySettings& requested);
+
+    // audio thread: works out the chain's latency and has the message thread report a change,
+    // see handleAsyncUpdate(). prepareToPlay reports it directly
+    void updateLatency();
+    void handleAsyncUpdate() override;
+
+    std::atomic<int> chainLatency{ 0 };
+
+    // 0 for a stage that isn't prepared: it isn't processed either
+    int getStageLatency(DSP_Option option) const;
+
+    void publishChainSnapshot();
+
+    /*
+        Dual-mono fast path: once the input has been bit-identical on both
+        channels for monoEntrySeconds, and no active stage makes the channels
+        differ (stereo phase, ping-pong, oversampling whose filters can't be
+        synced), only the left channel goes through the stereo stages and is
+        copied to the right at the end. The block that enters crossfades the
+        right channel onto the copy; leaving copies the left state into the
+        right engines first, which is exact because their inputs were identical.
+    */
+    static constexpr double monoEntrySeconds = 0.5;
+
+    bool monoPathActive = false;
+    double secondsDualMono = 0.0;
+
+    enum class MonoTransition { None, Enter };
+
+    MonoTransition updateMonoPath(const juce::dsp::AudioBlock<float>& block);
+    bool canUseMonoPath() const;
+    void copyLeftStateToRight();
+
+    // the entering block's glide of the right channel onto the left, sub-block by sub-block
+    // (offset samples into the block) and ahead of the limiter, so it limits what comes out
+    void glideRightOntoLeft(const juce::dsp::AudioBlock<float>& subBlock, size_t offset, size_t blockLength) noexcept;
+
+    juce::dsp::ProcessorBase* getStereoProcessor(DSP_Option option);
+
+    void updateDSPFromParams();
+    void updateModulationFromParams();
+    void updateStageFromParams(DSP_Option option);
+
+    void pullDspOrder();
+    static juce::uint32 getStageMask(const DSP_Order& order);
+
+    bool isBypassed(DSP_Option option) const;
+
+    void processStage(DSP_Option option, juce::dsp::AudioBlock<float> block, bool bypass);
 
     #define VERIFY_BYPASS_FUNCTIONALITY false
 
@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+    Quality.h
+
+    Eco / Normal / High processing quality and what each means per stage.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+enum class QualityMode
+{
+    Eco,
+    Normal,
+    High
+};
+
+enum class SaturationKernel
+{
+    FastApproximation,  // clamped Pade tanh, vectorises
+    LookupTable,        // 128 point tanh table, same as juce::dsp::LadderFilter
+    Exact               // std::tanh
+};
+
+struct QualitySettings
+{
+    int modulationInterval = 4;     // ModulationBus control point spacing
+    int phaserControlInterval = 4;
+    int chorusControlInterval = 16;
+    int maxPhaserStages = 12;
+    SaturationKernel saturation = SaturationKernel::LookupTable;
+    bool oversampling = false;      // 2x around the ladder / overdrive stages
+    bool doublePrecision = false;   // ladder / overdrive state and maths in double
+    bool tableCoefficients = true;  // phaser allpass coefficients from the shared grid instead of tan
+    size_t reverbLines = 16;        // FDN delay lines, 8 or 16
+
+    bool operator==(const QualitySettings&) const = default;
+
+    static QualitySettings forMode(QualityMode mode)
+    {
+        QualitySettings s;
+
+        switch (mode)
+        {
+        case QualityMode::Eco:
+            s.modulationInterval = 32;
+            s.phaserControlInterval = 32;
+            s.chorusControlInterval = 64;
+            s.maxPhaserStages = 4;
+            s.saturation = SaturationKernel::FastApproximation;
+            s.reverbLines = 8;
+            break;
+
+        case QualityMode::Normal:
+            break;
+
+        case QualityMode::High:
+            s.modulationInterval = 1;
+            s.phaserControlInterval = 1;
+            s.chorusControlInterval = 1;
+            s.saturation = SaturationKernel::Exact;
+            s.oversampling = true;
+            s.doublePrecision = true;
+            s.tableCoefficients = false;
+            break;
+        }
+
+        return s;
+    }
+
+    static juce::StringArray getModeChoices()
+    {
+        return juce::StringArray
+        {
+            "Eco",
+            "Normal",
+            "High"
+        };
+    }
+};
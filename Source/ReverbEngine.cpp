@@ -0,0 +1,423 @@
+/*
+  ==============================================================================
+
+    ReverbEngine.cpp
+
+  ==============================================================================
+*/
+
+#include "ReverbEngine.h"
+
+namespace
+{
+    constexpr float shortestLineMs = 23.f;
+    constexpr float longestLineMs = 97.f;
+}
+
+void ReverbEngine::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    jassert(spec.sampleRate > 0);
+    jassert(spec.numChannels > 0 && spec.numChannels <= maxChannels);
+
+    sampleRate = spec.sampleRate;
+
+    // room for the longest line at the largest size, and the step up to its prime
+    auto longest = static_cast<int>(std::ceil(longestLineMs * maxSizeScale * sampleRate / 1000.0)) + 64;
+    capacity = juce::nextPowerOfTwo(longest);
+    mask = capacity - 1;
+
+    // the only allocation: every line, one after the other
+    lines.assign(static_cast<size_t>(capacity) * maxLines, 0.f);
+
+    mix.reset(sampleRate, 0.05);
+    fadeLength = juce::jmax(1, juce::roundToInt(sizeFadeSeconds * sampleRate));
+
+    updateLengths();
+    setDamping(dampingHz);
+    reset();
+}
+
+void ReverbEngine::reset()
+{
+    std::fill(lines.begin(), lines.end(), 0.f);
+    lowpass.fill(0.f);
+    writePos = 0;
+
+    // nothing left to fade from
+    if (sizePending && ! lines.empty())
+        updateLengths();
+
+    fadeRemaining = 0;
+    sizePending = false;
+
+    mix.setCurrentAndTargetValue(mix.getTargetValue());
+    wasBypassed = false;
+}
+
+void ReverbEngine::releaseResources()
+{
+    std::vector<float>().swap(lines);
+    capacity = 0;
+    mask = 0;
+    writePos = 0;
+}
+
+void ReverbEngine::setNumLines(size_t newNumLines) noexcept
+{
+    jassert(newNumLines == 8 || newNumLines == maxLines);
+
+    if (newNumLines == numLines)
+        return;
+
+    numLines = newNumLines;
+
+    if (lines.empty())
+        return;
+
+    updateLengths();
+    reset();
+}
+
+void ReverbEngine::setSize(float newSize) noexcept
+{
+    if (newSize == size)
+        return;
+
+    size = newSize;
+
+    if (lines.empty())
+        return;
+
+    if (fadeRemaining > 0)
+        sizePending = true;
+    else
+        startSizeFade();
+}
+
+void ReverbEngine::startSizeFade() noexcept
+{
+    fadeFromLength = length;
+    fadeFromGain = gain;
+    fadeRemaining = fadeLength;
+    sizePending = false;
+
+    updateLengths();
+}
+
+void ReverbEngine::setDecay(float newDecaySeconds) noexcept
+{
+    if (newDecaySeconds == decaySeconds)
+        return;
+
+    decaySeconds = newDecaySeconds;
+    updateGains();
+}
+
+void ReverbEngine::setDamping(float newDampingHz) noexcept
+{
+    dampingHz = newDampingHz;
+
+    auto hz = juce::jlimit(20.f, 0.49f * static_cast<float>(sampleRate), dampingHz);
+    damping = std::exp(-juce::MathConstants<float>::twoPi * hz / static_cast<float>(sampleRate));
+}
+
+int ReverbEngine::nextPrime(int n) noexcept
+{
+    auto isPrime = [](int candidate)
+        {
+            if (candidate < 2)
+                return false;
+
+            for (int d = 2; d * d <= candidate; ++d)
+                if (candidate % d == 0)
+                    return false;
+
+            return true;
+        };
+
+    while (! isPrime(n))
+        ++n;
+
+    return n;
+}
+
+void ReverbEngine::updateLengths() noexcept
+{
+    auto scale = minSizeScale + juce::jlimit(0.f, 1.f, size) * (maxSizeScale - minSizeScale);
+    auto spread = longestLineMs / shortestLineMs;
+
+    for (size_t l = 0; l < numLines; ++l)
+    {
+        auto ms = shortestLineMs * std::pow(spread, static_cast<float>(l) / static_cast<float>(numLines - 1)) * scale;
+        auto samples = nextPrime(juce::roundToInt(ms * sampleRate / 1000.0));
+
+        length[l] = juce::jmin(samples, capacity - 1);
+    }
+
+    updateGains();
+}
+
+void ReverbEngine::updateGains() noexcept
+{
+    // -60 dB after decaySeconds whatever the line length; the Hadamard scale folded in
+    auto normalise = 1.f / std::sqrt(static_cast<float>(numLines));
+    auto decaySamples = juce::jmax(1.0, static_cast<double>(decaySeconds) * sampleRate);
+
+    for (size_t l = 0; l < numLines; ++l)
+        gain[l] = static_cast<float>(std::pow(10.0, -3.0 * length[l] / decaySamples)) * normalise;
+}
+
+void ReverbEngine::process(const juce::dsp::ProcessContextReplacing<float>& context)
+{
+    auto& inputBlock = context.getInputBlock();
+    auto& outputBlock = context.getOutputBlock();
+
+    if (context.usesSeparateInputAndOutputBlocks())
+        outputBlock.copyFrom(inputBlock);
+
+    if (context.isBypassed)
+    {
+        wasBypassed = true;
+        return;
+    }
+
+    // don't play back a tail left over from before it was switched out
+    if (wasBypassed)
+    {
+        reset();
+        wasBypassed = false;
+    }
+
+    if (numLines == 8)
+        processLines<8>(outputBlock);
+    else
+        processLines<maxLines>(outputBlock);
+}
+
+size_t ReverbEngine::getChunkLength() const noexcept
+{
+    auto shortest = static_cast<int>(chunkSize);
+
+    for (size_t l = 0; l < numLines; ++l)
+        shortest = juce::jmin(shortest, length[l], fadeRemaining > 0 ? fadeFromLength[l] : length[l]);
+
+    return static_cast<size_t>(shortest);
+}
+
+template<size_t Lines>
+void ReverbEngine::readLines(const std::array<int, maxLines>& lengths, float* destination, size_t numSamples) const noexcept
+{
+    for (size_t l = 0; l < Lines; ++l)
+    {
+        auto* line = lines.data() + l * static_cast<size_t>(capacity);
+        auto readPos = writePos - lengths[l];
+
+        for (size_t i = 0; i < numSamples; ++i)
+            destination[i * Lines + l] = line[(readPos + static_cast<int>(i)) & mask];
+    }
+}
+
+template<size_t Lines>
+void ReverbEngine::writeLines(size_t numSamples) noexcept
+{
+    for (size_t l = 0; l < Lines; ++l)
+    {
+        auto* line = lines.data() + l * static_cast<size_t>(capacity);
+
+        for (size_t i = 0; i < numSamples; ++i)
+            line[(writePos + static_cast<int>(i)) & mask] = feedback[i * Lines + l];
+    }
+
+    writePos = (writePos + static_cast<int>(numSamples)) & mask;
+}
+
+template<size_t Lines>
+void ReverbEngine::processLines(const juce::dsp::AudioBlock<float>& block) noexcept
+{
+    static_assert(juce::isPowerOfTwo(Lines) && Lines <= maxLines && Lines % Vec::SIMDNumElements == 0 && Vec::SIMDNumElements <= 8);
+    constexpr size_t numRegisters = Lines / Vec::SIMDNumElements;
+
+    auto* left = block.getChannelPointer(0);
+    auto* right = block.getNumChannels() > 1 ? block.getChannelPointer(1) : nullptr;
+
+    // each output sums half the lines
+    auto outputGain = 1.f / std::sqrt(static_cast<float>(Lines / 2));
+
+    // per lane: which input feeds the line and how it's tapped for each output (alternating signs between
+    // pairs decorrelate the two sums a little more), and the butterfly signs within a register
+    alignas(Vec::SIMDRegisterSize) std::array<float, Lines> leftLines, rightLines, leftTaps, rightTaps;
+    alignas(Vec::SIMDRegisterSize) std::array<std::array<float, Vec::SIMDNumElements>, 3> butterflySigns;
+
+    for (size_t l = 0; l < Lines; ++l)
+    {
+        auto sign = (l & 2) != 0 ? -1.f : 1.f;
+        leftLines[l] = (l & 1) == 0 ? 1.f : 0.f;
+        rightLines[l] = 1.f - leftLines[l];
+        leftTaps[l] = leftLines[l] * sign;
+        rightTaps[l] = rightLines[l] * sign;
+    }
+
+    for (size_t bit = 0; bit < butterflySigns.size(); ++bit)
+        for (size_t k = 0; k < Vec::SIMDNumElements; ++k)
+            butterflySigns[bit][k] = ((k >> bit) & 1) != 0 ? -1.f : 1.f;
+
+    std::array<Vec, numRegisters> lp, y;
+
+    for (size_t r = 0; r < numRegisters; ++r)
+        lp[r] = Vec::fromRawArray(lowpass.data() + r * Vec::size());
+
+    auto numSamples = block.getNumSamples();
+
+    for (size_t start = 0; start < numSamples;)
+    {
+        auto chunk = juce::jmin(getChunkLength(), numSamples - start);
+        auto fading = fadeRemaining > 0;
+
+        readLines<Lines>(length, delayed.data(), chunk);
+
+        if (fading)
+            readLines<Lines>(fadeFromLength, fadeDelayed.data(), chunk);
+
+        for (size_t i = 0; i < chunk; ++i)
+        {
+            auto inLeft = left[start + i];
+            auto inRight = right != nullptr ? right[start + i] : inLeft;
+
+            // 0 to 1 from the old lengths and gains to the new ones
+            auto fade = fading ? juce::jmin(1.f, static_cast<float>(fadeLength - fadeRemaining + static_cast<int>(i) + 1)
+                                                     / static_cast<float>(fadeLength))
+                               : 1.f;
+
+            auto wetLeft = Vec::expand(0.f), wetRight = Vec::expand(0.f);
+
+            for (size_t r = 0; r < numRegisters; ++r)
+            {
+                auto lane = r * Vec::size();
+                y[r] = Vec::fromRawArray(delayed.data() + i * Lines + lane);
+
+                auto g = Vec::fromRawArray(gain.data() + lane);
+
+                if (fading)
+                {
+                    auto from = Vec::fromRawArray(fadeDelayed.data() + i * Lines + lane);
+                    auto fromGain = Vec::fromRawArray(fadeFromGain.data() + lane);
+
+                    y[r] = from + (y[r] - from) * fade;
+                    g = fromGain + (g - fromGain) * fade;
+                }
+
+                wetLeft += y[r] * Vec::fromRawArray(leftTaps.data() + lane);
+                wetRight += y[r] * Vec::fromRawArray(rightTaps.data() + lane);
+
+                lp[r] = y[r] + (lp[r] - y[r]) * damping;
+                y[r] = lp[r] * g;
+            }
+
+            // fast Walsh-Hadamard transform: first between the lanes of each register...
+            for (size_t h = 1, bit = 0; h < Vec::size(); h *= 2, ++bit)
+            {
+                auto signs = Vec::fromRawArray(butterflySigns[bit].data());
+
+                for (auto& x : y)
+                    x = swapLanes(x, h) + x * signs;
+            }
+
+            // ...then between registers
+            for (size_t h = 1; h < numRegisters; h *= 2)
+            {
+                for (size_t j = 0; j < numRegisters; j += 2 * h)
+                {
+                    for (size_t k = j; k < j + h; ++k)
+                    {
+                        auto a = y[k];
+                        auto b = y[k + h];
+                        y[k] = a + b;
+                        y[k + h] = a - b;
+                    }
+                }
+            }
+
+            auto inLefts = Vec::expand(inLeft), inRights = Vec::expand(inRight);
+
+            for (size_t r = 0; r < numRegisters; ++r)
+            {
+                auto lane = r * Vec::size();
+                auto input = inLefts * Vec::fromRawArray(leftLines.data() + lane) + inRights * Vec::fromRawArray(rightLines.data() + lane);
+
+                (y[r] + input).copyToRawArray(feedback.data() + i * Lines + lane);
+            }
+
+            auto m = mix.getNextValue();
+            auto outLeft = wetLeft.sum() * outputGain;
+            auto outRight = wetRight.sum() * outputGain;
+
+            if (right != nullptr)
+            {
+                left[start + i] = inLeft + m * (outLeft - inLeft);
+                right[start + i] = inRight + m * (outRight - inRight);
+            }
+            else
+            {
+                left[start + i] = inLeft + m * (0.5f * (outLeft + outRight) - inLeft);
+            }
+        }
+
+        writeLines<Lines>(chunk);
+        start += chunk;
+
+        if (fading)
+        {
+            fadeRemaining = juce::jmax(0, fadeRemaining - static_cast<int>(chunk));
+
+            if (fadeRemaining == 0 && sizePending)
+                startSizeFade();
+        }
+    }
+
+    for (size_t r = 0; r < numRegisters; ++r)
+        lp[r].copyToRawArray(lowpass.data() + r * Vec::size());
+}
+
+template<typename Register>
+Register ReverbEngine::swapLanes(Register x, size_t h) noexcept
+{
+    // Register is only ever Vec; as a template parameter it keeps the native shuffles below from
+    // being checked against a register type they weren't written for
+    using Vec = Register;
+    jassert(juce::isPowerOfTwo(h) && h < Vec::size());
+
+   #if JUCE_USE_SSE_INTRINSICS
+    if constexpr (Vec::SIMDNumElements == 4)
+    {
+        return Vec::fromNative(h == 1 ? _mm_shuffle_ps(x.value, x.value, _MM_SHUFFLE(2, 3, 0, 1))
+                                      : _mm_shuffle_ps(x.value, x.value, _MM_SHUFFLE(1, 0, 3, 2)));
+    }
+    #if defined(__AVX2__)
+    else if constexpr (Vec::SIMDNumElements == 8)
+    {
+        if (h == 4)
+            return Vec::fromNative(_mm256_permute2f128_ps(x.value, x.value, 0x01));
+
+        return Vec::fromNative(h == 1 ? _mm256_permute_ps(x.value, _MM_SHUFFLE(2, 3, 0, 1))
+                                      : _mm256_permute_ps(x.value, _MM_SHUFFLE(1, 0, 3, 2)));
+    }
+    #endif
+    else
+   #elif JUCE_USE_ARM_NEON
+    if constexpr (Vec::SIMDNumElements == 4)
+    {
+        return Vec::fromNative(h == 1 ? vrev64q_f32(x.value) : vextq_f32(x.value, x.value, 2));
+    }
+    else
+   #endif
+    {
+        // anything else goes through memory
+        alignas(Vec::SIMDRegisterSize) std::array<float, Vec::SIMDNumElements> lanes, swapped;
+        x.copyToRawArray(lanes.data());
+
+        for (size_t k = 0; k < lanes.size(); ++k)
+            swapped[k] = lanes[k ^ h];
+
+        return Vec::fromRawArray(swapped.data());
+    }
+}
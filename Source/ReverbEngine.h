@@ -0,0 +1,119 @@
+/*
+  ==============================================================================
+
+    ReverbEngine.h
+
+    Stereo feedback delay network reverb.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+    8 or 16 delay lines (see setNumLines) in a loop:
+
+        read every line -> damping lowpass -> decay gain -> Hadamard -> + input -> write
+
+    - each line is its own run of capacity samples in one buffer allocated
+      by prepare(), [line][sample]. Every line is at least shortestLineMs
+      long, so a chunk of up to chunkSize samples never reads what it
+      writes: each line's reads for a chunk are one contiguous run, copied
+      into a [sample][line] scratch in L1, and its writes go back the same
+      way. Reading every line at its own offset out of an interleaved
+      buffer touched a cache line per line per sample instead
+    - the per-line filter / gain / matrix work runs on SIMDRegisters, the
+      lines spread over the lanes
+    - the Hadamard matrix is applied as a fast Walsh-Hadamard transform,
+      log2(Lines) stages of butterflies, scaled by 1 / sqrt(Lines) so the loop
+      is lossless before the decay gains. Butterflies between lines in
+      different registers are a register add and subtract; between lanes of
+      one register a lane swap and a multiply-add with a sign per lane
+    - line lengths are primes spread geometrically over 23 to 97 ms at size
+      1, scaled by setSize(); each line's gain gives it the same RT60. A size
+      change crossfades from the old lengths and gains to the new ones over
+      sizeFadeSeconds; a change during a fade is picked up when it ends
+    - the left input feeds the even lines and the right the odd ones, and the
+      outputs are taken the same way, so a stereo source stays wide
+*/
+class ReverbEngine : public juce::dsp::ProcessorBase
+{
+public:
+    static constexpr size_t maxChannels = 2;
+    static constexpr size_t maxLines = 16;
+
+    static constexpr float minSizeScale = 0.3f;
+    static constexpr float maxSizeScale = 1.5f;
+    static constexpr double maxDecaySeconds = 10.0;
+    static constexpr double sizeFadeSeconds = 0.05;
+
+    void prepare(const juce::dsp::ProcessSpec& spec) override;
+    void process(const juce::dsp::ProcessContextReplacing<float>& context) override;
+    void reset() override;
+
+    // frees what prepare() allocated; prepare() again before the next process()
+    void releaseResources();
+
+    // 8 or 16; a change clears the tail
+    void setNumLines(size_t newNumLines) noexcept;
+
+    void setSize(float newSize) noexcept;               // 0 to 1
+    void setDecay(float newDecaySeconds) noexcept;      // RT60
+    void setDamping(float newDampingHz) noexcept;
+    void setMix(float newMix) noexcept { mix.setTargetValue(newMix); }
+
+private:
+    using Vec = juce::dsp::SIMDRegister<float>;
+
+    static constexpr size_t chunkSize = 32;
+
+    template<size_t Lines>
+    void processLines(const juce::dsp::AudioBlock<float>& block) noexcept;
+
+    // the next chunk's reads of every line at the given lengths, [sample][line]
+    template<size_t Lines>
+    void readLines(const std::array<int, maxLines>& lengths, float* destination, size_t numSamples) const noexcept;
+
+    template<size_t Lines>
+    void writeLines(size_t numSamples) noexcept;
+
+    // the longest chunk that reads nothing it writes
+    size_t getChunkLength() const noexcept;
+
+    // lane k gets lane k ^ h, for h a power of two below the register size
+    template<typename Register>
+    static Register swapLanes(Register x, size_t h) noexcept;
+
+    void updateLengths() noexcept;
+    void updateGains() noexcept;
+    void startSizeFade() noexcept;
+
+    static int nextPrime(int n) noexcept;
+
+    double sampleRate = 44100.0;
+
+    size_t numLines = maxLines;
+    float size = 0.5f, decaySeconds = 2.f, dampingHz = 6000.f;
+
+    // [line][sample], capacity samples for each of maxLines lines
+    std::vector<float> lines;
+    int capacity = 0, mask = 0, writePos = 0;
+
+    std::array<int, maxLines> length{};
+    alignas(Vec::SIMDRegisterSize) std::array<float, maxLines> gain{}, lowpass{};
+    float damping = 0.f;
+
+    // a size change in progress: what it fades from, and how far it has to go
+    std::array<int, maxLines> fadeFromLength{};
+    alignas(Vec::SIMDRegisterSize) std::array<float, maxLines> fadeFromGain{};
+    int fadeLength = 1, fadeRemaining = 0;
+    bool sizePending = false;
+
+    // one chunk, [sample][line]: the lines' outputs, at the old lengths while fading, and their new inputs
+    alignas(Vec::SIMDRegisterSize) std::array<float, chunkSize * maxLines> delayed{}, fadeDelayed{}, feedback{};
+
+    juce::SmoothedValue<float> mix;
+    bool wasBypassed = false;
+};
@@ -0,0 +1,159 @@
+/*
+  ==============================================================================
+
+    SharedTables.cpp
+
+  ==============================================================================
+*/
+
+#include "SharedTables.h"
+
+namespace
+{
+    struct Cache
+    {
+        struct Entry
+        {
+            std::weak_ptr<const RateTables> tables;
+
+            // while a build is in flight, everyone who asked for the rate since it started
+            bool building = false;
+            std::vector<std::function<void(std::shared_ptr<const RateTables>)>> waiters;
+        };
+
+        std::mutex lock;
+        std::map<double, Entry> entries;
+    };
+
+    Cache& getCache()
+    {
+        static Cache cache;
+        return cache;
+    }
+}
+
+const juce::dsp::LookupTableTransform<float>& SharedTables::getSaturationTable()
+{
+    static const juce::dsp::LookupTableTransform<float> table{ [](float x) { return std::tanh(x); }, -5.f, 5.f, 128 };
+    return table;
+}
+
+int SharedTables::getNumLiveRateTables()
+{
+    auto& cache = getCache();
+    std::scoped_lock sl(cache.lock);
+
+    return static_cast<int>(std::count_if(cache.entries.begin(), cache.entries.end(),
+        [](const auto& entry) { return ! entry.second.tables.expired(); }));
+}
+
+std::shared_ptr<const RateTables> SharedTables::findOrWait(double sampleRate, Waiter whenBuilt)
+{
+    auto& cache = getCache();
+    std::scoped_lock sl(cache.lock);
+
+    auto& entry = cache.entries[sampleRate];
+
+    if (auto live = entry.tables.lock())
+        return live;
+
+    entry.waiters.push_back(std::move(whenBuilt));
+
+    if (! entry.building)
+    {
+        entry.building = true;
+        juce::Thread::launch([sampleRate] { buildInBackground(sampleRate); });
+    }
+
+    return nullptr;
+}
+
+void SharedTables::buildInBackground(double sampleRate)
+{
+    std::shared_ptr<const RateTables> built = build(sampleRate);
+    std::vector<Waiter> waiters;
+
+    {
+        auto& cache = getCache();
+        std::scoped_lock sl(cache.lock);
+
+        auto& entry = cache.entries[sampleRate];
+        entry.tables = built;
+        entry.building = false;
+        std::swap(waiters, entry.waiters);
+
+        // drop entries for rates nobody uses any more
+        for (auto it = cache.entries.begin(); it != cache.entries.end();)
+            it = it->second.tables.expired() && ! it->second.building ? cache.entries.erase(it) : std::next(it);
+    }
+
+    // outside the cache lock: each waiter takes its subscription's lock
+    for (auto& waiter : waiters)
+        waiter(built);
+}
+
+std::unique_ptr<RateTables> SharedTables::build(double sampleRate)
+{
+    auto tables = std::make_unique<RateTables>();
+
+    auto& grid = tables->phaserAllpass;
+    grid.sampleRate = sampleRate;
+    grid.maxFrequency = static_cast<float>(juce::jmin(20000.0, 0.49 * sampleRate));
+
+    for (size_t i = 0; i <= static_cast<size_t>(AllpassCoefficientGrid::size); ++i)
+    {
+        auto normFrequency = static_cast<double>(i) / AllpassCoefficientGrid::size;
+        auto frequency = 20.0 * std::pow(grid.maxFrequency / 20.0, normFrequency);
+        auto g = std::tan(juce::MathConstants<double>::pi * frequency / sampleRate);
+
+        grid.coefficients[i] = static_cast<float>(g / (1.0 + g));
+    }
+
+    grid.coefficients.back() = grid.coefficients[AllpassCoefficientGrid::size];
+
+    auto& trig = tables->biquadTrig;
+    trig.sampleRate = sampleRate;
+    trig.maxFrequency = 0.49 * sampleRate;
+    trig.pointsPerLogUnit = BiquadTrigGrid::size / std::log(trig.maxFrequency / BiquadTrigGrid::minFrequency);
+
+    for (size_t i = 0; i <= static_cast<size_t>(BiquadTrigGrid::size); ++i)
+    {
+        auto frequency = BiquadTrigGrid::minFrequency * std::exp(static_cast<double>(i) / trig.pointsPerLogUnit);
+        auto omega = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+
+        trig.sinOmega[i] = static_cast<float>(std::sin(omega));
+        trig.oneMinusCosOmega[i] = static_cast<float>(2.0 * juce::square(std::sin(omega * 0.5)));
+        trig.cotHalfOmega[i] = static_cast<float>(1.0 / std::tan(omega * 0.5));
+    }
+
+    trig.sinOmega.back() = trig.sinOmega[BiquadTrigGrid::size];
+    trig.oneMinusCosOmega.back() = trig.oneMinusCosOmega[BiquadTrigGrid::size];
+    trig.cotHalfOmega.back() = trig.cotHalfOmega[BiquadTrigGrid::size];
+
+    return tables;
+}
+
+void SharedTables::Subscription::request(double sampleRate)
+{
+    std::scoped_lock sl(state->lock);
+    auto generation = ++state->generation;
+
+    // same rate as another instance (or a previous prepare): no wait at all. Otherwise
+    // published stays nullptr until the rate's build, this instance's or another's, is done
+    state->owner = findOrWait(sampleRate, [weakState = std::weak_ptr<State>(state), generation](std::shared_ptr<const RateTables> tables)
+        {
+            if (auto s = weakState.lock())
+            {
+                std::scoped_lock sl(s->lock);
+
+                // a later request() for another rate makes this one stale
+                if (s->generation == generation)
+                {
+                    s->owner = std::move(tables);
+                    s->published.store(s->owner.get(), std::memory_order_release);
+                }
+            }
+        });
+
+    state->published.store(state->owner.get(), std::memory_order_release);
+}
@@ -0,0 +1,155 @@
+/*
+  ==============================================================================
+
+    SharedTables.h
+
+    Read-only DSP tables shared by every plugin instance in the process.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+    Phaser allpass coefficient G = g / (1 + g), g = tan(pi f / fs), over the
+    normalised log sweep the phaser uses (20 Hz to maxFrequency), so a control
+    update is one lookup instead of a pow and a tan.
+*/
+struct AllpassCoefficientGrid
+{
+    static constexpr int size = 2048;
+
+    double sampleRate = 0.0;
+    float maxFrequency = 0.f;
+
+    // the end point plus a guard so lookups at 1.0 don't read past
+    std::array<float, size + 2> coefficients{};
+
+    float lookup(float normFrequency) const noexcept
+    {
+        auto pos = juce::jlimit(0.f, 1.f, normFrequency) * static_cast<float>(size);
+        auto index = static_cast<int>(pos);
+        auto frac = pos - static_cast<float>(index);
+
+        auto a = coefficients[static_cast<size_t>(index)];
+        auto b = coefficients[static_cast<size_t>(index + 1)];
+        return a + frac * (b - a);
+    }
+};
+
+/*
+    The trigonometry of the general filter's biquads (the formulas of
+    juce::dsp::IIR::Coefficients), over a log frequency grid from 10 Hz to
+    0.49 fs, the range MultiBandFilter clamps to. A coefficient update is a
+    log and three lookups instead of a sin and a cos, or a tan.
+
+    The grid holds the forms that interpolate well on a log axis rather than
+    cos and tan themselves: 1 - cos w, which is what sets a low peak's shape
+    and which cos near 1 would lose, and cot(w / 2), the n of the band-pass,
+    notch and all-pass formulas, which goes smoothly to 0 at Nyquist where
+    tan blows up. Linear interpolation over 4096 points is then within about
+    3e-5 of the exact values, relative, at 44.1 to 192 kHz.
+*/
+struct BiquadTrigGrid
+{
+    static constexpr int size = 4096;
+    static constexpr double minFrequency = 10.0;
+
+    double sampleRate = 0.0;
+    double maxFrequency = 0.0;
+
+    // size / log(maxFrequency / minFrequency)
+    double pointsPerLogUnit = 0.0;
+
+    struct Values
+    {
+        double sinOmega, oneMinusCosOmega, cotHalfOmega;
+    };
+
+    // the end point plus a guard so lookups at maxFrequency don't read past
+    std::array<float, size + 2> sinOmega{}, oneMinusCosOmega{}, cotHalfOmega{};
+
+    Values lookup(double frequency) const noexcept
+    {
+        auto pos = juce::jlimit(0.0, static_cast<double>(size), std::log(frequency / minFrequency) * pointsPerLogUnit);
+        auto index = static_cast<size_t>(pos);
+        auto frac = pos - static_cast<double>(index);
+
+        auto interpolate = [index, frac](const auto& table)
+            {
+                auto a = static_cast<double>(table[index]);
+                return a + frac * (static_cast<double>(table[index + 1]) - a);
+            };
+
+        return { interpolate(sinOmega), interpolate(oneMinusCosOmega), interpolate(cotHalfOmega) };
+    }
+};
+
+// everything that depends on the sample rate
+struct RateTables
+{
+    AllpassCoefficientGrid phaserAllpass;
+    BiquadTrigGrid biquadTrig;
+};
+
+/*
+    Sample-rate independent tables (the SineTable wavetable, the saturation
+    table) are function statics, built once per process on first use.
+
+    Per sample rate tables are built on a background thread the first time an
+    instance asks for that rate, then kept alive by reference count for as
+    long as any instance uses them; instances at the same rate share one copy.
+    The build in flight for a rate is registered in the cache, so instances
+    asking for that rate meanwhile wait for it rather than start their own:
+    a session loading 100 instances at once builds each rate's tables once,
+    on one thread.
+*/
+class SharedTables
+{
+public:
+    // tanh over [-5, 5], 128 points, same as juce::dsp::LadderFilter's saturationLUT
+    static const juce::dsp::LookupTableTransform<float>& getSaturationTable();
+
+    // how many sample rates currently have tables alive in the process
+    static int getNumLiveRateTables();
+
+    /*
+        One per instance. request() from prepareToPlay (never the audio thread);
+        get() on the audio thread returns nullptr until the tables for the
+        requested rate are ready, then stays valid until the next request().
+    */
+    class Subscription
+    {
+    public:
+        Subscription() = default;
+
+        void request(double sampleRate);
+
+        const RateTables* get() const noexcept { return state->published.load(std::memory_order_acquire); }
+
+    private:
+        struct State
+        {
+            std::mutex lock;
+            std::shared_ptr<const RateTables> owner;
+            std::atomic<const RateTables*> published{ nullptr };
+            int generation = 0;
+        };
+
+        // shared with the builder thread, which may finish after the instance is gone
+        std::shared_ptr<State> state = std::make_shared<State>();
+
+        JUCE_DECLARE_NON_COPYABLE(Subscription)
+    };
+
+private:
+    using Waiter = std::function<void(std::shared_ptr<const RateTables>)>;
+
+    // the live tables for the rate; or nullptr, with whenBuilt queued on the rate's build,
+    // which is started if there isn't one in flight
+    static std::shared_ptr<const RateTables> findOrWait(double sampleRate, Waiter whenBuilt);
+    static void buildInBackground(double sampleRate);
+    static std::unique_ptr<RateTables> build(double sampleRate);
+};
@@ -0,0 +1,50 @@
+/*
+  ==============================================================================
+
+    SineTable.h
+
+    Wavetable sine used by the modulation sources.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+struct SineTable
+{
+    static constexpr int size = 2048;
+
+    // sin(2 pi * phase) for phase in [0, 1], linearly interpolated (error < 2e-6)
+    static float lookup(float phase) noexcept
+    {
+        auto& table = get();
+        auto pos = phase * static_cast<float>(size);
+        auto index = static_cast<int>(pos);
+        auto frac = pos - static_cast<float>(index);
+
+        // a phase just below 1 in double rounds to 1.f, which is the start of the next period
+        index &= size - 1;
+
+        auto a = table[static_cast<size_t>(index)];
+        auto b = table[static_cast<size_t>(index + 1)];
+        return a + frac * (b - a);
+    }
+
+    // one period plus a guard point so lookups never wrap
+    static const std::array<float, size + 1>& get()
+    {
+        static const auto table = []
+            {
+                std::array<float, size + 1> t{};
+
+                for (size_t i = 0; i < t.size(); ++i)
+                    t[i] = static_cast<float>(std::sin(juce::MathConstants<double>::twoPi * static_cast<double>(i) / size));
+
+                return t;
+            }();
+
+        return table;
+    }
+};
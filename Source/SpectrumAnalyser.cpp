@@ -0,0 +1,242 @@
+/*
+  ==============================================================================
+
+    SpectrumAnalyser.cpp
+
+  ==============================================================================
+*/
+
+#include "SpectrumAnalyser.h"
+
+SpectrumAnalyser::SpectrumAnalyser() : juce::Thread("Spectrum Analyser")
+{
+}
+
+SpectrumAnalyser::~SpectrumAnalyser()
+{
+    stopThread(1000);
+}
+
+void SpectrumAnalyser::prepare(double sampleRate)
+{
+    currentSampleRate = sampleRate;
+    needsFlush = true;
+}
+
+void SpectrumAnalyser::pushSamples(Tap tap, const juce::dsp::AudioBlock<float>& block) noexcept
+{
+    // acquire: the buffers were allocated before the first activation
+    if (! active.load(std::memory_order_acquire) || block.getNumChannels() == 0)
+        return;
+
+    auto& t = taps[tap];
+    auto numChannels = block.getNumChannels();
+    auto numToWrite = juce::jmin(static_cast<int>(block.getNumSamples()), t.fifo.getFreeSpace());
+
+    // if the analyser thread fell behind, newer samples are simply dropped
+    auto scope = t.fifo.write(numToWrite);
+    auto gain = 1.f / static_cast<float>(numChannels);
+
+    auto copy = [&](int start, int size, int offset)
+        {
+            if (size <= 0)
+                return;
+
+            auto* dest = t.ring.data() + start;
+
+            juce::FloatVectorOperations::copyWithMultiply(dest, block.getChannelPointer(0) + offset, gain, size);
+
+            for (size_t ch = 1; ch < numChannels; ++ch)
+                juce::FloatVectorOperations::addWithMultiply(dest, block.getChannelPointer(ch) + offset, gain, size);
+        };
+
+    copy(scope.startIndex1, scope.blockSize1, 0);
+    copy(scope.startIndex2, scope.blockSize2, scope.blockSize1);
+}
+
+void SpectrumAnalyser::configure(int newFFTOrder, int overlapFactor)
+{
+    jassert(! isThreadRunning() || juce::MessageManager::existsAndIsCurrentThread());
+
+    fftOrder = juce::jlimit(minFFTOrder, maxFFTOrder, newFFTOrder);
+    overlap = juce::jlimit(1, 16, overlapFactor);
+
+    // nothing is allocated until an editor first shows
+    if (! isAllocated())
+        return;
+
+    auto wasRunning = isThreadRunning();
+    stopThread(1000);
+
+    allocateAnalysis();
+    needsFlush = true;
+
+    if (wasRunning)
+        startThread(juce::Thread::Priority::low);
+}
+
+void SpectrumAnalyser::allocateAnalysis()
+{
+    auto fftSize = static_cast<size_t>(1 << fftOrder);
+
+    fft = std::make_unique<juce::dsp::FFT>(fftOrder);
+    window = std::make_unique<juce::dsp::WindowingFunction<float>>(fftSize, juce::dsp::WindowingFunction<float>::hann);
+
+    for (auto& t : taps)
+    {
+        t.history.assign(fftSize, 0.f);
+        t.fftData.assign(fftSize * 2, 0.f);
+        t.smoothed.assign(fftSize / 2 + 1, minDecibels);
+        t.samplesSinceLastFFT = 0;
+    }
+}
+
+void SpectrumAnalyser::setActive(bool shouldBeActive)
+{
+    // a session can hold hundreds of instances whose editor is never opened, so the
+    // ring, FFT and paths wait for the first one; the audio thread can't see them yet
+    if (shouldBeActive && ! isAllocated())
+    {
+        for (auto& t : taps)
+        {
+            t.ring.resize(static_cast<size_t>(ringSize), 0.f);
+
+            t.path.forEachBuffer([](juce::Path& path)
+                {
+                    path.preallocateSpace(3 * (numPathPoints + 1));
+                });
+        }
+
+        allocateAnalysis();
+    }
+
+    if (active.exchange(shouldBeActive) == shouldBeActive)
+        return;
+
+    if (shouldBeActive)
+    {
+        needsFlush = true;
+
+        if (! isThreadRunning())
+            startThread(juce::Thread::Priority::low);
+        else
+            notify();
+    }
+}
+
+void SpectrumAnalyser::run()
+{
+    while (! threadShouldExit())
+    {
+        if (! active.load())
+        {
+            wait(-1);
+            continue;
+        }
+
+        if (needsFlush.exchange(false))
+        {
+            // drop whatever is left over from before the editor was hidden
+            // or the sample rate changed, and rebuild the frequency mapping
+            for (auto& t : taps)
+            {
+                t.fifo.finishedRead(t.fifo.getNumReady());
+                std::fill(t.history.begin(), t.history.end(), 0.f);
+                std::fill(t.smoothed.begin(), t.smoothed.end(), minDecibels);
+                t.samplesSinceLastFFT = 0;
+            }
+
+            auto fftSize = 1 << fftOrder;
+            auto binWidth = currentSampleRate.load() / fftSize;
+
+            for (int i = 0; i < numPathPoints; ++i)
+            {
+                auto freq = 20.0 * std::pow(1000.0, i / static_cast<double>(numPathPoints - 1));
+                pathBins[static_cast<size_t>(i)] = juce::jlimit(0, fftSize / 2, static_cast<int>(freq / binWidth));
+            }
+        }
+
+        auto didWork = false;
+
+        for (int tap = 0; tap < NumTaps; ++tap)
+        {
+            auto& t = taps[static_cast<size_t>(tap)];
+            auto fftSize = static_cast<int>(t.history.size());
+            auto hopSize = fftSize / overlap;
+
+            while (t.fifo.getNumReady() > 0)
+            {
+                auto numToRead = juce::jmin(t.fifo.getNumReady(), hopSize - t.samplesSinceLastFFT);
+                auto scope = t.fifo.read(numToRead);
+
+                // slide the analysis window and append the new samples
+                auto* history = t.history.data();
+                std::memmove(history, history + numToRead, sizeof(float) * static_cast<size_t>(fftSize - numToRead));
+
+                auto* dest = history + fftSize - numToRead;
+                std::copy_n(t.ring.data() + scope.startIndex1, scope.blockSize1, dest);
+                std::copy_n(t.ring.data() + scope.startIndex2, scope.blockSize2, dest + scope.blockSize1);
+
+                t.samplesSinceLastFFT += numToRead;
+
+                if (t.samplesSinceLastFFT >= hopSize)
+                {
+                    t.samplesSinceLastFFT = 0;
+                    analyse(tap);
+                    didWork = true;
+                }
+            }
+        }
+
+        if (! didWork)
+            wait(10);
+    }
+}
+
+void SpectrumAnalyser::analyse(int tap)
+{
+    auto& t = taps[static_cast<size_t>(tap)];
+    auto fftSize = static_cast<int>(t.history.size());
+
+    std::copy(t.history.begin(), t.history.end(), t.fftData.begin());
+    window->multiplyWithWindowingTable(t.fftData.data(), static_cast<size_t>(fftSize));
+    fft->performFrequencyOnlyForwardTransform(t.fftData.data(), true);
+
+    // hann window coherent gain is 0.5, so full scale sine -> 0 dB
+    auto normalise = 4.f / static_cast<float>(fftSize);
+
+    // fast attack, slow release so the display doesn't flicker
+    auto releaseCoefficient = 1.f - std::exp(-static_cast<float>(overlap) / 16.f);
+
+    for (size_t bin = 0; bin < t.smoothed.size(); ++bin)
+    {
+        auto db = juce::Decibels::gainToDecibels(t.fftData[bin] * normalise, minDecibels);
+        auto& s = t.smoothed[bin];
+        s = db > s ? db : s + (db - s) * releaseCoefficient;
+    }
+
+    auto& path = t.path.getWriteBuffer();
+    path.clear();
+
+    auto toY = [](float db) { return juce::jmap(db, 0.f, minDecibels, 0.f, 1.f); };
+
+    for (int i = 0; i < numPathPoints; ++i)
+    {
+        auto first = pathBins[static_cast<size_t>(i)];
+        auto last = i + 1 < numPathPoints ? pathBins[static_cast<size_t>(i + 1)] : first + 1;
+
+        auto db = t.smoothed[static_cast<size_t>(first)];
+
+        for (auto bin = first + 1; bin < last; ++bin)
+            db = juce::jmax(db, t.smoothed[static_cast<size_t>(bin)]);
+
+        auto x = static_cast<float>(i) / static_cast<float>(numPathPoints - 1);
+
+        if (i == 0)
+            path.startNewSubPath(x, toY(db));
+        else
+            path.lineTo(x, toY(db));
+    }
+
+    t.path.publish();
+}
@@ -0,0 +1,89 @@
+/*
+  ==============================================================================
+
+    SpectrumAnalyser.h
+
+    Input / output spectrum for the editor.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "TripleBuffer.h"
+
+/*
+    The audio thread only copies (mono-summed) samples into a lock-free ring
+    buffer per tap. A background thread runs a windowed juce::dsp::FFT with
+    the configured size and overlap, smooths the magnitudes and renders them
+    into a preallocated path in normalised coordinates (x: 0..1 log frequency,
+    y: 0 = 0 dB .. 1 = minDecibels) that the editor scales to its bounds.
+
+    While no editor is showing, pushSamples() returns straight away and the
+    thread sleeps. Until an editor first becomes visible the thread isn't
+    started and none of the buffers are allocated.
+*/
+class SpectrumAnalyser : private juce::Thread
+{
+public:
+    enum Tap
+    {
+        Input,
+        Output,
+        NumTaps
+    };
+
+    static constexpr int minFFTOrder = 9;
+    static constexpr int maxFFTOrder = 14;
+    static constexpr int numPathPoints = 256;
+    static constexpr float minDecibels = -96.f;
+
+    SpectrumAnalyser();
+    ~SpectrumAnalyser() override;
+
+    // audio thread
+    void prepare(double sampleRate);
+    void pushSamples(Tap tap, const juce::dsp::AudioBlock<float>& block) noexcept;
+
+    // message thread
+    void configure(int fftOrder, int overlapFactor);
+    void setActive(bool shouldBeActive);
+
+    TripleBuffer<juce::Path>& getPath(Tap tap) noexcept { return taps[tap].path; }
+
+private:
+    void run() override;
+    void analyse(int tap);
+
+    bool isAllocated() const noexcept { return ! taps[0].ring.empty(); }
+    void allocateAnalysis();
+
+    struct TapState
+    {
+        juce::AbstractFifo fifo{ ringSize };
+        std::vector<float> ring;
+        std::vector<float> history;
+        std::vector<float> fftData;
+        std::vector<float> smoothed;
+        int samplesSinceLastFFT = 0;
+        TripleBuffer<juce::Path> path;
+    };
+
+    static constexpr int ringSize = 1 << (maxFFTOrder + 1);
+
+    std::array<TapState, NumTaps> taps;
+
+    std::unique_ptr<juce::dsp::FFT> fft;
+    std::unique_ptr<juce::dsp::WindowingFunction<float>> window;
+    std::array<int, numPathPoints> pathBins{};
+
+    int fftOrder = 11;
+    int overlap = 4;
+
+    std::atomic<double> currentSampleRate{ 44100.0 };
+    std::atomic<bool> active{ false };
+    std::atomic<bool> needsFlush{ true };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrumAnalyser)
+};
@@ -0,0 +1,250 @@
+/*
+  ==============================================================================
+
+    StageLoader.cpp
+
+  ==============================================================================
+*/
+
+#include "StageLoader.h"
+
+// one thread for every instance in the process: a big session asks for a handful of stages at a time
+class StageLoader::Worker : private juce::Thread
+{
+public:
+    Worker() : juce::Thread("Stage loader")
+    {
+        startThread(juce::Thread::Priority::low);
+    }
+
+    ~Worker() override
+    {
+        signalThreadShouldExit();
+        notify();
+        stopThread(-1);
+    }
+
+    void add(StageLoader& loader)
+    {
+        std::scoped_lock sl(lock);
+        loaders.push_back(&loader);
+    }
+
+    // waits for the loader's stages to be finished with if they are being serviced
+    void remove(StageLoader& loader)
+    {
+        std::scoped_lock sl(lock);
+        loaders.erase(std::remove(loaders.begin(), loaders.end(), &loader), loaders.end());
+    }
+
+    void wake() const { notify(); }
+
+private:
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            wait(-1);
+
+            std::scoped_lock sl(lock);
+
+            for (auto* loader : loaders)
+                loader->service();
+        }
+    }
+
+    std::mutex lock;
+    std::vector<StageLoader*> loaders;
+};
+
+StageLoader::StageLoader()
+{
+    worker->add(*this);
+}
+
+StageLoader::~StageLoader()
+{
+    worker->remove(*this);
+}
+
+void StageLoader::add(size_t id, juce::dsp::ProcessorBase& processor, std::function<void()> release)
+{
+    jassert(id < maxStages && stages[id].processor == nullptr);
+
+    stages[id].processor = &processor;
+    stages[id].release = std::move(release);
+}
+
+void StageLoader::prepare(const juce::dsp::ProcessSpec& newSpec, const std::function<bool(size_t)>& isWanted)
+{
+    std::scoped_lock sl(serviceLock);
+
+    spec = newSpec;
+    fadeInLength = juce::jmax(1, juce::roundToInt(fadeInSeconds * spec.sampleRate));
+
+    for (size_t id = 0; id < maxStages; ++id)
+    {
+        auto& stage = stages[id];
+
+        if (stage.processor == nullptr)
+            continue;
+
+        stage.fadeInRemaining = 0;
+        stage.unusedSeconds = 0.0;
+
+        if (isWanted(id))
+        {
+            prepareStage(stage);
+            stage.state.store(Ready, std::memory_order_release);
+            stage.seenReady = true;
+        }
+        else
+        {
+            if (stage.state.load(std::memory_order_acquire) != Unprepared)
+                releaseStage(stage);
+
+            stage.state.store(Unprepared, std::memory_order_release);
+            stage.seenReady = false;
+        }
+    }
+}
+
+void StageLoader::reset()
+{
+    std::scoped_lock sl(serviceLock);
+
+    for (auto& stage : stages)
+    {
+        auto state = stage.state.load(std::memory_order_acquire);
+
+        if (state == Ready || state == ReleaseRequested)
+            stage.processor->reset();
+
+        stage.fadeInRemaining = 0;
+    }
+}
+
+bool StageLoader::update(size_t id, bool wanted, int numSamples)
+{
+    jassert(id < maxStages);
+
+    auto& stage = stages[id];
+
+    if (stage.processor == nullptr)
+        return false;
+
+    stage.unusedSeconds = wanted ? 0.0 : stage.unusedSeconds + numSamples / spec.sampleRate;
+
+    auto state = stage.state.load(std::memory_order_acquire);
+    auto preparedHere = false;
+
+    if (wanted && state == ReleaseRequested)
+    {
+        // still there if the loader thread hasn't got to it yet
+        if (stage.state.compare_exchange_strong(state, Ready, std::memory_order_acq_rel))
+            state = Ready;
+    }
+
+    if (wanted && state != Ready && synchronous)
+    {
+        // offline: no deadline, and the render mustn't depend on how fast the loader thread was
+        std::scoped_lock sl(serviceLock);
+        state = stage.state.load(std::memory_order_acquire);
+
+        if (state == ReleaseRequested)
+        {
+            stage.state.store(Ready, std::memory_order_release);
+        }
+        else if (state != Ready)
+        {
+            prepareStage(stage);
+            stage.state.store(Ready, std::memory_order_release);
+            preparedHere = true;
+        }
+
+        state = Ready;
+    }
+    else if (wanted && state == Unprepared)
+    {
+        stage.state.store(PrepareRequested, std::memory_order_release);
+        worker->wake();
+    }
+    else if (! wanted && state == Ready && ! synchronous
+             && releaseSeconds > 0.0 && stage.unusedSeconds >= releaseSeconds)
+    {
+        stage.state.store(ReleaseRequested, std::memory_order_release);
+        worker->wake();
+        state = ReleaseRequested;
+    }
+
+    auto ready = state == Ready;
+    auto newlyReady = ready && ! stage.seenReady;
+
+    stage.seenReady = ready;
+
+    if (! ready)
+        stage.fadeInRemaining = 0;
+    else if (newlyReady && ! preparedHere)
+        stage.fadeInRemaining = fadeInLength;
+
+    return newlyReady;
+}
+
+void StageLoader::advanceFadeIn(size_t id, int numSamples) noexcept
+{
+    auto& remaining = stages[id].fadeInRemaining;
+    remaining = juce::jmax(0, remaining - numSamples);
+}
+
+int StageLoader::getNumReady() const noexcept
+{
+    return static_cast<int>(std::count_if(stages.begin(), stages.end(), [](const Stage& stage)
+        {
+            return stage.state.load(std::memory_order_acquire) == Ready;
+        }));
+}
+
+void StageLoader::service()
+{
+    std::scoped_lock sl(serviceLock);
+
+    for (auto& stage : stages)
+    {
+        if (stage.processor == nullptr)
+            continue;
+
+        auto expected = static_cast<int>(PrepareRequested);
+
+        if (stage.state.compare_exchange_strong(expected, Busy, std::memory_order_acq_rel))
+        {
+            auto start = juce::Time::getMillisecondCounterHiRes();
+            prepareStage(stage);
+
+            backgroundPrepareMs.store(backgroundPrepareMs.load(std::memory_order_relaxed)
+                + juce::Time::getMillisecondCounterHiRes() - start, std::memory_order_relaxed);
+
+            stage.state.store(Ready, std::memory_order_release);
+            continue;
+        }
+
+        expected = ReleaseRequested;
+
+        if (stage.state.compare_exchange_strong(expected, Busy, std::memory_order_acq_rel))
+        {
+            releaseStage(stage);
+            stage.state.store(Unprepared, std::memory_order_release);
+        }
+    }
+}
+
+void StageLoader::prepareStage(Stage& stage)
+{
+    stage.processor->prepare(spec);
+    stage.processor->reset();
+}
+
+void StageLoader::releaseStage(Stage& stage)
+{
+    if (stage.release)
+        stage.release();
+}
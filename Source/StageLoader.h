@@ -0,0 +1,110 @@
+/*
+  ==============================================================================
+
+    StageLoader.h
+
+    Prepares the processor's stages off the audio thread when the chain
+    first needs them, and frees the ones it has stopped using.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+    Each stage is registered once with an id (the processor uses the
+    DSP_Option) and is in one of four states:
+
+        Unprepared -> PrepareRequested -> Ready -> ReleaseRequested -> Unprepared
+
+    prepare() (prepareToPlay) prepares the stages wanted right now in place
+    and leaves the rest unprepared, so its cost follows what the chain uses,
+    not what the plugin contains. From then on the audio thread calls
+    update() once per block: a stage that becomes wanted is handed to one
+    process-wide loader thread, and one left unwanted for longer than the
+    release time is handed back to it to free its memory.
+
+    Only a Ready stage may be touched by the audio thread - processed, reset,
+    or have its parameters set. A stage that turns Ready on the loader thread
+    fades in from the dry signal over fadeInSeconds; stages prepared
+    synchronously (prepare(), or update() while rendering offline, which
+    keeps renders deterministic) don't.
+*/
+class StageLoader
+{
+public:
+    static constexpr size_t maxStages = 8;
+    static constexpr double fadeInSeconds = 0.02;
+
+    StageLoader();
+    ~StageLoader();
+
+    // message thread, before the first prepare(). release frees whatever prepare() allocated
+    void add(size_t id, juce::dsp::ProcessorBase& processor, std::function<void()> release = {});
+
+    // message thread, never while the audio thread is processing
+    void prepare(const juce::dsp::ProcessSpec& spec, const std::function<bool(size_t)>& isWanted);
+    void reset();
+
+    // audio thread: 0 never frees anything
+    void setReleaseTime(double seconds) noexcept { releaseSeconds = seconds; }
+
+    // audio thread: prepare whatever is wanted right here instead of in the background
+    void setSynchronous(bool shouldBeSynchronous) noexcept { synchronous = shouldBeSynchronous; }
+
+    // audio thread, once per block for every stage; returns true if it has just become Ready
+    bool update(size_t id, bool wanted, int numSamples);
+
+    bool isReady(size_t id) const noexcept { return stages[id].state.load(std::memory_order_acquire) == Ready; }
+
+    // audio thread: samples of fade-in left for a stage that has just turned Ready
+    int getFadeInRemaining(size_t id) const noexcept { return stages[id].fadeInRemaining; }
+    int getFadeInLength() const noexcept { return fadeInLength; }
+    void advanceFadeIn(size_t id, int numSamples) noexcept;
+
+    // any thread
+    int getNumReady() const noexcept;
+    double getBackgroundPrepareMs() const noexcept { return backgroundPrepareMs.load(std::memory_order_relaxed); }
+
+private:
+    enum State { Unprepared, PrepareRequested, Busy, Ready, ReleaseRequested };
+
+    struct Stage
+    {
+        juce::dsp::ProcessorBase* processor = nullptr;
+        std::function<void()> release;
+        std::atomic<int> state{ Unprepared };
+
+        // audio thread only
+        bool seenReady = false;
+        int fadeInRemaining = 0;
+        double unusedSeconds = 0.0;
+    };
+
+    class Worker;
+    friend class Worker;
+
+    // loader thread, or the audio thread when synchronous
+    void service();
+    void prepareStage(Stage& stage);
+    void releaseStage(Stage& stage);
+
+    std::array<Stage, maxStages> stages;
+
+    // held while any stage is prepared, released or reset off the audio thread
+    std::mutex serviceLock;
+
+    juce::dsp::ProcessSpec spec{};
+    int fadeInLength = 1;
+
+    double releaseSeconds = 0.0;
+    bool synchronous = false;
+
+    std::atomic<double> backgroundPrepareMs{ 0.0 };
+
+    juce::SharedResourcePointer<Worker> worker;
+
+    JUCE_DECLARE_NON_COPYABLE(StageLoader)
+};
@@ -0,0 +1,176 @@
+/*
+  ==============================================================================
+
+    StagePipeline.cpp
+
+  ==============================================================================
+*/
+
+#include "StagePipeline.h"
+
+class StagePipeline::Worker : private juce::Thread
+{
+public:
+    explicit Worker(int index) : juce::Thread("Stage pipeline " + juce::String(index))
+    {
+        startThread(juce::Thread::Priority::high);
+    }
+
+    ~Worker() override
+    {
+        signalThreadShouldExit();
+        notify();
+        stopThread(-1);
+    }
+
+    // any thread: true if this worker was idle and is now the caller's
+    bool tryAcquire()
+    {
+        auto expected = false;
+        return busy.compare_exchange_strong(expected, true, std::memory_order_acquire);
+    }
+
+    // only once acquired; the worker is idle again when the group is done
+    void start(StagePipeline& p, int g)
+    {
+        pipeline = &p;
+        group = g;
+        hasWork.store(true, std::memory_order_release);
+        notify();
+    }
+
+private:
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            wait(-1);
+
+            if (hasWork.exchange(false, std::memory_order_acquire))
+            {
+                pipeline->runGroup(group);
+                busy.store(false, std::memory_order_release);
+            }
+        }
+    }
+
+    StagePipeline* pipeline = nullptr;
+    int group = 0;
+
+    std::atomic<bool> hasWork{ false }, busy{ false };
+};
+
+class StagePipeline::Pool
+{
+public:
+    Pool()
+    {
+        auto numWorkers = juce::jlimit(0, maxStages - 1, juce::SystemStats::getNumCpus() - 1);
+
+        for (int i = 0; i < numWorkers; ++i)
+            workers.push_back(std::make_unique<Worker>(i + 1));
+    }
+
+    // up to maxWorkers idle workers, which are the caller's until their groups are done
+    int acquire(int maxWorkers, std::array<Worker*, maxStages>& acquired)
+    {
+        auto numAcquired = 0;
+
+        for (auto& worker : workers)
+            if (numAcquired < maxWorkers && worker->tryAcquire())
+                acquired[static_cast<size_t>(numAcquired++)] = worker.get();
+
+        return numAcquired;
+    }
+
+private:
+    std::vector<std::unique_ptr<Worker>> workers;
+};
+
+StagePipeline::StagePipeline()
+{
+}
+
+StagePipeline::~StagePipeline()
+{
+    release();
+}
+
+void StagePipeline::prepare()
+{
+    if (! isPrepared())
+        pool = std::make_unique<juce::SharedResourcePointer<Pool>>();
+}
+
+void StagePipeline::release()
+{
+    pool.reset();
+}
+
+void StagePipeline::runStages(int numStages, int newNumItems, WorkFunction newFunction, void* newContext)
+{
+    jassert(isPrepared());
+    jassert(numStages > 0 && numStages <= maxStages);
+
+    if (newNumItems <= 0)
+        return;
+
+    std::array<Worker*, maxStages> workers{};
+    auto numGroups = (*pool)->acquire(numStages - 1, workers) + 1;
+
+    function = newFunction;
+    context = newContext;
+    numItems = newNumItems;
+    fpStatus = juce::FloatVectorOperations::getFpStatusRegister();
+
+    // as even as the stage count allows; groupStart[numGroups] == numStages
+    for (int g = 0; g <= numGroups; ++g)
+        groupStart[static_cast<size_t>(g)] = g * numStages / numGroups;
+
+    for (auto& count : completed)
+        count.store(0, std::memory_order_relaxed);
+
+    for (int g = 1; g < numGroups; ++g)
+        workers[static_cast<size_t>(g - 1)]->start(*this, g);
+
+    runGroup(0);
+
+    // the last group's release store makes everything every group wrote visible here
+    waitUntilAbove(completed[static_cast<size_t>(numGroups - 1)], numItems - 1);
+}
+
+void StagePipeline::runGroup(int group)
+{
+    // copied first: once this group's last item is handed on, the next run may already be set up
+    auto runFunction = function;
+    auto runContext = context;
+    auto runNumItems = numItems;
+    auto firstStage = groupStart[static_cast<size_t>(group)];
+    auto endStage = groupStart[static_cast<size_t>(group + 1)];
+
+    auto previousFpStatus = juce::FloatVectorOperations::getFpStatusRegister();
+    juce::FloatVectorOperations::setFpStatusRegister(fpStatus);
+
+    auto& done = completed[static_cast<size_t>(group)];
+
+    for (int item = 0; item < runNumItems; ++item)
+    {
+        if (group > 0)
+            waitUntilAbove(completed[static_cast<size_t>(group - 1)], item);
+
+        for (int stage = firstStage; stage < endStage; ++stage)
+            runFunction(runContext, stage, item);
+
+        done.store(item + 1, std::memory_order_release);
+    }
+
+    juce::FloatVectorOperations::setFpStatusRegister(previousFpStatus);
+}
+
+void StagePipeline::waitUntilAbove(const std::atomic<int>& counter, int item) noexcept
+{
+    // a sub-block of one stage is a few microseconds: spin first, a yield costs about as much
+    for (int spins = 0; counter.load(std::memory_order_acquire) <= item; ++spins)
+        if (spins >= 256)
+            juce::Thread::yield();
+}
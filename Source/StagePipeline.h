@@ -0,0 +1,94 @@
+/*
+  ==============================================================================
+
+    StagePipeline.h
+
+    Runs a chain of stages over a run of items with every stage on its own
+    thread, for offline renders.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+    run() calls work(stage, item) for every stage below numStages and every
+    item below numItems. Every stage takes the items in order, and item k
+    only reaches stage s once stage s - 1 has finished with it. So each
+    stage sees exactly the sequence of calls a serial loop would make, and
+    the result is bit-identical to one, however the stages are spread over
+    threads.
+
+    The threads are a process-wide pool shared by every instance, one fewer
+    than the machine has cores and at most maxStages - 1. A run takes as
+    many idle ones as it can use and splits the stages into that many
+    groups plus one, consecutive stages to a group, the first group on the
+    calling thread. With numItems items and g groups the run takes about
+    numItems + g - 1 item times of the slowest group, rather than numItems
+    times the sum of all the stages. When other instances are rendering
+    and no thread is free, the run is simply the serial loop on the caller.
+
+    The hand-off from one group to the next is the earlier group's count of
+    finished items, one atomic per group, so passing an item on is a single
+    release store. The items themselves stay where they are (the processor's
+    sub-blocks, in place in the host buffer): nothing is copied and there is
+    no queue storage. Pool threads take on the caller's floating point mode
+    (flush to zero and so on) for the run, since denormal handling changes
+    results.
+
+    A waiting group spins briefly, then yields; between runs the pool's
+    threads sleep. That is fine for an offline render, which should use
+    every core it is given, but it means a pipeline must never run on a
+    realtime thread.
+*/
+class StagePipeline
+{
+public:
+    static constexpr int maxStages = 8;
+
+    StagePipeline();
+    ~StagePipeline();
+
+    // message thread: takes / lets go of the shared pool
+    void prepare();
+    void release();
+
+    bool isPrepared() const noexcept { return pool != nullptr; }
+
+    // returns once every item has been through every stage
+    template<typename Work>
+    void run(int numStages, int numItems, Work& work)
+    {
+        runStages(numStages, numItems, [](void* context, int stage, int item) { (*static_cast<Work*>(context))(stage, item); }, &work);
+    }
+
+private:
+    using WorkFunction = void (*)(void*, int, int);
+
+    void runStages(int newNumStages, int newNumItems, WorkFunction newFunction, void* newContext);
+    void runGroup(int group);
+
+    static void waitUntilAbove(const std::atomic<int>& counter, int item) noexcept;
+
+    class Worker;
+    class Pool;
+    friend class Worker;
+
+    std::unique_ptr<juce::SharedResourcePointer<Pool>> pool;
+
+    // the current run, written before the pool's threads are woken
+    WorkFunction function = nullptr;
+    void* context = nullptr;
+    int numItems = 0;
+    intptr_t fpStatus = 0;
+
+    // group g runs stages groupStart[g] up to groupStart[g + 1]
+    std::array<int, maxStages + 1> groupStart{};
+
+    // items each group has finished in the current run
+    std::array<std::atomic<int>, maxStages> completed{};
+
+    JUCE_DECLARE_NON_COPYABLE(StagePipeline)
+};
@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    TripleBuffer.h
+
+    Wait-free single-producer / single-consumer snapshot exchange.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+    The writer (normally the audio thread) fills getWriteBuffer() and calls
+    publish(). The reader (normally the message thread) calls update() and,
+    if it returned true, reads getReadBuffer().
+
+    Neither side ever blocks or allocates: the three slots are swapped by
+    index through a single atomic, so the writer can publish every block
+    while the reader only looks at the most recent snapshot.
+*/
+template<typename T>
+struct TripleBuffer
+{
+    T& getWriteBuffer() noexcept { return buffers[static_cast<size_t>(writeIndex)]; }
+
+    void publish() noexcept
+    {
+        auto previous = middle.exchange(writeIndex | dirtyFlag, std::memory_order_acq_rel);
+        writeIndex = previous & indexMask;
+    }
+
+    // returns true if a newer snapshot than the one in getReadBuffer() was picked up
+    bool update() noexcept
+    {
+        if ((middle.load(std::memory_order_relaxed) & dirtyFlag) == 0)
+            return false;
+
+        auto previous = middle.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex = previous & indexMask;
+        return true;
+    }
+
+    const T& getReadBuffer() const noexcept { return buffers[static_cast<size_t>(readIndex)]; }
+
+    // only safe before the producer and consumer threads are running,
+    // e.g. to preallocate storage inside every slot
+    template<typename Func>
+    void forEachBuffer(Func&& f)
+    {
+        for (auto& b : buffers)
+            f(b);
+    }
+
+private:
+    static constexpr int indexMask = 3;
+    static constexpr int dirtyFlag = 4;
+
+    std::array<T, 3> buffers{};
+    int writeIndex = 0;
+    int readIndex = 1;
+    std::atomic<int> middle{ 2 };
+};
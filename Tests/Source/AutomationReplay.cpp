@@ -0,0 +1,105 @@
+/*
+  ==============================================================================
+
+    AutomationReplay.cpp
+
+  ==============================================================================
+*/
+
+#include "AutomationReplay.h"
+
+namespace AutomationReplay
+{
+namespace
+{
+    juce::File getFile(const juce::ArgumentList& args, const juce::String& option)
+    {
+        if (! args.containsOption(option))
+            juce::ConsoleApplication::fail(option + " is missing");
+
+        return args.getFileForOption(option);
+    }
+
+    juce::AudioBuffer<float> readInput(const juce::File& file, const AutomationTrace& trace)
+    {
+        juce::AudioFormatManager formats;
+        formats.registerBasicFormats();
+
+        std::unique_ptr<juce::AudioFormatReader> reader(formats.createReaderFor(file));
+
+        if (reader == nullptr)
+            juce::ConsoleApplication::fail("Can't read " + file.getFullPathName());
+
+        if (reader->sampleRate != trace.sampleRate)
+            juce::ConsoleApplication::fail(file.getFullPathName() + " is at " + juce::String(reader->sampleRate) + " Hz, the trace at "
+                                           + juce::String(trace.sampleRate) + " Hz");
+
+        auto numChannels = juce::jlimit(1, 2, static_cast<int>(reader->numChannels));
+        auto length = static_cast<int>(trace.getLengthInSamples());
+
+        juce::AudioBuffer<float> audio(numChannels, length);
+        audio.clear();
+
+        auto numToRead = static_cast<int>(juce::jmin(reader->lengthInSamples, static_cast<juce::int64>(length)));
+        reader->read(&audio, 0, numToRead, 0, true, numChannels > 1);
+
+        return audio;
+    }
+
+    void writeOutput(const juce::File& file, const juce::AudioBuffer<float>& audio, double sampleRate)
+    {
+        file.deleteFile();
+
+        auto stream = std::make_unique<juce::FileOutputStream>(file);
+
+        if (! stream->openedOk())
+            juce::ConsoleApplication::fail("Can't write " + file.getFullPathName());
+
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer(wav.createWriterFor(stream.get(), sampleRate,
+            static_cast<unsigned int>(audio.getNumChannels()), 32, {}, 0));
+
+        if (writer == nullptr)
+            juce::ConsoleApplication::fail("Can't write a WAV to " + file.getFullPathName());
+
+        // the writer owns the stream now
+        stream.release();
+
+        if (! writer->writeFromAudioSampleBuffer(audio, 0, audio.getNumSamples()))
+            juce::ConsoleApplication::fail("Writing " + file.getFullPathName() + " failed");
+    }
+}
+
+void run(const juce::ArgumentList& args)
+{
+    auto traceFile = getFile(args, "--automation");
+    auto inputFile = getFile(args, "--input");
+    auto outputFile = getFile(args, "--output");
+
+    AutomationTrace trace;
+
+    if (! trace.load(traceFile))
+        juce::ConsoleApplication::fail("Can't read " + traceFile.getFullPathName() + " as an automation trace");
+
+    if (trace.blocks.empty())
+        juce::ConsoleApplication::fail(traceFile.getFullPathName() + " has no blocks to replay");
+
+    if (! trace.complete)
+        std::cout << "The recording was cut short, replaying what there is" << std::endl;
+    else if (trace.numDropped > 0)
+        std::cout << "The recording dropped " << trace.numDropped << " records, the replay isn't exact" << std::endl;
+
+    auto audio = readInput(inputFile, trace);
+
+    TestHost::Processor processor;
+
+    auto start = juce::Time::getHighResolutionTicks();
+    processor.replayAutomation(trace, audio);
+    auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+
+    writeOutput(outputFile, audio, trace.sampleRate);
+
+    std::cout << "Replayed " << trace.blocks.size() << " blocks, " << audio.getNumSamples() / trace.sampleRate << " s of audio in "
+              << seconds << " s, to " << outputFile.getFullPathName() << std::endl;
+}
+}
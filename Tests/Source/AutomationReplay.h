@@ -0,0 +1,35 @@
+/*
+  ==============================================================================
+
+    AutomationReplay.h
+
+    Renders an audio file through a session recorded with the processor's
+    automation recorder, offline, to another audio file.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "TestHost.h"
+
+/*
+    The trace (--automation, a .automation file from the editor or
+    startAutomationRecording()) is replayed on a fresh processor with
+    replayAutomation(): the recorded blocks, the changes at the positions
+    the live processor saw them, the recorded governor levels, impulse
+    responses read synchronously. So two replays of the same trace and
+    input give the same output, and a change to the DSP can be heard, or
+    profiled, against exactly what a session did.
+
+    The input (--input, anything AudioFormatManager reads) has to be at the
+    trace's sample rate. It is used from its first sample, one or two
+    channels, and is padded with silence if it is shorter than the trace.
+    The output (--output) is a 32-bit float WAV of the trace's length.
+
+        replay --automation=<file> --input=<audio file> --output=<wav file>
+*/
+namespace AutomationReplay
+{
+    void run(const juce::ArgumentList& args);
+}
@@ -0,0 +1,153 @@
+/*
+  ==============================================================================
+
+    ChorusBenchmark.cpp
+
+  ==============================================================================
+*/
+
+#include "ChorusBenchmark.h"
+#include "../../Source/ChorusEngine.h"
+#include "../../Source/ModulationBus.h"
+#include "../../Source/Quality.h"
+
+namespace ChorusBenchmark
+{
+namespace
+{
+    constexpr float rateHz = 1.f;
+    constexpr float depth = 0.25f;
+    constexpr float centreDelayMs = 7.f;
+    constexpr float feedback = 0.3f;
+    constexpr float mix = 0.5f;
+
+    struct Settings
+    {
+        double seconds = 2.0;
+        int numRounds = 5;
+        double sampleRate = 48000.0;
+        int blockSize = 256;
+    };
+
+    // the fastest round, in ns per sample frame; processBlock is called with each block in turn
+    template <typename ProcessBlock>
+    double time(const Settings& settings, const juce::AudioBuffer<float>& input, int numChannels, ProcessBlock&& processBlock)
+    {
+        juce::AudioBuffer<float> block(numChannels, settings.blockSize);
+        auto numBlocks = juce::jmax(1, juce::roundToInt(settings.seconds * settings.sampleRate / settings.blockSize));
+        auto best = std::numeric_limits<juce::int64>::max();
+        auto position = 0;
+
+        for (int round = 0; round < settings.numRounds; ++round)
+        {
+            juce::int64 ticks = 0;
+
+            for (int i = 0; i < numBlocks; ++i)
+            {
+                for (int ch = 0; ch < numChannels; ++ch)
+                    block.copyFrom(ch, 0, input, ch, position, settings.blockSize);
+
+                position += settings.blockSize;
+
+                if (position + settings.blockSize > input.getNumSamples())
+                    position = 0;
+
+                juce::dsp::AudioBlock<float> audio(block);
+
+                auto start = juce::Time::getHighResolutionTicks();
+                processBlock(audio);
+                ticks += juce::Time::getHighResolutionTicks() - start;
+            }
+
+            best = juce::jmin(best, ticks);
+        }
+
+        return juce::Time::highResolutionTicksToSeconds(best) * 1.0e9 / (static_cast<double>(numBlocks) * settings.blockSize);
+    }
+
+    double timeJuceChorus(const Settings& settings, const juce::AudioBuffer<float>& input, int numChannels)
+    {
+        juce::dsp::Chorus<float> chorus;
+        chorus.prepare({ settings.sampleRate, static_cast<juce::uint32>(settings.blockSize), static_cast<juce::uint32>(numChannels) });
+        chorus.setRate(rateHz);
+        chorus.setDepth(depth);
+        chorus.setCentreDelay(centreDelayMs);
+        chorus.setFeedback(feedback);
+        chorus.setMix(mix);
+
+        return time(settings, input, numChannels, [&](juce::dsp::AudioBlock<float>& audio)
+            {
+                chorus.process(juce::dsp::ProcessContextReplacing<float>(audio));
+            });
+    }
+
+    double timeChorusEngine(const Settings& settings, const juce::AudioBuffer<float>& input, int numChannels, QualityMode mode)
+    {
+        auto quality = QualitySettings::forMode(mode);
+
+        ModulationBus modulation;
+        modulation.prepare(settings.sampleRate, settings.blockSize);
+        modulation.setInterval(quality.modulationInterval);
+        modulation.getSettings(ModulationBus::ChorusLfo).rateHz = rateHz;
+
+        // the range ends of the processor's centre delay and depth parameters
+        ChorusEngine chorus;
+        chorus.setModulation(&modulation, ModulationBus::ChorusLfo);
+        chorus.setMaximumDelay(100.f, 1.f);
+        chorus.setControlInterval(quality.chorusControlInterval);
+        chorus.prepare({ settings.sampleRate, static_cast<juce::uint32>(settings.blockSize), static_cast<juce::uint32>(numChannels) });
+        chorus.setDepth(depth);
+        chorus.setCentreDelay(centreDelayMs);
+        chorus.setFeedback(feedback);
+        chorus.setMix(mix);
+
+        return time(settings, input, numChannels, [&](juce::dsp::AudioBlock<float>& audio)
+            {
+                modulation.generate(static_cast<int>(audio.getNumSamples()), nullptr);
+                chorus.process(juce::dsp::ProcessContextReplacing<float>(audio));
+            });
+    }
+}
+
+void run(const juce::ArgumentList& args)
+{
+    Settings settings;
+
+    if (args.containsOption("--seconds"))
+        settings.seconds = args.getValueForOption("--seconds").getDoubleValue();
+
+    if (args.containsOption("--rounds"))
+        settings.numRounds = args.getValueForOption("--rounds").getIntValue();
+
+    if (args.containsOption("--block-size"))
+        settings.blockSize = args.getValueForOption("--block-size").getIntValue();
+
+    if (args.containsOption("--rate"))
+        settings.sampleRate = args.getValueForOption("--rate").getDoubleValue();
+
+    if (settings.seconds <= 0.0 || settings.numRounds <= 0 || settings.blockSize <= 0 || settings.sampleRate <= 0.0)
+        juce::ConsoleApplication::fail("--seconds, --rounds, --block-size and --rate must be positive");
+
+    auto input = TestHost::makeTestSignal(static_cast<int>(settings.sampleRate), settings.sampleRate);
+
+    if (settings.blockSize > input.getNumSamples())
+        juce::ConsoleApplication::fail("--block-size must be at most a second of audio");
+
+    auto modes = QualitySettings::getModeChoices();
+
+    std::cout << settings.blockSize << " samples per block, " << settings.sampleRate << " Hz, fastest of "
+              << settings.numRounds << " rounds of " << settings.seconds << " s, ns per sample frame" << std::endl
+              << "                         stereo      mono" << std::endl
+              << "juce::dsp::Chorus  " << juce::String(timeJuceChorus(settings, input, 2), 2).paddedLeft(' ', 12)
+                                       << juce::String(timeJuceChorus(settings, input, 1), 2).paddedLeft(' ', 10) << std::endl;
+
+    for (int i = 0; i < modes.size(); ++i)
+    {
+        auto mode = static_cast<QualityMode>(i);
+
+        std::cout << ("ChorusEngine " + modes[i]).paddedRight(' ', 19)
+                  << juce::String(timeChorusEngine(settings, input, 2, mode), 2).paddedLeft(' ', 12)
+                  << juce::String(timeChorusEngine(settings, input, 1, mode), 2).paddedLeft(' ', 10) << std::endl;
+    }
+}
+}
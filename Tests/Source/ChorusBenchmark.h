@@ -0,0 +1,30 @@
+/*
+  ==============================================================================
+
+    ChorusBenchmark.h
+
+    ChorusEngine against juce::dsp::Chorus, the stage it replaced.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "TestHost.h"
+
+/*
+    Both get the same settings (1 Hz, depth 0.25, 7 ms centre delay,
+    feedback 0.3, mix 0.5) and the test signal, in blocks of --block-size,
+    stereo and mono. ChorusEngine runs at each quality mode's control and
+    modulation intervals, with its ModulationBus generated once per block
+    as the processor does; that time is counted with the engine's.
+
+    Reported is ns per sample frame, the fastest of --rounds rounds of
+    --seconds of audio each.
+
+        chorus [--seconds=<s>] [--rounds=<n>] [--block-size=<samples>] [--rate=<Hz>]
+*/
+namespace ChorusBenchmark
+{
+    void run(const juce::ArgumentList& args);
+}
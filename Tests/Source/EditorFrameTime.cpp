@@ -0,0 +1,237 @@
+/*
+  ==============================================================================
+
+    EditorFrameTime.cpp
+
+  ==============================================================================
+*/
+
+#include "EditorFrameTime.h"
+#include "../../Source/PluginEditor.h"
+
+#if JUCE_WINDOWS
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #include <windows.h>
+#else
+ #include <time.h>
+#endif
+
+namespace EditorFrameTime
+{
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 256;
+    constexpr int frameRateHz = AudioPluginprojectAudioProcessorEditor::frameRateHz;
+
+    struct Settings
+    {
+        double seconds = 10.0;
+        int changesPerSecond = 1000;
+        bool offscreen = false;
+    };
+
+    double getThreadCpuSeconds()
+    {
+       #if JUCE_WINDOWS
+        FILETIME creation, exited, kernel, user;
+
+        if (GetThreadTimes(GetCurrentThread(), &creation, &exited, &kernel, &user))
+        {
+            auto toTicks = [](const FILETIME& time) { return (static_cast<juce::uint64>(time.dwHighDateTime) << 32) | time.dwLowDateTime; };
+            return static_cast<double>(toTicks(kernel) + toTicks(user)) * 1.0e-7;
+        }
+       #else
+        timespec time{};
+
+        if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) == 0)
+            return static_cast<double>(time.tv_sec) + static_cast<double>(time.tv_nsec) * 1.0e-9;
+       #endif
+
+        return 0.0;
+    }
+
+    //==============================================================================
+    // plays prepared-size blocks in real time, for the meters and the spectrum
+    class PlaybackThread : public juce::Thread
+    {
+    public:
+        explicit PlaybackThread(TestHost& hostToPlay)
+            : juce::Thread("editor playback"),
+              host(hostToPlay),
+              input(TestHost::makeTestSignal(static_cast<int>(sampleRate), sampleRate)),
+              block(2, blockSize)
+        {
+        }
+
+        void run() override
+        {
+            auto nextBlockMs = juce::Time::getMillisecondCounterHiRes();
+            auto position = 0;
+
+            while (! threadShouldExit())
+            {
+                for (int ch = 0; ch < block.getNumChannels(); ++ch)
+                    block.copyFrom(ch, 0, input, ch, position, blockSize);
+
+                host.process(block);
+
+                position = (position + blockSize) % (input.getNumSamples() - blockSize);
+                nextBlockMs += blockSize * 1000.0 / sampleRate;
+
+                auto remaining = nextBlockMs - juce::Time::getMillisecondCounterHiRes();
+
+                if (remaining > 1.0)
+                    juce::Thread::sleep(static_cast<int>(remaining));
+            }
+        }
+
+    private:
+        TestHost& host;
+        juce::AudioBuffer<float> input, block;
+    };
+
+    class AutomationThread : public juce::Thread
+    {
+    public:
+        AutomationThread(TestHost::Processor& processorToAutomate, int changesPerSecondToMake)
+            : juce::Thread("editor automation"),
+              parameters(processorToAutomate.getParameters()),
+              changesPerSecond(changesPerSecondToMake)
+        {
+        }
+
+        void run() override
+        {
+            // the same changes for each editor
+            juce::Random random(0xed17);
+            auto nextChangeMs = juce::Time::getMillisecondCounterHiRes();
+
+            while (! threadShouldExit())
+            {
+                parameters[random.nextInt(parameters.size())]->setValueNotifyingHost(random.nextFloat());
+
+                nextChangeMs += 1000.0 / changesPerSecond;
+                auto remaining = nextChangeMs - juce::Time::getMillisecondCounterHiRes();
+
+                if (remaining > 1.0)
+                    juce::Thread::sleep(static_cast<int>(remaining));
+            }
+        }
+
+    private:
+        juce::Array<juce::AudioProcessorParameter*> parameters;
+        int changesPerSecond;
+    };
+
+    //==============================================================================
+    std::vector<double> measure(const Settings& settings, bool useGenericEditor, bool onDesktop)
+    {
+        TestHost host(sampleRate, blockSize, false);
+        auto& processor = host.getProcessor();
+        host.applyTestPreset();
+
+        std::unique_ptr<juce::AudioProcessorEditor> editor;
+
+        if (useGenericEditor)
+            editor = std::make_unique<juce::GenericAudioProcessorEditor>(processor);
+        else
+            editor.reset(processor.createEditorAndMakeActive());
+
+        if (onDesktop)
+        {
+            editor->addToDesktop(juce::ComponentPeer::windowHasTitleBar);
+            editor->setVisible(true);
+        }
+
+        PlaybackThread playback(host);
+        AutomationThread automation(processor, settings.changesPerSecond);
+
+        playback.startThread(juce::Thread::Priority::highest);
+        automation.startThread();
+
+        // a second to settle: stage loads, first paints, the cached layers
+        juce::MessageManager::getInstance()->runDispatchLoopUntil(1000);
+
+        juce::Image image(juce::Image::ARGB, juce::jmax(1, editor->getWidth()), juce::jmax(1, editor->getHeight()), true);
+        auto numFrames = juce::roundToInt(settings.seconds * frameRateHz);
+        std::vector<double> frameMicros;
+        frameMicros.reserve(static_cast<size_t>(numFrames));
+
+        for (int frame = 0; frame < numFrames; ++frame)
+        {
+            auto start = getThreadCpuSeconds();
+
+            juce::MessageManager::getInstance()->runDispatchLoopUntil(1000 / frameRateHz);
+
+            if (! onDesktop)
+            {
+                juce::Graphics g(image);
+                editor->paintEntireComponent(g, true);
+            }
+
+            frameMicros.push_back((getThreadCpuSeconds() - start) * 1.0e6);
+        }
+
+        automation.stopThread(1000);
+        playback.stopThread(1000);
+
+        if (onDesktop)
+            editor->removeFromDesktop();
+
+        editor.reset();
+
+        return frameMicros;
+    }
+
+    void report(const juce::String& label, std::vector<double> frameMicros)
+    {
+        if (frameMicros.empty())
+            return;
+
+        auto mean = std::accumulate(frameMicros.begin(), frameMicros.end(), 0.0) / static_cast<double>(frameMicros.size());
+        std::sort(frameMicros.begin(), frameMicros.end());
+
+        auto percentile = [&](double fraction)
+            {
+                return frameMicros[static_cast<size_t>(fraction * static_cast<double>(frameMicros.size() - 1) + 0.5)];
+            };
+
+        std::cout << label << ": " << frameMicros.size() << " frames, message thread CPU per frame"
+                  << "  mean " << juce::String(mean, 1) << " us"
+                  << "  p50 " << juce::String(percentile(0.5), 1)
+                  << "  p90 " << juce::String(percentile(0.9), 1)
+                  << "  p99 " << juce::String(percentile(0.99), 1)
+                  << "  max " << juce::String(frameMicros.back(), 1) << std::endl;
+    }
+}
+
+void run(const juce::ArgumentList& args)
+{
+    Settings settings;
+
+    if (args.containsOption("--seconds"))
+        settings.seconds = args.getValueForOption("--seconds").getDoubleValue();
+
+    if (args.containsOption("--changes-per-second"))
+        settings.changesPerSecond = args.getValueForOption("--changes-per-second").getIntValue();
+
+    settings.offscreen = args.containsOption("--offscreen");
+
+    if (settings.seconds <= 0.0 || settings.changesPerSecond <= 0)
+        juce::ConsoleApplication::fail("--seconds and --changes-per-second must be positive");
+
+    auto onDesktop = ! settings.offscreen && juce::Desktop::getInstance().getDisplays().getPrimaryDisplay() != nullptr;
+
+    std::cout << (onDesktop ? "On the desktop" : "Offscreen, one full paint per frame") << ", "
+              << settings.changesPerSecond << " parameter changes per second, " << frameRateHz << " frames per second" << std::endl;
+
+    auto generic = measure(settings, true, onDesktop);
+    auto custom = measure(settings, false, onDesktop);
+
+    report("GenericAudioProcessorEditor", generic);
+    report("Plugin editor              ", custom);
+}
+}
@@ -0,0 +1,38 @@
+/*
+  ==============================================================================
+
+    EditorFrameTime.h
+
+    Message-thread time per frame for juce::GenericAudioProcessorEditor and
+    for the plugin's own editor, under the same automation.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "TestHost.h"
+
+/*
+    Each editor gets --seconds of the same conditions: audio playing in real
+    time on its own thread, so the meters and the spectrum have something to
+    show, and an automation thread changing --changes-per-second random
+    parameters (1000 by default), as host automation would.
+
+    The message thread runs its dispatch loop one frame (1/30 s) at a time.
+    The time per frame is the message thread's CPU time across that frame,
+    so idle waiting doesn't count, and timers, async updates and paints do.
+    Where there is a display the editor is put on the desktop and paints as
+    it would in a host. Without one, or with --offscreen, the whole editor is
+    also painted into an image once per frame. That measures full repaints
+    rather than the dirty regions, so only compare runs made the same way.
+
+    On Windows the thread CPU time advances in scheduler ticks of about
+    15 ms, so there only the mean is meaningful, not the percentiles.
+
+        editor-frames [--seconds=<s>] [--changes-per-second=<n>] [--offscreen]
+*/
+namespace EditorFrameTime
+{
+    void run(const juce::ArgumentList& args);
+}
@@ -0,0 +1,360 @@
+/*
+  ==============================================================================
+
+    HostStressTest.cpp
+
+  ==============================================================================
+*/
+
+#include "HostStressTest.h"
+
+namespace HostStressTest
+{
+namespace
+{
+    constexpr int oversizeFactor = 4;
+    constexpr int messageIntervalMs = 20;
+
+    struct Settings
+    {
+        double seconds = 10.0;
+        double sampleRate = 48000.0;
+        int blockSize = 256;
+        double maxMisses = -1.0;
+    };
+
+    struct BlockRecord
+    {
+        int numSamples = 0;
+        double seconds = 0.0;
+        double deadline = 0.0;
+    };
+
+    //==============================================================================
+    class AudioThread : public juce::Thread
+    {
+    public:
+        AudioThread(TestHost& hostToPlay, double secondsToPlay)
+            : juce::Thread("stress audio"),
+              host(hostToPlay),
+              input(TestHost::makeTestSignal(static_cast<int>(hostToPlay.getSampleRate()), hostToPlay.getSampleRate())),
+              block(hostToPlay.getNumChannels(), hostToPlay.getMaxBlockSize() * oversizeFactor),
+              numSamplesToPlay(static_cast<juce::int64>(secondsToPlay * hostToPlay.getSampleRate()))
+        {
+            // allocated here, the audio thread only appends; a run of mostly short blocks may fill it early
+            records.reserve(static_cast<size_t>(numSamplesToPlay / host.getMaxBlockSize()) * 4 + 1024);
+        }
+
+        const std::vector<BlockRecord>& getRecords() const noexcept { return records; }
+        juce::int64 getNumNonFiniteSamples() const noexcept { return numNonFiniteSamples; }
+
+        void run() override
+        {
+            juce::Random random(0x5eed);
+            auto sampleRate = host.getSampleRate();
+            auto nextBlockMs = juce::Time::getMillisecondCounterHiRes();
+            auto position = 0;
+
+            while (! threadShouldExit() && numSamplesPlayed < numSamplesToPlay && records.size() < records.capacity())
+            {
+                auto numSamples = pickBlockSize(random);
+                auto deadline = numSamples / sampleRate;
+
+                waitUntil(nextBlockMs);
+
+                if (position + numSamples > input.getNumSamples())
+                    position = 0;
+
+                for (int ch = 0; ch < block.getNumChannels(); ++ch)
+                    block.copyFrom(ch, 0, input, ch, position, numSamples);
+
+                juce::AudioBuffer<float> hostBlock(block.getArrayOfWritePointers(), block.getNumChannels(), numSamples);
+
+                auto start = juce::Time::getHighResolutionTicks();
+                host.process(hostBlock);
+                auto elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+
+                records.push_back({ numSamples, elapsed, deadline });
+                countNonFinite(hostBlock);
+
+                position += numSamples;
+                numSamplesPlayed += numSamples;
+
+                // after a miss a device carries on from where it is, it doesn't catch up
+                nextBlockMs = juce::jmax(nextBlockMs + deadline * 1000.0, juce::Time::getMillisecondCounterHiRes());
+            }
+        }
+
+    private:
+        int pickBlockSize(juce::Random& random) const
+        {
+            auto prepared = host.getMaxBlockSize();
+            auto dice = random.nextInt(10);
+
+            if (dice < 5)
+                return prepared;
+
+            if (dice < 8)
+                return 1 + random.nextInt(prepared);
+
+            return prepared + 1 + random.nextInt(prepared * (oversizeFactor - 1));
+        }
+
+        static void waitUntil(double timeMs)
+        {
+            for (;;)
+            {
+                auto remaining = timeMs - juce::Time::getMillisecondCounterHiRes();
+
+                if (remaining <= 0.0)
+                    return;
+
+                // sleep is only good to a ms or two, the rest is spun
+                if (remaining > 2.0)
+                    juce::Thread::sleep(static_cast<int>(remaining) - 1);
+                else
+                    juce::Thread::yield();
+            }
+        }
+
+        void countNonFinite(const juce::AudioBuffer<float>& audio)
+        {
+            for (int ch = 0; ch < audio.getNumChannels(); ++ch)
+            {
+                auto* samples = audio.getReadPointer(ch);
+
+                for (int i = 0; i < audio.getNumSamples(); ++i)
+                    if (! std::isfinite(samples[i]))
+                        ++numNonFiniteSamples;
+            }
+        }
+
+        TestHost& host;
+        juce::AudioBuffer<float> input, block;
+
+        juce::int64 numSamplesToPlay;
+        juce::int64 numSamplesPlayed = 0;
+        juce::int64 numNonFiniteSamples = 0;
+
+        std::vector<BlockRecord> records;
+    };
+
+    //==============================================================================
+    class AutomationThread : public juce::Thread
+    {
+    public:
+        explicit AutomationThread(TestHost::Processor& processorToAutomate)
+            : juce::Thread("stress automation"),
+              parameters(processorToAutomate.getParameters())
+        {
+        }
+
+        int getNumChanges() const noexcept { return numChanges; }
+
+        void run() override
+        {
+            juce::Random random(0xa070);
+
+            while (! threadShouldExit())
+            {
+                parameters[random.nextInt(parameters.size())]->setValueNotifyingHost(random.nextFloat());
+                ++numChanges;
+
+                juce::Thread::sleep(random.nextInt(6));
+            }
+        }
+
+    private:
+        juce::Array<juce::AudioProcessorParameter*> parameters;
+        std::atomic<int> numChanges{ 0 };
+    };
+
+    //==============================================================================
+    // some stages, in random slots, the rest empty
+    TestHost::DSP_Order makeRandomOrder(juce::Random& random)
+    {
+        TestHost::DSP_Order order;
+        order.fill(TestHost::DSP_Option::End_Of_List);
+
+        std::array<TestHost::DSP_Option, TestHost::numStages> stages;
+
+        for (size_t i = 0; i < stages.size(); ++i)
+            stages[i] = static_cast<TestHost::DSP_Option>(i);
+
+        for (auto i = stages.size() - 1; i > 0; --i)
+            std::swap(stages[i], stages[static_cast<size_t>(random.nextInt(static_cast<int>(i) + 1))]);
+
+        auto numUsed = static_cast<size_t>(random.nextInt(TestHost::numStages + 1));
+
+        for (size_t i = 0; i < numUsed; ++i)
+            order[static_cast<size_t>(random.nextInt(static_cast<int>(order.size())))] = stages[i];
+
+        return order;
+    }
+
+    double getPercentile(const std::vector<double>& sorted, double fraction)
+    {
+        if (sorted.empty())
+            return 0.0;
+
+        auto index = static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1) + 0.5);
+        return sorted[juce::jmin(index, sorted.size() - 1)];
+    }
+
+    void reportBlocks(const juce::String& label, const std::vector<BlockRecord>& records, bool oversized, int preparedSize)
+    {
+        std::vector<double> micros, loads;
+        auto numMisses = 0;
+
+        for (auto& record : records)
+        {
+            if ((record.numSamples > preparedSize) != oversized)
+                continue;
+
+            micros.push_back(record.seconds * 1.0e6);
+            loads.push_back(record.seconds / record.deadline);
+
+            if (record.seconds > record.deadline)
+                ++numMisses;
+        }
+
+        std::cout << "  " << label << ": " << micros.size() << " blocks";
+
+        if (micros.empty())
+        {
+            std::cout << std::endl;
+            return;
+        }
+
+        std::sort(micros.begin(), micros.end());
+        std::sort(loads.begin(), loads.end());
+
+        std::cout << ", " << numMisses << " missed their deadline" << std::endl;
+
+        const std::pair<const char*, double> percentiles[] = { { "p50  ", 0.5 }, { "p90  ", 0.9 }, { "p99  ", 0.99 },
+                                                               { "p99.9", 0.999 }, { "max  ", 1.0 } };
+
+        for (auto& [name, fraction] : percentiles)
+        {
+            std::cout << "    " << name
+                      << "  " << juce::String(getPercentile(micros, fraction), 1) << " us"
+                      << "  " << juce::String(getPercentile(loads, fraction) * 100.0, 1) << "% of the deadline" << std::endl;
+        }
+    }
+
+    //==============================================================================
+    bool play(const Settings& settings, int numChannels)
+    {
+        std::cout << std::endl << (numChannels == 1 ? "Mono" : "Stereo") << " bus, " << settings.blockSize
+                  << " samples prepared, " << settings.sampleRate << " Hz, " << settings.seconds << " s" << std::endl;
+
+        TestHost host(settings.sampleRate, settings.blockSize, false, numChannels);
+        auto& processor = host.getProcessor();
+        host.applyTestPreset();
+
+        juce::MemoryBlock presetState;
+        processor.getStateInformation(presetState);
+
+        AudioThread audio(host, settings.seconds);
+        AutomationThread automation(processor);
+
+        if (! audio.startRealtimeThread(juce::Thread::RealtimeOptions{}.withApproximateAudioProcessingTime(settings.blockSize, settings.sampleRate)))
+        {
+            std::cout << "  No realtime thread available, playing at the highest normal priority" << std::endl;
+            audio.startThread(juce::Thread::Priority::highest);
+        }
+
+        automation.startThread();
+
+        juce::Random random(0x3e55);
+        auto numGets = 0, numSets = 0, numOrders = 0;
+
+        for (auto iteration = 1; audio.isThreadRunning(); ++iteration)
+        {
+            juce::MessageManager::getInstance()->runDispatchLoopUntil(messageIntervalMs);
+
+            juce::MemoryBlock state;
+            processor.getStateInformation(state);
+            ++numGets;
+
+            // alternately back to the preset and to the state just taken, as undo and redo would
+            if (iteration % 4 == 0)
+            {
+                auto& stateToSet = (iteration % 8 == 0) ? presetState : state;
+                processor.setStateInformation(stateToSet.getData(), static_cast<int>(stateToSet.getSize()));
+                ++numSets;
+            }
+
+            if (iteration % 3 == 0)
+            {
+                host.setOrder(makeRandomOrder(random));
+                ++numOrders;
+            }
+        }
+
+        automation.stopThread(1000);
+
+        auto& records = audio.getRecords();
+        auto stats = processor.getGovernorStats();
+
+        std::cout << "  " << automation.getNumChanges() << " parameter changes, " << numGets << " getStateInformation, "
+                  << numSets << " setStateInformation, " << numOrders << " orders" << std::endl;
+
+        reportBlocks("up to the prepared size", records, false, settings.blockSize);
+        reportBlocks("oversized", records, true, settings.blockSize);
+
+        std::cout << "  Processor's load histogram, 10% of the deadline per bin:";
+
+        for (auto count : stats.loadHistogram)
+            std::cout << " " << count;
+
+        std::cout << std::endl << "  Processor's peak load " << juce::String(stats.peakLoad * 100.f, 1) << "%, "
+                  << stats.overrunCount << " overruns in " << stats.blockCount << " blocks" << std::endl;
+
+        auto passed = true;
+
+        if (audio.getNumNonFiniteSamples() > 0)
+        {
+            std::cout << "FAIL " << audio.getNumNonFiniteSamples() << " output samples were NaN or infinite" << std::endl;
+            passed = false;
+        }
+
+        auto numMisses = std::count_if(records.begin(), records.end(), [](auto& r) { return r.seconds > r.deadline; });
+
+        if (settings.maxMisses >= 0.0 && ! records.empty()
+            && static_cast<double>(numMisses) > settings.maxMisses * static_cast<double>(records.size()))
+        {
+            std::cout << "FAIL " << numMisses << " of " << records.size() << " blocks missed their deadline" << std::endl;
+            passed = false;
+        }
+
+        return passed;
+    }
+}
+
+void run(const juce::ArgumentList& args)
+{
+    Settings settings;
+
+    if (args.containsOption("--seconds"))
+        settings.seconds = args.getValueForOption("--seconds").getDoubleValue();
+
+    if (args.containsOption("--rate"))
+        settings.sampleRate = args.getValueForOption("--rate").getDoubleValue();
+
+    if (args.containsOption("--block-size"))
+        settings.blockSize = args.getValueForOption("--block-size").getIntValue();
+
+    if (args.containsOption("--max-misses"))
+        settings.maxMisses = args.getValueForOption("--max-misses").getDoubleValue();
+
+    if (settings.seconds <= 0.0 || settings.sampleRate <= 0.0 || settings.blockSize <= 0)
+        juce::ConsoleApplication::fail("--seconds, --rate and --block-size must be positive");
+
+    auto stereoPassed = play(settings, 2);
+    auto monoPassed = play(settings, 1);
+
+    if (! (stereoPassed && monoPassed))
+        juce::ConsoleApplication::fail("The stress test failed");
+}
+}
@@ -0,0 +1,45 @@
+/*
+  ==============================================================================
+
+    HostStressTest.h
+
+    Plays the processor in real time the way a busy host does, and records
+    how long every block took against its deadline.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "TestHost.h"
+
+/*
+    Three threads, each doing what a host may do from it:
+
+        audio       realtime priority, paced by the clock like a device
+                    callback. Block sizes vary from 1 sample to 4x the size
+                    given to prepareToPlay: half the blocks are the prepared
+                    size, 30% shorter, 20% longer.
+        automation  sets random parameters to random values every few ms.
+        message     the main thread. Runs the dispatch loop, takes the state
+                    with getStateInformation, puts it back with
+                    setStateInformation and pushes random orders.
+
+    Each run plays a stereo bus, then a mono bus (the bus that used to crash
+    in processStage). For every block the audio thread keeps the time spent
+    in processBlock. The report gives percentiles for the prepared-size and
+    the oversized blocks, the deadline misses (blocks that took longer than
+    they last), and the processor's own load histogram from
+    getGovernorStats().
+
+        stress [--seconds=<s>] [--block-size=<samples>] [--rate=<Hz>] [--max-misses=<fraction>]
+
+    Fails on any non-finite output sample. Misses are only reported, unless
+    --max-misses is given and more than that fraction of blocks missed.
+    Without a realtime-capable thread (no permission on Linux, say), the
+    audio thread falls back to the highest normal priority and says so.
+*/
+namespace HostStressTest
+{
+    void run(const juce::ArgumentList& args);
+}
@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+
+    LimiterBenchmark.cpp
+
+  ==============================================================================
+*/
+
+#include "LimiterBenchmark.h"
+#include "../../Source/LimiterEngine.h"
+
+namespace LimiterBenchmark
+{
+namespace
+{
+    constexpr float inputGainDb = 12.f;
+    constexpr float ceilingDb = -1.f;
+    constexpr float releaseMs = 50.f;
+
+    struct Settings
+    {
+        double seconds = 2.0;
+        int numRounds = 5;
+        double sampleRate = 48000.0;
+        int blockSize = 256;
+    };
+
+    // the fastest round, in ns per sample frame; the lookahead for each block comes from lookaheadFor(blockIndex)
+    template <typename LookaheadFor>
+    double time(const Settings& settings, const juce::AudioBuffer<float>& input, int numChannels, LookaheadFor&& lookaheadFor)
+    {
+        LimiterEngine limiter;
+        limiter.setCeiling(ceilingDb);
+        limiter.setRelease(releaseMs);
+        limiter.setLookahead(lookaheadFor(0));
+        limiter.prepare({ settings.sampleRate, static_cast<juce::uint32>(settings.blockSize), static_cast<juce::uint32>(numChannels) });
+
+        juce::AudioBuffer<float> block(numChannels, settings.blockSize);
+        auto numBlocks = juce::jmax(1, juce::roundToInt(settings.seconds * settings.sampleRate / settings.blockSize));
+        auto best = std::numeric_limits<juce::int64>::max();
+        auto position = 0;
+
+        for (int round = 0; round < settings.numRounds; ++round)
+        {
+            juce::int64 ticks = 0;
+
+            for (int i = 0; i < numBlocks; ++i)
+            {
+                for (int ch = 0; ch < numChannels; ++ch)
+                    block.copyFrom(ch, 0, input, ch, position, settings.blockSize);
+
+                position += settings.blockSize;
+
+                if (position + settings.blockSize > input.getNumSamples())
+                    position = 0;
+
+                juce::dsp::AudioBlock<float> audio(block);
+
+                auto start = juce::Time::getHighResolutionTicks();
+                limiter.setLookahead(lookaheadFor(i));
+                limiter.process(juce::dsp::ProcessContextReplacing<float>(audio));
+                ticks += juce::Time::getHighResolutionTicks() - start;
+            }
+
+            best = juce::jmin(best, ticks);
+        }
+
+        return juce::Time::highResolutionTicksToSeconds(best) * 1.0e9 / (static_cast<double>(numBlocks) * settings.blockSize);
+    }
+}
+
+void run(const juce::ArgumentList& args)
+{
+    Settings settings;
+
+    if (args.containsOption("--seconds"))
+        settings.seconds = args.getValueForOption("--seconds").getDoubleValue();
+
+    if (args.containsOption("--rounds"))
+        settings.numRounds = args.getValueForOption("--rounds").getIntValue();
+
+    if (args.containsOption("--block-size"))
+        settings.blockSize = args.getValueForOption("--block-size").getIntValue();
+
+    if (args.containsOption("--rate"))
+        settings.sampleRate = args.getValueForOption("--rate").getDoubleValue();
+
+    if (settings.seconds <= 0.0 || settings.numRounds <= 0 || settings.blockSize <= 0 || settings.sampleRate <= 0.0)
+        juce::ConsoleApplication::fail("--seconds, --rounds, --block-size and --rate must be positive");
+
+    auto input = TestHost::makeTestSignal(static_cast<int>(settings.sampleRate), settings.sampleRate);
+    input.applyGain(juce::Decibels::decibelsToGain(inputGainDb));
+
+    if (settings.blockSize > input.getNumSamples())
+        juce::ConsoleApplication::fail("--block-size must be at most a second of audio");
+
+    std::cout << settings.blockSize << " samples per block, " << settings.sampleRate << " Hz, fastest of "
+              << settings.numRounds << " rounds of " << settings.seconds << " s, ns per sample frame" << std::endl
+              << "                         stereo      mono" << std::endl;
+
+    auto report = [&](const juce::String& label, auto&& lookaheadFor)
+        {
+            std::cout << label.paddedRight(' ', 19)
+                      << juce::String(time(settings, input, 2, lookaheadFor), 2).paddedLeft(' ', 12)
+                      << juce::String(time(settings, input, 1, lookaheadFor), 2).paddedLeft(' ', 10) << std::endl;
+        };
+
+    for (auto lookaheadMs : { 0.f, 1.f, 5.f, LimiterEngine::maxLookaheadMs })
+        report("Lookahead " + juce::String(lookaheadMs, 0) + " ms", [=](int) { return lookaheadMs; });
+
+    report("Lookahead 4 / 6 ms", [](int blockIndex) { return blockIndex % 2 == 0 ? 4.f : 6.f; });
+}
+}
@@ -0,0 +1,31 @@
+/*
+  ==============================================================================
+
+    LimiterBenchmark.h
+
+    LimiterEngine on its own, at the ends and the middle of its lookahead
+    range.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "TestHost.h"
+
+/*
+    The test signal is raised by 12 dB so the limiter is working all the
+    time, with a -1 dB ceiling and a 50 ms release, in blocks of
+    --block-size, stereo and mono. Each lookahead is measured held still,
+    and the last row switches between 4 and 6 ms on every block, which
+    costs a crossfade and a window resum each time rather than a reset.
+
+    Reported is ns per sample frame, the fastest of --rounds rounds of
+    --seconds of audio each.
+
+        limiter [--seconds=<s>] [--rounds=<n>] [--block-size=<samples>] [--rate=<Hz>]
+*/
+namespace LimiterBenchmark
+{
+    void run(const juce::ArgumentList& args);
+}
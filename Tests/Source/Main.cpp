@@ -0,0 +1,88 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Command line tests and benchmarks for the plugin's processor, run
+    without a host. "PluginTests --help" lists the commands.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "RegressionTest.h"
+#include "HostStressTest.h"
+#include "ScalingBenchmark.h"
+#include "EditorFrameTime.h"
+#include "PrecisionBenchmark.h"
+#include "ChorusBenchmark.h"
+#include "AutomationReplay.h"
+#include "PipelineTest.h"
+#include "LimiterBenchmark.h"
+
+int main(int argc, char* argv[])
+{
+    // the processor's AsyncUpdater and the editors need a message manager, even with no window showing
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ConsoleApplication app;
+    app.addHelpCommand("--help|-h", "Tests and benchmarks for the plugin's processor", true);
+
+    app.addCommand({ "regression",
+                     "regression [--goldens=<dir>] [--update-goldens] [--update-timing] [--quick] [--tolerance-db=<dB>] [--max-error=<amplitude>] [--max-regression=<fraction>]",
+                     "Renders every order and bypass combination and compares them with the goldens",
+                     "See RegressionTest.h. Fails on any case off by more than the tolerance or the sample error, "
+                     "or if processBlock got slower than this machine's timing baseline by more than the limit.",
+                     RegressionTest::run });
+
+    app.addCommand({ "stress",
+                     "stress [--seconds=<s>] [--block-size=<samples>] [--rate=<Hz>] [--max-misses=<fraction>]",
+                     "Plays stereo and mono buses with variable blocks, automation and state changes on other threads",
+                     "See HostStressTest.h. Reports per-block processing time against the deadline and the misses, "
+                     "and fails on NaN or infinite output.",
+                     HostStressTest::run });
+
+    app.addCommand({ "scaling",
+                     "scaling [--counts=1,10,100,1000] [--threads=<n>] [--seconds=<s>] [--block-size=<samples>] [--rate=<Hz>] [--record=<file>]",
+                     "Construction time, RSS, cache misses and ns/sample per instance as the instance count grows",
+                     "See ScalingBenchmark.h. Only reports, it has nothing to fail on.",
+                     ScalingBenchmark::run });
+
+    app.addCommand({ "editor-frames",
+                     "editor-frames [--seconds=<s>] [--changes-per-second=<n>] [--offscreen]",
+                     "Message thread time per frame, GenericAudioProcessorEditor against the plugin's editor",
+                     "See EditorFrameTime.h. Only reports, it has nothing to fail on.",
+                     EditorFrameTime::run });
+
+    app.addCommand({ "precision",
+                     "precision [--seconds=<s>] [--rounds=<n>] [--block-size=<samples>] [--rate=<Hz>]",
+                     "The float chain's ns/sample against a 64-bit host's conversion to float and back",
+                     "See PrecisionBenchmark.h. Only reports, it has nothing to fail on.",
+                     PrecisionBenchmark::run });
+
+    app.addCommand({ "chorus",
+                     "chorus [--seconds=<s>] [--rounds=<n>] [--block-size=<samples>] [--rate=<Hz>]",
+                     "ChorusEngine's ns/sample at each quality mode against juce::dsp::Chorus",
+                     "See ChorusBenchmark.h. Only reports, it has nothing to fail on.",
+                     ChorusBenchmark::run });
+
+    app.addCommand({ "replay",
+                     "replay --automation=<file> --input=<audio file> --output=<wav file>",
+                     "Renders an audio file through a recorded session's automation, offline",
+                     "See AutomationReplay.h. Fails if a file can't be read or written.",
+                     AutomationReplay::run });
+
+    app.addCommand({ "pipeline",
+                     "pipeline [--cases=<n>]",
+                     "Renders random orders and bypass masks pipelined and serially, offline",
+                     "See PipelineTest.h. Fails if any sample of the two renders differs in any bit.",
+                     PipelineTest::run });
+
+    app.addCommand({ "limiter",
+                     "limiter [--seconds=<s>] [--rounds=<n>] [--block-size=<samples>] [--rate=<Hz>]",
+                     "LimiterEngine's ns/sample across its lookahead range, and with the lookahead changing",
+                     "See LimiterBenchmark.h. Only reports, it has nothing to fail on.",
+                     LimiterBenchmark::run });
+
+    return app.findAndRunCommand(argc, argv);
+}
@@ -0,0 +1,116 @@
+/*
+  ==============================================================================
+
+    PipelineTest.cpp
+
+  ==============================================================================
+*/
+
+#include "PipelineTest.h"
+
+namespace PipelineTest
+{
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+
+    // the processor pipelines waves of 64 sub-blocks of 64 samples
+    constexpr int waveSize = 64 * 64;
+    constexpr int numSamples = 2 * waveSize + waveSize / 2 + 37;
+
+    constexpr int serialBlockSize = 64;
+
+    // before the first case, long enough for the IR's swap and crossfade to be over
+    constexpr int warmUpSamples = 24000;
+
+    // DSP_Option order, shuffled unless shuffle is false
+    TestHost::DSP_Order makeOrder(juce::Random& random, bool shuffle)
+    {
+        TestHost::DSP_Order order;
+
+        for (size_t i = 0; i < order.size(); ++i)
+            order[i] = static_cast<TestHost::DSP_Option>(i);
+
+        if (shuffle)
+            for (int k = static_cast<int>(order.size()) - 1; k > 0; --k)
+                std::swap(order[static_cast<size_t>(k)], order[static_cast<size_t>(random.nextInt(k + 1))]);
+
+        return order;
+    }
+
+    // the first sample that differs in any bit, or -1
+    int findFirstDifference(const juce::AudioBuffer<float>& a, const juce::AudioBuffer<float>& b, int& channel)
+    {
+        for (channel = 0; channel < a.getNumChannels(); ++channel)
+            for (int i = 0; i < a.getNumSamples(); ++i)
+                if (std::memcmp(a.getReadPointer(channel, i), b.getReadPointer(channel, i), sizeof(float)) != 0)
+                    return i;
+
+        return -1;
+    }
+}
+
+void run(const juce::ArgumentList& args)
+{
+    auto numCases = args.containsOption("--cases") ? args.getValueForOption("--cases").getIntValue() : 64;
+
+    if (numCases <= 0)
+        juce::ConsoleApplication::fail("--cases must be positive");
+
+    TestHost host(sampleRate, numSamples, true);
+    host.applyTestPreset();
+    host.loadTestImpulseResponse();
+
+    auto input = TestHost::makeTestSignal(numSamples, sampleRate);
+    juce::AudioBuffer<float> serial(2, numSamples), pipelined(2, numSamples);
+
+    {
+        juce::AudioBuffer<float> warmUp(2, warmUpSamples);
+        warmUp.clear();
+
+        for (int ch = 0; ch < warmUp.getNumChannels(); ++ch)
+            warmUp.copyFrom(ch, 0, input, ch, 0, juce::jmin(numSamples, warmUpSamples));
+
+        host.setBypassMask(0);
+        host.render(warmUp, serialBlockSize);
+    }
+
+    // the same cases every run
+    juce::Random random(0x3047);
+    auto numFailed = 0;
+
+    for (int i = 0; i < numCases; ++i)
+    {
+        // the first case runs every stage in DSP_Option order
+        auto order = makeOrder(random, i > 0);
+        auto mask = i == 0 ? 0u : static_cast<juce::uint32>(random.nextInt(1 << TestHost::numStages));
+
+        host.setOrder(order);
+        host.setBypassMask(mask);
+
+        host.getProcessor().reset();
+        serial.makeCopyOf(input, true);
+        host.render(serial, serialBlockSize);
+
+        host.getProcessor().reset();
+        pipelined.makeCopyOf(input, true);
+        host.process(pipelined);
+
+        auto channel = 0;
+        auto sample = findFirstDifference(serial, pipelined, channel);
+
+        if (sample < 0)
+            continue;
+
+        ++numFailed;
+        std::cout << "FAIL case " << i << " (" << TestHost::describeOrder(order) << ", bypass mask " << juce::String::toHexString(static_cast<int>(mask))
+                  << "): channel " << channel << " sample " << sample << " is " << pipelined.getSample(channel, sample)
+                  << " pipelined, " << serial.getSample(channel, sample) << " serial" << std::endl;
+    }
+
+    if (numFailed > 0)
+        juce::ConsoleApplication::fail(juce::String(numFailed) + " of " + juce::String(numCases) + " cases differ between the pipelined and the serial render");
+
+    std::cout << "All " << numCases << " cases bit-identical, pipelined and serial, over " << numSamples << " samples" << std::endl;
+}
+}
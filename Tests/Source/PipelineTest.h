@@ -0,0 +1,32 @@
+/*
+  ==============================================================================
+
+    PipelineTest.h
+
+    Checks that an offline render through StagePipeline is bit-identical
+    to the serial chain.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "TestHost.h"
+
+/*
+    Each case is a seeded random order and bypass mask, with TestHost's
+    test preset and synthetic IR, rendered twice from a reset() processor:
+    once in 64-sample blocks, which the processor always runs serially,
+    and once as a single block, which it pipelines offline. The single
+    block is two and a half pipeline waves and an odd remainder long, so
+    the hand-over between waves and a short last sub-block are covered.
+
+    The pipeline promises exactly the serial loop's calls, so there is no
+    tolerance: one bit of difference in any sample fails the case.
+
+        pipeline [--cases=<n>]
+*/
+namespace PipelineTest
+{
+    void run(const juce::ArgumentList& args);
+}
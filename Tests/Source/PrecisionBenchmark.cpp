@@ -0,0 +1,208 @@
+/*
+  ==============================================================================
+
+    PrecisionBenchmark.cpp
+
+  ==============================================================================
+*/
+
+#include "PrecisionBenchmark.h"
+
+namespace PrecisionBenchmark
+{
+namespace
+{
+    constexpr double warmUpSeconds = 0.5;
+    constexpr double loaderTimeoutSeconds = 10.0;
+
+    struct Settings
+    {
+        double seconds = 2.0;
+        int numRounds = 5;
+        double sampleRate = 48000.0;
+        int blockSize = 256;
+    };
+
+    struct Ticks
+    {
+        juce::int64 process = 0;
+        juce::int64 conversion = 0;
+    };
+
+    //==============================================================================
+    class Run
+    {
+    public:
+        Run(const Settings& settingsToUse, const juce::AudioBuffer<float>& inputToPlay)
+            : settings(settingsToUse),
+              input(inputToPlay),
+              host(settings.sampleRate, settings.blockSize, false),
+              block(2, settings.blockSize),
+              doubleTrack(2, settings.blockSize)
+        {
+            host.applyTestPreset();
+            warmUp();
+        }
+
+        // processBlock straight from the float track buffer
+        Ticks playFloat(int numBlocks)
+        {
+            Ticks ticks;
+
+            for (int i = 0; i < numBlocks; ++i)
+            {
+                copyNextInput(block);
+
+                auto start = juce::Time::getHighResolutionTicks();
+                host.process(block);
+                ticks.process += juce::Time::getHighResolutionTicks() - start;
+            }
+
+            return ticks;
+        }
+
+        // the track buffer is double; the host converts it for the plugin and converts the result back
+        Ticks playDouble(int numBlocks)
+        {
+            Ticks ticks;
+
+            for (int i = 0; i < numBlocks; ++i)
+            {
+                for (int ch = 0; ch < doubleTrack.getNumChannels(); ++ch)
+                {
+                    auto* source = input.getReadPointer(ch, position);
+                    auto* dest = doubleTrack.getWritePointer(ch);
+
+                    for (int s = 0; s < settings.blockSize; ++s)
+                        dest[s] = static_cast<double>(source[s]);
+                }
+
+                advance();
+
+                auto start = juce::Time::getHighResolutionTicks();
+                block.makeCopyOf(doubleTrack, true);
+                auto converted = juce::Time::getHighResolutionTicks();
+
+                host.process(block);
+                auto processed = juce::Time::getHighResolutionTicks();
+
+                doubleTrack.makeCopyOf(block, true);
+                auto end = juce::Time::getHighResolutionTicks();
+
+                ticks.process += processed - converted;
+                ticks.conversion += (converted - start) + (end - processed);
+            }
+
+            return ticks;
+        }
+
+    private:
+        void copyNextInput(juce::AudioBuffer<float>& dest)
+        {
+            for (int ch = 0; ch < dest.getNumChannels(); ++ch)
+                dest.copyFrom(ch, 0, input, ch, position, settings.blockSize);
+
+            advance();
+        }
+
+        void advance()
+        {
+            position += settings.blockSize;
+
+            if (position + settings.blockSize > input.getNumSamples())
+                position = 0;
+        }
+
+        void warmUp()
+        {
+            auto numBlocks = juce::roundToInt(warmUpSeconds * settings.sampleRate / settings.blockSize);
+
+            // the first blocks ask the loader for the stages, then wait for it to go quiet
+            playFloat(numBlocks);
+
+            auto deadline = juce::Time::getMillisecondCounterHiRes() + loaderTimeoutSeconds * 1000.0;
+            auto lastReady = -1;
+
+            for (;;)
+            {
+                auto ready = host.getProcessor().getLoadTimes().numStagesReady;
+
+                if (ready == lastReady || juce::Time::getMillisecondCounterHiRes() > deadline)
+                    break;
+
+                lastReady = ready;
+                juce::Thread::sleep(200);
+            }
+
+            // the stages just made ready fade in
+            playFloat(numBlocks);
+        }
+
+        const Settings& settings;
+        const juce::AudioBuffer<float>& input;
+
+        TestHost host;
+        juce::AudioBuffer<float> block;
+        juce::AudioBuffer<double> doubleTrack;
+        int position = 0;
+    };
+
+    double toNsPerSample(juce::int64 ticks, int numBlocks, const Settings& settings)
+    {
+        return juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e9 / (static_cast<double>(numBlocks) * settings.blockSize);
+    }
+}
+
+void run(const juce::ArgumentList& args)
+{
+    Settings settings;
+
+    if (args.containsOption("--seconds"))
+        settings.seconds = args.getValueForOption("--seconds").getDoubleValue();
+
+    if (args.containsOption("--rounds"))
+        settings.numRounds = args.getValueForOption("--rounds").getIntValue();
+
+    if (args.containsOption("--block-size"))
+        settings.blockSize = args.getValueForOption("--block-size").getIntValue();
+
+    if (args.containsOption("--rate"))
+        settings.sampleRate = args.getValueForOption("--rate").getDoubleValue();
+
+    if (settings.seconds <= 0.0 || settings.numRounds <= 0 || settings.blockSize <= 0 || settings.sampleRate <= 0.0)
+        juce::ConsoleApplication::fail("--seconds, --rounds, --block-size and --rate must be positive");
+
+    auto input = TestHost::makeTestSignal(static_cast<int>(settings.sampleRate), settings.sampleRate);
+
+    if (settings.blockSize > input.getNumSamples())
+        juce::ConsoleApplication::fail("--block-size must be at most a second of audio");
+
+    Run floatRun(settings, input);
+    Run doubleRun(settings, input);
+
+    auto numBlocks = juce::jmax(1, juce::roundToInt(settings.seconds * settings.sampleRate / settings.blockSize));
+    auto bestFloat = std::numeric_limits<juce::int64>::max();
+    Ticks bestDouble{ std::numeric_limits<juce::int64>::max(), 0 };
+
+    for (int round = 0; round < settings.numRounds; ++round)
+    {
+        bestFloat = juce::jmin(bestFloat, floatRun.playFloat(numBlocks).process);
+
+        auto ticks = doubleRun.playDouble(numBlocks);
+
+        if (ticks.process + ticks.conversion < bestDouble.process + bestDouble.conversion)
+            bestDouble = ticks;
+    }
+
+    auto floatNs = toNsPerSample(bestFloat, numBlocks, settings);
+    auto doubleNs = toNsPerSample(bestDouble.process + bestDouble.conversion, numBlocks, settings);
+    auto conversionNs = toNsPerSample(bestDouble.conversion, numBlocks, settings);
+
+    std::cout << settings.blockSize << " samples per block, " << settings.sampleRate << " Hz, fastest of "
+              << settings.numRounds << " rounds of " << settings.seconds << " s, ns per sample frame" << std::endl
+              << "float        " << juce::String(floatNs, 2) << std::endl
+              << "double host  " << juce::String(doubleNs, 2) << std::endl
+              << "conversion   " << juce::String(conversionNs, 2)
+              << "  (" << juce::String(doubleNs > 0.0 ? 100.0 * conversionNs / doubleNs : 0.0, 1) << "% of the double host time)" << std::endl;
+}
+}
@@ -0,0 +1,39 @@
+/*
+  ==============================================================================
+
+    PrecisionBenchmark.h
+
+    What a 64-bit host pays to run the plugin's float chain: the processing
+    itself against the host's conversion of each block to float and back.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "TestHost.h"
+
+/*
+    The processor doesn't support double precision processing, so a host
+    with a double mix engine converts each block to float before
+    processBlock and back to double after it. This plays the test signal in
+    real-time mode with the test preset and the default order, once from a
+    float track buffer and once from a double one converted as such a host
+    would, and reports per sample frame:
+
+        float           processBlock fed from a float buffer
+        double host     the conversion in, processBlock and the conversion out
+        conversion      the two conversions alone, and their share of the
+                        double host time
+
+    Each run has its own instance, warmed up until the stage loader has
+    nothing left to prepare. The two runs alternate for --rounds rounds of
+    --seconds each, and the fastest round of each is reported, so that a
+    busy moment on the machine doesn't fall on one of them only.
+
+        precision [--seconds=<s>] [--rounds=<n>] [--block-size=<samples>] [--rate=<Hz>]
+*/
+namespace PrecisionBenchmark
+{
+    void run(const juce::ArgumentList& args);
+}
@@ -0,0 +1,403 @@
+/*
+  ==============================================================================
+
+    RegressionTest.cpp
+
+  ==============================================================================
+*/
+
+#include "RegressionTest.h"
+
+namespace RegressionTest
+{
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int numSamples = 4096;
+
+    // the host block size: one sub-block, so the serial chain is timed, never the offline pipeline
+    constexpr int blockSize = 64;
+
+    constexpr int numSegments = 8;
+    constexpr int fingerprintSize = 2 * (numSegments + 1);
+    constexpr int quickStride = 16;
+
+    constexpr int mixedCases = 4096;
+    constexpr int sampleStride = 256;
+
+    // the sample cases are in every quick run
+    static_assert(sampleStride % quickStride == 0 && (1 << TestHost::numStages) % quickStride == 0);
+
+    // before the first case, long enough for the IR's swap and crossfade to be over
+    constexpr int warmUpSamples = 24000;
+
+    constexpr int goldenMagic = 0x444c4752;     // "RGLD"
+    constexpr int goldenVersion = 2;
+
+    using Fingerprint = std::array<juce::int16, fingerprintSize>;
+
+    struct Case
+    {
+        TestHost::DSP_Order order;
+        juce::uint32 bypassMask = 0;
+    };
+
+    std::vector<Case> getCases()
+    {
+        TestHost::DSP_Order all;
+
+        for (size_t i = 0; i < all.size(); ++i)
+            all[i] = static_cast<TestHost::DSP_Option>(i);
+
+        std::vector<Case> cases;
+
+        for (juce::uint32 mask = 0; mask < (1u << TestHost::numStages); ++mask)
+            cases.push_back({ all, mask });
+
+        auto order = all;
+
+        do
+        {
+            cases.push_back({ order, 0 });
+        }
+        while (std::next_permutation(order.begin(), order.end()));
+
+        // the same pairs every run: a Fisher-Yates shuffle and a mask from one seed
+        juce::Random random(0x3035);
+
+        for (int i = 0; i < mixedCases; ++i)
+        {
+            order = all;
+
+            for (int k = static_cast<int>(order.size()) - 1; k > 0; --k)
+                std::swap(order[static_cast<size_t>(k)], order[static_cast<size_t>(random.nextInt(k + 1))]);
+
+            cases.push_back({ order, static_cast<juce::uint32>(random.nextInt(1 << TestHost::numStages)) });
+        }
+
+        return cases;
+    }
+
+    bool isInQuickRun(size_t index)
+    {
+        return index < (size_t(1) << TestHost::numStages) || index % quickStride == 0;
+    }
+
+    bool isSampleCase(size_t index)
+    {
+        return index % sampleStride == 0;
+    }
+
+    size_t getNumSampleCases(size_t numCases)
+    {
+        return (numCases + sampleStride - 1) / sampleStride;
+    }
+
+    // the largest difference between two renders, sample for sample
+    float getMaxError(const juce::AudioBuffer<float>& audio, const juce::AudioBuffer<float>& golden)
+    {
+        auto maxError = 0.f;
+
+        for (int ch = 0; ch < audio.getNumChannels(); ++ch)
+        {
+            auto* a = audio.getReadPointer(ch);
+            auto* b = golden.getReadPointer(ch);
+
+            for (int i = 0; i < audio.getNumSamples(); ++i)
+                maxError = juce::jmax(maxError, std::abs(a[i] - b[i]));
+        }
+
+        return maxError;
+    }
+
+    juce::int16 toCentiDecibels(float gain)
+    {
+        return static_cast<juce::int16>(juce::roundToInt(100.f * juce::Decibels::gainToDecibels(gain, -120.f)));
+    }
+
+    Fingerprint makeFingerprint(const juce::AudioBuffer<float>& audio)
+    {
+        Fingerprint fingerprint{};
+        auto segmentLength = audio.getNumSamples() / numSegments;
+        size_t i = 0;
+
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            for (int s = 0; s < numSegments; ++s)
+                fingerprint[i++] = toCentiDecibels(audio.getRMSLevel(ch, s * segmentLength, segmentLength));
+
+            fingerprint[i++] = toCentiDecibels(audio.getMagnitude(ch, 0, audio.getNumSamples()));
+        }
+
+        return fingerprint;
+    }
+
+    juce::String describe(const Case& c)
+    {
+        juce::StringArray bypassed;
+
+        for (int i = 0; i < TestHost::numStages; ++i)
+            if ((c.bypassMask >> i) & 1u)
+                bypassed.add(TestHost::getStageName(static_cast<TestHost::DSP_Option>(i)));
+
+        return TestHost::describeOrder(c.order)
+            + (bypassed.isEmpty() ? juce::String() : ", bypassed: " + bypassed.joinIntoString(" "));
+    }
+
+    //==============================================================================
+    juce::File getGoldenFile(const juce::File& folder)
+    {
+        return folder.getChildFile("regression.goldens");
+    }
+
+    juce::File getTimingFile(const juce::File& folder)
+    {
+        return folder.getChildFile("timing-" + juce::File::createLegalFileName(juce::SystemStats::getComputerName()) + ".txt");
+    }
+
+    struct Goldens
+    {
+        std::vector<Fingerprint> fingerprints;
+
+        // the sample cases in case order, 2 x numSamples each
+        std::vector<juce::AudioBuffer<float>> samples;
+    };
+
+    void writeGoldens(const juce::File& file, const Goldens& goldens)
+    {
+        file.getParentDirectory().createDirectory();
+        file.deleteFile();
+
+        juce::FileOutputStream out(file);
+
+        if (! out.openedOk())
+            juce::ConsoleApplication::fail("Can't write " + file.getFullPathName());
+
+        out.writeInt(goldenMagic);
+        out.writeInt(goldenVersion);
+        out.writeDouble(sampleRate);
+        out.writeInt(numSamples);
+        out.writeInt(blockSize);
+        out.writeInt(static_cast<int>(goldens.fingerprints.size()));
+        out.writeInt(fingerprintSize);
+        out.writeInt(sampleStride);
+
+        for (auto& fingerprint : goldens.fingerprints)
+            for (auto value : fingerprint)
+                out.writeShort(value);
+
+        for (auto& audio : goldens.samples)
+            for (int ch = 0; ch < audio.getNumChannels(); ++ch)
+                for (int i = 0; i < audio.getNumSamples(); ++i)
+                    out.writeFloat(audio.getSample(ch, i));
+    }
+
+    Goldens readGoldens(const juce::File& file, size_t numCases)
+    {
+        juce::FileInputStream in(file);
+
+        if (! in.openedOk())
+            juce::ConsoleApplication::fail("No goldens at " + file.getFullPathName()
+                                           + ", record them with --update-goldens");
+
+        if (in.readInt() != goldenMagic || in.readInt() != goldenVersion || in.readDouble() != sampleRate
+            || in.readInt() != numSamples || in.readInt() != blockSize
+            || in.readInt() != static_cast<int>(numCases) || in.readInt() != fingerprintSize || in.readInt() != sampleStride)
+            juce::ConsoleApplication::fail(file.getFullPathName() + " was recorded with other settings, record it again with --update-goldens");
+
+        auto numSampleCases = getNumSampleCases(numCases);
+        auto expectedLength = in.getPosition()
+                            + static_cast<juce::int64>(numCases * fingerprintSize * sizeof(juce::int16))
+                            + static_cast<juce::int64>(numSampleCases * 2 * numSamples * sizeof(float));
+
+        if (in.getTotalLength() != expectedLength)
+            juce::ConsoleApplication::fail(file.getFullPathName() + " is the wrong length, record it again with --update-goldens");
+
+        Goldens goldens;
+        goldens.fingerprints.resize(numCases);
+
+        for (auto& fingerprint : goldens.fingerprints)
+            for (auto& value : fingerprint)
+                value = in.readShort();
+
+        goldens.samples.resize(numSampleCases);
+
+        for (auto& audio : goldens.samples)
+        {
+            audio.setSize(2, numSamples);
+
+            for (int ch = 0; ch < audio.getNumChannels(); ++ch)
+                for (int i = 0; i < audio.getNumSamples(); ++i)
+                    audio.setSample(ch, i, in.readFloat());
+        }
+
+        return goldens;
+    }
+}
+
+void run(const juce::ArgumentList& args)
+{
+    auto folder = args.containsOption("--goldens") ? args.getFileForOption("--goldens")
+                                                   : juce::File::getCurrentWorkingDirectory().getChildFile("Goldens");
+    auto updateGoldens = args.containsOption("--update-goldens");
+    auto updateTiming = updateGoldens || args.containsOption("--update-timing");
+    auto quick = args.containsOption("--quick");
+
+    auto toleranceDb = args.containsOption("--tolerance-db") ? args.getValueForOption("--tolerance-db").getFloatValue() : 0.1f;
+    auto maxError = args.containsOption("--max-error") ? args.getValueForOption("--max-error").getFloatValue() : 1.0e-4f;
+    auto maxRegression = args.containsOption("--max-regression") ? args.getValueForOption("--max-regression").getDoubleValue() : 0.15;
+
+    if (updateGoldens && quick)
+        juce::ConsoleApplication::fail("--update-goldens needs every case, drop --quick");
+
+    auto cases = getCases();
+
+    Goldens goldens;
+
+    if (updateGoldens)
+    {
+        goldens.fingerprints.resize(cases.size());
+        goldens.samples.resize(getNumSampleCases(cases.size()));
+    }
+    else
+    {
+        goldens = readGoldens(getGoldenFile(folder), cases.size());
+    }
+
+    TestHost host(sampleRate, blockSize, true);
+    host.applyTestPreset();
+    host.loadTestImpulseResponse();
+
+    auto input = TestHost::makeTestSignal(numSamples, sampleRate);
+    juce::AudioBuffer<float> audio(2, numSamples);
+
+    // the IR was read synchronously, this swaps it in; reset() keeps the kernel
+    {
+        juce::AudioBuffer<float> warmUp(2, warmUpSamples);
+
+        for (int start = 0; start < warmUpSamples; start += numSamples)
+            for (int ch = 0; ch < warmUp.getNumChannels(); ++ch)
+                warmUp.copyFrom(ch, start, input, ch, 0, juce::jmin(numSamples, warmUpSamples - start));
+
+        host.setBypassMask(0);
+        host.render(warmUp, blockSize);
+    }
+
+    juce::int64 processTicks = 0;
+    juce::int64 numFramesRendered = 0;
+
+    auto numFailed = 0;
+    auto worstDeviation = 0;
+    auto worstError = 0.f;
+    auto worstPipelinedError = 0.f;
+
+    auto fail = [&](size_t index, const juce::String& what)
+        {
+            if (++numFailed <= 10)
+                std::cout << "FAIL case " << index << " (" << describe(cases[index]) << "): " << what << std::endl;
+        };
+
+    auto renderCase = [&](const Case& c, int hostBlockSize)
+        {
+            host.setOrder(c.order);
+            host.setBypassMask(c.bypassMask);
+            host.getProcessor().reset();
+
+            audio.makeCopyOf(input, true);
+            host.render(audio, hostBlockSize);
+        };
+
+    for (size_t i = 0; i < cases.size(); ++i)
+    {
+        if (quick && ! isInQuickRun(i))
+            continue;
+
+        auto& c = cases[i];
+
+        auto start = juce::Time::getHighResolutionTicks();
+        renderCase(c, blockSize);
+        processTicks += juce::Time::getHighResolutionTicks() - start;
+        numFramesRendered += numSamples;
+
+        auto fingerprint = makeFingerprint(audio);
+
+        if (updateGoldens)
+        {
+            goldens.fingerprints[i] = fingerprint;
+
+            if (isSampleCase(i))
+                goldens.samples[i / sampleStride].makeCopyOf(audio, true);
+
+            continue;
+        }
+
+        auto deviation = 0;
+
+        for (size_t k = 0; k < fingerprint.size(); ++k)
+            deviation = juce::jmax(deviation, std::abs(fingerprint[k] - goldens.fingerprints[i][k]));
+
+        worstDeviation = juce::jmax(worstDeviation, deviation);
+
+        if (deviation > juce::roundToInt(toleranceDb * 100.f))
+            fail(i, "off by " + juce::String(deviation / 100.f) + " dB");
+
+        if (! isSampleCase(i))
+            continue;
+
+        auto& golden = goldens.samples[i / sampleStride];
+        auto error = getMaxError(audio, golden);
+        worstError = juce::jmax(worstError, error);
+
+        if (error > maxError)
+            fail(i, "a sample is off by " + juce::String(error));
+
+        // the same case in one block, which goes through the offline pipeline
+        renderCase(c, numSamples);
+        auto pipelinedError = getMaxError(audio, golden);
+        worstPipelinedError = juce::jmax(worstPipelinedError, pipelinedError);
+
+        if (pipelinedError > maxError)
+            fail(i, "in one " + juce::String(numSamples) + "-sample block, a sample is off by " + juce::String(pipelinedError));
+    }
+
+    auto nsPerSample = juce::Time::highResolutionTicksToSeconds(processTicks) * 1.0e9 / static_cast<double>(numFramesRendered);
+    std::cout << "processBlock: " << nsPerSample << " ns per sample frame over " << numFramesRendered << " frames" << std::endl;
+
+    if (updateGoldens)
+    {
+        writeGoldens(getGoldenFile(folder), goldens);
+        std::cout << "Recorded " << cases.size() << " goldens, " << goldens.samples.size() << " of them sample for sample, in "
+                  << getGoldenFile(folder).getFullPathName() << std::endl;
+    }
+
+    auto timingFile = getTimingFile(folder);
+
+    if (updateTiming)
+    {
+        timingFile.replaceWithText(juce::String(nsPerSample));
+        std::cout << "Recorded the timing baseline in " << timingFile.getFullPathName() << std::endl;
+    }
+    else if (timingFile.existsAsFile())
+    {
+        auto baseline = timingFile.loadFileAsString().getDoubleValue();
+        std::cout << "Timing baseline: " << baseline << " ns per sample frame" << std::endl;
+
+        if (nsPerSample > baseline * (1.0 + maxRegression))
+            juce::ConsoleApplication::fail("processBlock is " + juce::String((nsPerSample / baseline - 1.0) * 100.0, 1)
+                                           + "% slower than the baseline, the limit is " + juce::String(maxRegression * 100.0, 1) + "%");
+    }
+    else
+    {
+        std::cout << "No timing baseline for this machine, record one with --update-timing" << std::endl;
+    }
+
+    if (numFailed > 0)
+        juce::ConsoleApplication::fail(juce::String(numFailed) + " checks differ from their goldens by more than "
+                                       + juce::String(toleranceDb) + " dB or " + juce::String(maxError));
+
+    if (! updateGoldens)
+        std::cout << "All cases within " << toleranceDb << " dB of their goldens, worst " << worstDeviation / 100.f << " dB; "
+                  << "samples within " << maxError << ", worst " << worstError << " in " << blockSize << "-sample blocks and "
+                  << worstPipelinedError << " in one block" << std::endl;
+}
+}
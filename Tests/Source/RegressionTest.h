@@ -0,0 +1,55 @@
+/*
+  ==============================================================================
+
+    RegressionTest.h
+
+    Renders a fixed signal through orders and bypass combinations and
+    compares the results with stored goldens.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "TestHost.h"
+
+/*
+    The cases are every bypass mask over the eight stages in DSP_Option
+    order, every permutation of the eight stages with none bypassed, then
+    mixedCases seeded random pairs of a permutation and a mask: 256 + 40320
+    + 4096 renders of the same fixed input (TestHost::makeTestSignal), each
+    from a reset() processor, offline so they are repeatable. The processor
+    has TestHost's test preset, every filter band boosting or cutting, and
+    TestHost's synthetic IR swapped in before the first case, so no stage
+    is a plain copy.
+
+    Every case is kept as a fingerprint: the RMS of each of numSegments
+    equal segments and the peak, per channel, in hundredths of a dB. It
+    passes if every value is within --tolerance-db (0.1 dB by default) of
+    its golden.
+
+    Every sampleStride-th case is also kept sample for sample, and passes
+    if no sample is further than --max-error (1e-4, -80 dBFS, by default)
+    from its golden. Keeping all 44672 cases that way would take 1.5 GB;
+    one in 256 is 175 cases and 5.7 MB. Those cases are then rendered
+    again as a single block of numSamples, which the processor pipelines
+    offline (see StagePipeline), and compared with the same goldens.
+
+    The time spent in processBlock is also measured, as ns per sample
+    frame over all cases in 64-sample blocks. Timing is only comparable on
+    one machine, so its baseline is stored per computer name next to the
+    goldens. With a baseline, the test fails if the chain got slower by
+    more than --max-regression (0.15 by default). Without one it only
+    reports.
+
+        regression [--goldens=<dir>] [--update-goldens] [--update-timing] [--quick]
+                   [--tolerance-db=<dB>] [--max-error=<amplitude>] [--max-regression=<fraction>]
+
+    The goldens are in ./Goldens unless --goldens says otherwise. --quick
+    renders the bypass masks and every 16th of the other cases, which
+    include all the ones kept sample for sample.
+*/
+namespace RegressionTest
+{
+    void run(const juce::ArgumentList& args);
+}
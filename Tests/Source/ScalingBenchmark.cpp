@@ -0,0 +1,412 @@
+/*
+  ==============================================================================
+
+    ScalingBenchmark.cpp
+
+  ==============================================================================
+*/
+
+#include "ScalingBenchmark.h"
+
+#if JUCE_LINUX
+ #include <linux/perf_event.h>
+ #include <sys/ioctl.h>
+ #include <sys/syscall.h>
+ #include <unistd.h>
+#elif JUCE_WINDOWS
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #include <windows.h>
+ #include <psapi.h>
+ #pragma comment(lib, "psapi.lib")
+#elif JUCE_MAC
+ #include <mach/mach.h>
+#endif
+
+namespace ScalingBenchmark
+{
+namespace
+{
+    constexpr double warmUpSeconds = 0.5;
+    constexpr double loaderTimeoutSeconds = 10.0;
+
+    struct Settings
+    {
+        juce::Array<int> counts{ 1, 10, 100, 1000 };
+        int numThreads = 1;
+        double seconds = 1.0;
+        double sampleRate = 48000.0;
+        int blockSize = 256;
+    };
+
+    juce::int64 getResidentBytes()
+    {
+       #if JUCE_LINUX
+        auto fields = juce::StringArray::fromTokens(juce::File("/proc/self/statm").loadFileAsString(), false);
+
+        if (fields.size() > 1)
+            return fields[1].getLargeIntValue() * sysconf(_SC_PAGESIZE);
+       #elif JUCE_WINDOWS
+        PROCESS_MEMORY_COUNTERS counters{};
+
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+            return static_cast<juce::int64>(counters.WorkingSetSize);
+       #elif JUCE_MAC
+        mach_task_basic_info info{};
+        mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+
+        if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) == KERN_SUCCESS)
+            return static_cast<juce::int64>(info.resident_size);
+       #endif
+
+        return -1;
+    }
+
+    //==============================================================================
+    // read accesses and misses of L1D and the last level cache, for the calling thread; -1 where not available
+    struct CacheCounts
+    {
+        enum { l1Accesses, l1Misses, llAccesses, llMisses, numCounts };
+        std::array<juce::int64, numCounts> values{ -1, -1, -1, -1 };
+
+        void add(const CacheCounts& other)
+        {
+            for (size_t i = 0; i < values.size(); ++i)
+                values[i] = (values[i] < 0 || other.values[i] < 0) ? -1 : values[i] + other.values[i];
+        }
+
+        juce::String getMissRate(int accesses, int misses) const
+        {
+            if (values[size_t(accesses)] <= 0 || values[size_t(misses)] < 0)
+                return "n/a";
+
+            return juce::String(100.0 * static_cast<double>(values[size_t(misses)]) / static_cast<double>(values[size_t(accesses)]), 2) + "%";
+        }
+    };
+
+    class CacheCounters
+    {
+    public:
+       #if JUCE_LINUX
+        CacheCounters()
+        {
+            fds[CacheCounts::l1Accesses] = open(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_RESULT_ACCESS);
+            fds[CacheCounts::l1Misses]   = open(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_RESULT_MISS);
+            fds[CacheCounts::llAccesses] = open(PERF_COUNT_HW_CACHE_LL,  PERF_COUNT_HW_CACHE_RESULT_ACCESS);
+            fds[CacheCounts::llMisses]   = open(PERF_COUNT_HW_CACHE_LL,  PERF_COUNT_HW_CACHE_RESULT_MISS);
+        }
+
+        ~CacheCounters()
+        {
+            for (auto fd : fds)
+                if (fd >= 0)
+                    close(fd);
+        }
+
+        void start()
+        {
+            for (auto fd : fds)
+            {
+                if (fd >= 0)
+                {
+                    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+                }
+            }
+        }
+
+        CacheCounts stop()
+        {
+            CacheCounts counts;
+
+            for (size_t i = 0; i < fds.size(); ++i)
+            {
+                juce::uint64 value = 0;
+
+                if (fds[i] >= 0 && ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0) == 0
+                    && read(fds[i], &value, sizeof(value)) == static_cast<ssize_t>(sizeof(value)))
+                    counts.values[i] = static_cast<juce::int64>(value);
+            }
+
+            return counts;
+        }
+
+    private:
+        static int open(juce::uint64 cache, juce::uint64 result)
+        {
+            perf_event_attr attributes{};
+            attributes.size = sizeof(attributes);
+            attributes.type = PERF_TYPE_HW_CACHE;
+            attributes.config = cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (result << 16);
+            attributes.disabled = 1;
+            attributes.exclude_kernel = 1;
+            attributes.exclude_hv = 1;
+
+            // this thread only, on any CPU
+            return static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+        }
+
+        std::array<int, CacheCounts::numCounts> fds;
+       #else
+        void start() {}
+        CacheCounts stop() { return {}; }
+       #endif
+    };
+
+    //==============================================================================
+    struct Instance
+    {
+        explicit Instance(const Settings& settings)
+            : host(std::make_unique<TestHost>(settings.sampleRate, settings.blockSize, false)),
+              audio(2, settings.blockSize)
+        {
+            host->applyTestPreset();
+        }
+
+        std::unique_ptr<TestHost> host;
+        juce::AudioBuffer<float> audio;     // this instance's track buffer, as a host would keep one per track
+    };
+
+    void play(Instance& instance, const juce::AudioBuffer<float>& input, int position)
+    {
+        for (int ch = 0; ch < instance.audio.getNumChannels(); ++ch)
+            instance.audio.copyFrom(ch, 0, input, ch, position, instance.audio.getNumSamples());
+
+        instance.host->process(instance.audio);
+    }
+
+    //==============================================================================
+    class Worker : public juce::Thread
+    {
+    public:
+        Worker(std::vector<Instance*> instancesToPlay, const juce::AudioBuffer<float>& inputToPlay, int numRoundsToPlay)
+            : juce::Thread("scaling worker"),
+              instances(std::move(instancesToPlay)),
+              input(inputToPlay),
+              numRounds(numRoundsToPlay)
+        {
+        }
+
+        juce::int64 getProcessTicks() const noexcept { return processTicks; }
+        const CacheCounts& getCacheCounts() const noexcept { return cacheCounts; }
+
+        void run() override
+        {
+            CacheCounters counters;
+            counters.start();
+
+            auto blockSize = instances.empty() ? 0 : instances.front()->audio.getNumSamples();
+            auto position = 0;
+
+            for (int round = 0; round < numRounds && ! threadShouldExit(); ++round)
+            {
+                for (auto* instance : instances)
+                {
+                    for (int ch = 0; ch < instance->audio.getNumChannels(); ++ch)
+                        instance->audio.copyFrom(ch, 0, input, ch, position, blockSize);
+
+                    auto start = juce::Time::getHighResolutionTicks();
+                    instance->host->process(instance->audio);
+                    processTicks += juce::Time::getHighResolutionTicks() - start;
+                }
+
+                position += blockSize;
+
+                if (position + blockSize > input.getNumSamples())
+                    position = 0;
+            }
+
+            cacheCounts = counters.stop();
+        }
+
+    private:
+        std::vector<Instance*> instances;
+        const juce::AudioBuffer<float>& input;
+        int numRounds;
+
+        juce::int64 processTicks = 0;
+        CacheCounts cacheCounts;
+    };
+
+    //==============================================================================
+    int getTotalStagesReady(const std::vector<std::unique_ptr<Instance>>& instances)
+    {
+        auto total = 0;
+
+        for (auto& instance : instances)
+            total += instance->host->getProcessor().getLoadTimes().numStagesReady;
+
+        return total;
+    }
+
+    void warmUp(std::vector<std::unique_ptr<Instance>>& instances, const juce::AudioBuffer<float>& input, const Settings& settings)
+    {
+        auto numBlocks = juce::roundToInt(warmUpSeconds * settings.sampleRate / settings.blockSize);
+
+        auto playAll = [&]
+            {
+                for (int block = 0; block < numBlocks; ++block)
+                    for (auto& instance : instances)
+                        play(*instance, input, block * settings.blockSize % (input.getNumSamples() - settings.blockSize));
+            };
+
+        // the first blocks ask the loader for the stages, then wait for it to go quiet
+        playAll();
+
+        auto deadline = juce::Time::getMillisecondCounterHiRes() + loaderTimeoutSeconds * 1000.0;
+        auto lastReady = -1;
+
+        for (;;)
+        {
+            auto ready = getTotalStagesReady(instances);
+
+            if (ready == lastReady || juce::Time::getMillisecondCounterHiRes() > deadline)
+                break;
+
+            lastReady = ready;
+            juce::Thread::sleep(200);
+        }
+
+        // the stages just made ready fade in, and the quality they skipped is applied
+        playAll();
+    }
+
+    juce::String formatMegabytes(juce::int64 bytes)
+    {
+        return bytes < 0 ? juce::String("n/a") : juce::String(static_cast<double>(bytes) / (1024.0 * 1024.0), 1) + " MB";
+    }
+
+    // the row of the table for this count
+    juce::String runCount(int numInstances, const Settings& settings)
+    {
+        auto input = TestHost::makeTestSignal(static_cast<int>(settings.sampleRate), settings.sampleRate);
+        auto residentBefore = getResidentBytes();
+
+        std::vector<std::unique_ptr<Instance>> instances;
+        instances.reserve(static_cast<size_t>(numInstances));
+
+        for (int i = 0; i < numInstances; ++i)
+            instances.push_back(std::make_unique<Instance>(settings));
+
+        auto constructMs = 0.0, prepareMs = 0.0;
+
+        for (auto& instance : instances)
+        {
+            auto times = instance->host->getProcessor().getLoadTimes();
+            constructMs += times.constructionMs;
+            prepareMs += times.prepareToPlayMs;
+        }
+
+        warmUp(instances, input, settings);
+
+        auto numThreads = juce::jlimit(1, numInstances, settings.numThreads);
+        auto numRounds = juce::jmax(1, juce::roundToInt(settings.seconds * settings.sampleRate / settings.blockSize));
+
+        std::vector<std::vector<Instance*>> shares(static_cast<size_t>(numThreads));
+
+        for (size_t i = 0; i < instances.size(); ++i)
+            shares[i % shares.size()].push_back(instances[i].get());
+
+        std::vector<std::unique_ptr<Worker>> workers;
+
+        for (auto& share : shares)
+            workers.push_back(std::make_unique<Worker>(share, input, numRounds));
+
+        auto start = juce::Time::getMillisecondCounterHiRes();
+
+        for (auto& worker : workers)
+            worker->startThread(juce::Thread::Priority::highest);
+
+        for (auto& worker : workers)
+            worker->waitForThreadToExit(-1);
+
+        auto wallSeconds = (juce::Time::getMillisecondCounterHiRes() - start) / 1000.0;
+        auto residentAfter = getResidentBytes();
+
+        juce::int64 processTicks = 0;
+        CacheCounts cacheCounts;
+        cacheCounts.values = {};
+
+        for (auto& worker : workers)
+        {
+            processTicks += worker->getProcessTicks();
+            cacheCounts.add(worker->getCacheCounts());
+        }
+
+        auto samplesPerInstance = static_cast<double>(numRounds) * settings.blockSize;
+        auto nsPerSample = juce::Time::highResolutionTicksToSeconds(processTicks) * 1.0e9 / (samplesPerInstance * numInstances);
+        auto load = wallSeconds / (samplesPerInstance / settings.sampleRate);
+
+        auto growth = (residentBefore < 0 || residentAfter < 0) ? juce::int64(-1) : residentAfter - residentBefore;
+
+        return juce::String(numInstances).paddedLeft(' ', 9)
+             + juce::String(constructMs / numInstances, 2).paddedLeft(' ', 13)
+             + juce::String(prepareMs / numInstances, 2).paddedLeft(' ', 12)
+             + formatMegabytes(growth).paddedLeft(' ', 12)
+             + (growth < 0 ? juce::String("n/a") : juce::String(static_cast<double>(growth) / 1024.0 / numInstances, 0) + " KB").paddedLeft(' ', 14)
+             + juce::String(nsPerSample, 1).paddedLeft(' ', 11)
+             + (juce::String(load * 100.0, 1) + "%").paddedLeft(' ', 10)
+             + cacheCounts.getMissRate(CacheCounts::l1Accesses, CacheCounts::l1Misses).paddedLeft(' ', 10)
+             + cacheCounts.getMissRate(CacheCounts::llAccesses, CacheCounts::llMisses).paddedLeft(' ', 10);
+    }
+}
+
+void run(const juce::ArgumentList& args)
+{
+    Settings settings;
+
+    if (args.containsOption("--counts"))
+    {
+        settings.counts.clear();
+
+        for (auto& count : juce::StringArray::fromTokens(args.getValueForOption("--counts"), ",", ""))
+            settings.counts.add(count.getIntValue());
+    }
+
+    if (args.containsOption("--threads"))
+        settings.numThreads = args.getValueForOption("--threads").getIntValue();
+
+    if (args.containsOption("--seconds"))
+        settings.seconds = args.getValueForOption("--seconds").getDoubleValue();
+
+    if (args.containsOption("--block-size"))
+        settings.blockSize = args.getValueForOption("--block-size").getIntValue();
+
+    if (args.containsOption("--rate"))
+        settings.sampleRate = args.getValueForOption("--rate").getDoubleValue();
+
+    if (settings.counts.isEmpty() || settings.counts.getFirst() <= 0 || settings.numThreads <= 0
+        || settings.seconds <= 0.0 || settings.blockSize <= 0 || settings.sampleRate <= 0.0)
+        juce::ConsoleApplication::fail("--counts, --threads, --seconds, --block-size and --rate must be positive");
+
+    juce::StringArray lines;
+    lines.add(juce::SystemStats::getCpuModel() + ", " + juce::String(juce::SystemStats::getNumCpus()) + " cores, "
+              + juce::SystemStats::getOperatingSystemName());
+    lines.add(juce::String(settings.blockSize) + " samples per block, " + juce::String(settings.sampleRate) + " Hz, "
+              + juce::String(settings.seconds) + " s per instance on " + juce::String(settings.numThreads) + " thread(s)");
+    lines.add("instances  construct ms  prepare ms         RSS  RSS/instance  ns/sample      load       L1D       LLC");
+
+    for (auto& line : lines)
+        std::cout << line << std::endl;
+
+    for (auto count : settings.counts)
+    {
+        if (count <= 0)
+            juce::ConsoleApplication::fail("--counts must be positive");
+
+        lines.add(runCount(count, settings));
+        std::cout << lines[lines.size() - 1] << std::endl;
+    }
+
+    if (args.containsOption("--record"))
+    {
+        auto file = args.getFileForOption("--record");
+
+        if (! file.replaceWithText(lines.joinIntoString("\n") + "\n"))
+            juce::ConsoleApplication::fail("Couldn't write " + file.getFullPathName());
+
+        std::cout << "Recorded the results in " << file.getFullPathName() << std::endl;
+    }
+}
+}
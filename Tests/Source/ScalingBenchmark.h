@@ -0,0 +1,50 @@
+/*
+  ==============================================================================
+
+    ScalingBenchmark.h
+
+    How construction time, memory, cache misses and processing cost per
+    instance change from one instance to a thousand.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "TestHost.h"
+
+/*
+    For each count N, N instances are constructed and prepared on the
+    message thread and played in real-time mode, with the test preset and
+    the default order. They are warmed up until the stage loader has
+    nothing left to prepare. Then the instances are shared round-robin
+    between --threads threads. Each thread plays its instances one block at
+    a time, in turn, like a host's track loop, for --seconds of audio per
+    instance.
+
+    Per count it reports:
+        construct, prepare  mean of getLoadTimes() over the instances
+        RSS                 growth from just before construction to after
+                            the run, in total and per instance
+        ns/sample           time in processBlock per sample frame, per instance
+        load                wall time of the run against the audio it played,
+                            per thread; over 100% would be dropouts
+        L1D, LLC misses     read misses per access, on the processing threads
+
+    The cache figures come from perf_event_open and so are Linux only, and
+    only where perf_event_paranoid allows it; otherwise they read n/a. There
+    is no generic perf event for L2, so the last level cache is given
+    instead. They include the host side copy of each block's input.
+
+    The counts run in the order given. Memory freed by one count may be
+    reused by the next, so give the counts in ascending order.
+
+    --record writes the table, headed by the CPU and the settings, to a
+    file, so a machine's results can be kept and compared with later runs.
+
+        scaling [--counts=1,10,100,1000] [--threads=<n>] [--seconds=<s>] [--block-size=<samples>] [--rate=<Hz>] [--record=<file>]
+*/
+namespace ScalingBenchmark
+{
+    void run(const juce::ArgumentList& args);
+}
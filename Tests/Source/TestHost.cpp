@@ -0,0 +1,192 @@
+/*
+  ==============================================================================
+
+    TestHost.cpp
+
+  ==============================================================================
+*/
+
+#include "TestHost.h"
+
+TestHost::TestHost(double newSampleRate, int newMaxBlockSize, bool offline, int newNumChannels)
+    : processor(std::make_unique<Processor>()),
+      sampleRate(newSampleRate),
+      maxBlockSize(newMaxBlockSize),
+      numChannels(newNumChannels)
+{
+    processor->setNonRealtime(offline);
+    processor->setPlayConfigDetails(numChannels, numChannels, sampleRate, maxBlockSize);
+    processor->prepareToPlay(sampleRate, maxBlockSize);
+}
+
+TestHost::~TestHost()
+{
+    processor->releaseResources();
+}
+
+void TestHost::setParameter(juce::RangedAudioParameter* parameter, float value)
+{
+    jassert(parameter != nullptr);
+    parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+}
+
+void TestHost::applyTestPreset()
+{
+    auto& p = *processor;
+
+    setParameter(p.delayTimeMs, 20.f);
+    setParameter(p.delayFeedbackPercent, 0.5f);
+    setParameter(p.delayMixPercent, 0.5f);
+    setParameter(p.reverbDecaySeconds, 0.5f);
+    setParameter(p.reverbMixPercent, 0.3f);
+    setParameter(p.chorusCenterDelayMs, 7.f);
+
+    // a peak band at 0 dB is skipped, so each band gets a gain of its own
+    constexpr std::array<float, Processor::numGeneralFilterBands> bandGainsDb{ 6.f, -4.f, 3.f, -6.f, 4.5f, -3.f, 2.f, -5.f };
+
+    for (size_t band = 0; band < bandGainsDb.size(); ++band)
+        setParameter(p.generalFilterBandGain[band], bandGainsDb[band]);
+
+    // the same quality whatever the processor's default, and no offline override
+    setParameter(p.qualityMode, static_cast<float>(QualityMode::Normal));
+    setParameter(p.offlineHighQuality, 0.f);
+}
+
+void TestHost::loadTestImpulseResponse()
+{
+    constexpr double lengthSeconds = 0.25;
+    auto length = juce::roundToInt(lengthSeconds * sampleRate);
+
+    juce::AudioBuffer<float> ir(2, length);
+    juce::Random random(0x1a5e);
+
+    for (int ch = 0; ch < ir.getNumChannels(); ++ch)
+        for (int i = 0; i < length; ++i)
+            ir.setSample(ch, i, (2.f * random.nextFloat() - 1.f) * std::exp(-6.f * static_cast<float>(i) / static_cast<float>(length)));
+
+    impulseResponseFile = std::make_unique<juce::TemporaryFile>(".wav");
+    auto file = impulseResponseFile->getFile();
+
+    {
+        auto stream = std::make_unique<juce::FileOutputStream>(file);
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer(wav.createWriterFor(stream.get(), sampleRate,
+            static_cast<unsigned int>(ir.getNumChannels()), 32, {}, 0));
+
+        jassert(writer != nullptr);
+
+        if (writer == nullptr)
+            return;
+
+        // the writer owns the stream now
+        stream.release();
+        writer->writeFromAudioSampleBuffer(ir, 0, length);
+    }
+
+    processor->loadImpulseResponse(file);
+}
+
+void TestHost::setOrder(const DSP_Order& order)
+{
+    processor->dsporderfifo.push(order);
+}
+
+void TestHost::setBypassMask(juce::uint32 mask)
+{
+    for (int i = 0; i < numStages; ++i)
+        setParameter(getBypassParameter(*processor, static_cast<DSP_Option>(i)), (mask >> i) & 1u ? 1.f : 0.f);
+}
+
+juce::AudioParameterBool* TestHost::getBypassParameter(Processor& p, DSP_Option option)
+{
+    switch (option)
+    {
+    case DSP_Option::Phase:         return p.phaserBypass;
+    case DSP_Option::Chorus:        return p.chorusBypass;
+    case DSP_Option::OverDrive:     return p.overdriveBypass;
+    case DSP_Option::LadderFilter:  return p.LadderFilterBypass;
+    case DSP_Option::GenralFilter:  return p.GeneralFilterBypass;
+    case DSP_Option::Delay:         return p.delayBypass;
+    case DSP_Option::Convolution:   return p.convolutionBypass;
+    case DSP_Option::Reverb:        return p.reverbBypass;
+    case DSP_Option::End_Of_List:   break;
+    }
+
+    jassertfalse;
+    return nullptr;
+}
+
+void TestHost::render(juce::AudioBuffer<float>& audio, int blockSize)
+{
+    for (int start = 0; start < audio.getNumSamples(); start += blockSize)
+    {
+        juce::AudioBuffer<float> block(audio.getArrayOfWritePointers(), audio.getNumChannels(),
+                                       start, juce::jmin(blockSize, audio.getNumSamples() - start));
+        process(block);
+    }
+}
+
+void TestHost::process(juce::AudioBuffer<float>& block)
+{
+    processor->processBlock(block, midi);
+    midi.clear();
+}
+
+juce::AudioBuffer<float> TestHost::makeTestSignal(int numSamples, double rate)
+{
+    juce::AudioBuffer<float> signal(2, numSamples);
+    signal.clear();
+
+    auto* left = signal.getWritePointer(0);
+    auto* right = signal.getWritePointer(1);
+
+    // phase of an exponential sweep, see Farina's swept-sine method
+    auto duration = numSamples / rate;
+    auto ratio = std::log(20000.0 / 20.0);
+    auto scale = juce::MathConstants<double>::twoPi * 20.0 * duration / ratio;
+    auto gain = juce::Decibels::decibelsToGain(-6.0);
+
+    for (int i = 1; i < numSamples; ++i)
+    {
+        auto t = i / rate;
+        left[i] = static_cast<float>(gain * std::sin(scale * (std::exp(t / duration * ratio) - 1.0)));
+    }
+
+    left[0] = 1.f;
+
+    juce::Random random(1234);
+    auto noiseGain = juce::Decibels::decibelsToGain(-12.f);
+
+    for (int i = 0; i < numSamples; ++i)
+        right[i] = noiseGain * (2.f * random.nextFloat() - 1.f);
+
+    return signal;
+}
+
+juce::String TestHost::getStageName(DSP_Option option)
+{
+    switch (option)
+    {
+    case DSP_Option::Phase:         return "Phaser";
+    case DSP_Option::Chorus:        return "Chorus";
+    case DSP_Option::OverDrive:     return "Overdrive";
+    case DSP_Option::LadderFilter:  return "Ladder";
+    case DSP_Option::GenralFilter:  return "Filter";
+    case DSP_Option::Delay:         return "Delay";
+    case DSP_Option::Convolution:   return "Convolution";
+    case DSP_Option::Reverb:        return "Reverb";
+    case DSP_Option::End_Of_List:   break;
+    }
+
+    return "-";
+}
+
+juce::String TestHost::describeOrder(const DSP_Order& order)
+{
+    juce::StringArray names;
+
+    for (auto option : order)
+        names.add(getStageName(option));
+
+    return names.joinIntoString(" > ");
+}
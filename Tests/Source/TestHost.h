@@ -0,0 +1,95 @@
+/*
+  ==============================================================================
+
+    TestHost.h
+
+    Drives one AudioPluginprojectAudioProcessor the way a host would, for
+    the test and benchmark commands in Main.cpp.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+
+/*
+    Everything goes through the processor's public interface: parameters
+    through their pointers, the order through dsporderfifo, exactly as the
+    editor and a host reach them. Nothing here is thread safe; the stress
+    test, which plays from one thread and automates from others, keeps to
+    what a host may do from each.
+*/
+class TestHost
+{
+public:
+    using Processor = AudioPluginprojectAudioProcessor;
+    using DSP_Option = Processor::DSP_Option;
+    using DSP_Order = Processor::DSP_Order;
+
+    static constexpr int numStages = static_cast<int>(DSP_Option::End_Of_List);
+
+    // offline: stages are prepared synchronously and the CPU governor is off, so renders are repeatable.
+    // numChannels is the width of the main input and output bus, 1 or 2.
+    TestHost(double sampleRate, int maxBlockSize, bool offline, int numChannels = 2);
+    ~TestHost();
+
+    Processor& getProcessor() noexcept { return *processor; }
+
+    double getSampleRate() const noexcept { return sampleRate; }
+    int getMaxBlockSize() const noexcept { return maxBlockSize; }
+    int getNumChannels() const noexcept { return numChannels; }
+
+    // in the parameter's own units, as the host would see them; the choice index for a choice
+    static void setParameter(juce::RangedAudioParameter* parameter, float value);
+
+    // short delay and reverb times and a boost or cut on every filter band, so every stage is heard inside a short render
+    void applyTestPreset();
+
+    /*
+        A fixed, seeded stereo IR - 0.25 s of decaying noise, long enough to
+        reach every section of ConvolutionEngine - written to a temporary
+        file and loaded, so the Convolution stage has something to do.
+        Offline it has been read when this returns; the stage still swaps it
+        in over its next few thousand samples of processing.
+    */
+    void loadTestImpulseResponse();
+
+    // picked up by the next processBlock, like an order from the editor
+    void setOrder(const DSP_Order& order);
+
+    // bit i bypasses stage i of DSP_Option
+    void setBypassMask(juce::uint32 mask);
+
+    static juce::AudioParameterBool* getBypassParameter(Processor& processor, DSP_Option option);
+
+    // processes audio in place in blocks of blockSize samples (the last one shorter)
+    void render(juce::AudioBuffer<float>& audio, int blockSize);
+
+    // one block, exactly as given
+    void process(juce::AudioBuffer<float>& block);
+
+    /*
+        Fixed, seeded stereo input: the left channel is an impulse followed by
+        an exponential sine sweep from 20 Hz to 20 kHz at -6 dBFS, the right
+        channel white noise at -12 dBFS.
+    */
+    static juce::AudioBuffer<float> makeTestSignal(int numSamples, double sampleRate);
+
+    static juce::String getStageName(DSP_Option option);
+    static juce::String describeOrder(const DSP_Order& order);
+
+private:
+    std::unique_ptr<Processor> processor;
+    juce::MidiBuffer midi;
+
+    double sampleRate;
+    int maxBlockSize;
+    int numChannels;
+
+    // kept for the processor's state, which refers to it
+    std::unique_ptr<juce::TemporaryFile> impulseResponseFile;
+
+    JUCE_DECLARE_NON_COPYABLE(TestHost)
+};